@@ -100,6 +100,8 @@ private:
     QString m_windowTitleForGlobal;
     WId m_windowForGlobal;
 
+    friend class TestSearchBenchmark;
+
     Q_DISABLE_COPY(AutoType)
 };
 
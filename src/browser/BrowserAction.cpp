@@ -17,9 +17,9 @@
  */
 
 #include "BrowserAction.h"
-#include "BrowserSettings.h"
 #include "NativeMessagingBase.h"
 #include "config-keepassx.h"
+#include "core/Tracing.h"
 
 #include <QJsonDocument>
 #include <QJsonParseError>
@@ -28,8 +28,7 @@
 #include <sodium/randombytes.h>
 
 BrowserAction::BrowserAction(BrowserService& browserService)
-    : m_mutex(QMutex::Recursive)
-    , m_browserService(browserService)
+    : m_browserService(browserService)
     , m_associated(false)
 {
 }
@@ -51,8 +50,7 @@ QJsonObject BrowserAction::readResponse(const QJsonObject& json)
         return getErrorReply(action, ERROR_KEEPASS_INCORRECT_ACTION);
     }
 
-    QMutexLocker locker(&m_mutex);
-    if (action.compare("change-public-keys", Qt::CaseSensitive) != 0 && !m_browserService.isDatabaseOpened()) {
+    if (action.compare("change-public-keys", Qt::CaseSensitive) != 0 && !m_browserService.snapshot()->databaseOpened) {
         if (m_clientPublicKey.isEmpty()) {
             return getErrorReply(action, ERROR_KEEPASS_CLIENT_PUBLIC_KEY_NOT_RECEIVED);
         } else if (!m_browserService.openDatabase(triggerUnlock)) {
@@ -69,6 +67,7 @@ QJsonObject BrowserAction::readResponse(const QJsonObject& json)
 QJsonObject BrowserAction::handleAction(const QJsonObject& json)
 {
     QString action = json.value("action").toString();
+    TRACE_SPAN(QString("BrowserAction %1").arg(action), "browser");
 
     if (action.compare("change-public-keys", Qt::CaseSensitive) == 0) {
         return handleChangePublicKeys(json, action);
@@ -98,7 +97,6 @@ QJsonObject BrowserAction::handleAction(const QJsonObject& json)
 
 QJsonObject BrowserAction::handleChangePublicKeys(const QJsonObject& json, const QString& action)
 {
-    QMutexLocker locker(&m_mutex);
     const QString nonce = json.value("nonce").toString();
     const QString clientPublicKey = json.value("publicKey").toString();
 
@@ -181,7 +179,6 @@ QJsonObject BrowserAction::handleAssociate(const QJsonObject& json, const QStrin
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
     }
 
-    QMutexLocker locker(&m_mutex);
     if (key.compare(m_clientPublicKey, Qt::CaseSensitive) == 0) {
         // Check for identification key. If it's not found, ensure backwards compatibility and use the current public
         // key
@@ -220,7 +217,6 @@ QJsonObject BrowserAction::handleTestAssociate(const QJsonObject& json, const QS
         return getErrorReply(action, ERROR_KEEPASS_DATABASE_NOT_OPENED);
     }
 
-    QMutexLocker locker(&m_mutex);
     const QString key = m_browserService.getKey(id);
     if (key.isEmpty() || key.compare(responseKey, Qt::CaseSensitive) != 0) {
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
@@ -242,7 +238,6 @@ QJsonObject BrowserAction::handleGetLogins(const QJsonObject& json, const QStrin
     const QString nonce = json.value("nonce").toString();
     const QString encrypted = json.value("message").toString();
 
-    QMutexLocker locker(&m_mutex);
     if (!m_associated) {
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
     }
@@ -289,7 +284,7 @@ QJsonObject BrowserAction::handleGetLogins(const QJsonObject& json, const QStrin
 QJsonObject BrowserAction::handleGeneratePassword(const QJsonObject& json, const QString& action)
 {
     auto nonce = json.value("nonce").toString();
-    auto password = browserSettings()->generatePassword();
+    auto password = m_browserService.generatePassword();
 
     if (nonce.isEmpty() || password.isEmpty()) {
         return QJsonObject();
@@ -315,7 +310,6 @@ QJsonObject BrowserAction::handleSetLogin(const QJsonObject& json, const QString
     const QString nonce = json.value("nonce").toString();
     const QString encrypted = json.value("message").toString();
 
-    QMutexLocker locker(&m_mutex);
     if (!m_associated) {
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
     }
@@ -374,7 +368,6 @@ QJsonObject BrowserAction::handleLockDatabase(const QJsonObject& json, const QSt
 
     QString command = decrypted.value("action").toString();
     if (!command.isEmpty() && command.compare("lock-database", Qt::CaseSensitive) == 0) {
-        QMutexLocker locker(&m_mutex);
         m_browserService.lockDatabase();
 
         const QString newNonce = incrementNonce(nonce);
@@ -392,7 +385,6 @@ QJsonObject BrowserAction::handleGetDatabaseGroups(const QJsonObject& json, cons
     const QString nonce = json.value("nonce").toString();
     const QString encrypted = json.value("message").toString();
 
-    QMutexLocker locker(&m_mutex);
     if (!m_associated) {
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
     }
@@ -426,7 +418,6 @@ QJsonObject BrowserAction::handleCreateNewGroup(const QJsonObject& json, const Q
     const QString nonce = json.value("nonce").toString();
     const QString encrypted = json.value("message").toString();
 
-    QMutexLocker locker(&m_mutex);
     if (!m_associated) {
         return getErrorReply(action, ERROR_KEEPASS_ASSOCIATION_FAILED);
     }
@@ -539,20 +530,18 @@ QString BrowserAction::getReturnValue(const BrowserService::ReturnValue returnVa
 
 QString BrowserAction::getDatabaseHash()
 {
-    QMutexLocker locker(&m_mutex);
-    QByteArray hash =
-        QCryptographicHash::hash(m_browserService.getDatabaseRootUuid().toUtf8(), QCryptographicHash::Sha256).toHex();
+    const auto currentDatabase = m_browserService.snapshot()->currentDatabase;
+    const QString rootUuid = currentDatabase ? currentDatabase->rootGroupUuid() : QString();
+    QByteArray hash = QCryptographicHash::hash(rootUuid.toUtf8(), QCryptographicHash::Sha256).toHex();
     return QString(hash);
 }
 
 QString BrowserAction::getLegacyDatabaseHash()
 {
-    QMutexLocker locker(&m_mutex);
-    QByteArray hash =
-        QCryptographicHash::hash(
-            (m_browserService.getDatabaseRootUuid() + m_browserService.getDatabaseRecycleBinUuid()).toUtf8(),
-            QCryptographicHash::Sha256)
-            .toHex();
+    const auto currentDatabase = m_browserService.snapshot()->currentDatabase;
+    const QString uuids =
+        currentDatabase ? currentDatabase->rootGroupUuid() + currentDatabase->recycleBinUuid() : QString();
+    QByteArray hash = QCryptographicHash::hash(uuids.toUtf8(), QCryptographicHash::Sha256).toHex();
     return QString(hash);
 }
 
@@ -586,7 +575,6 @@ QJsonObject BrowserAction::decryptMessage(const QString& message, const QString&
 
 QString BrowserAction::encrypt(const QString& plaintext, const QString& nonce)
 {
-    QMutexLocker locker(&m_mutex);
     const QByteArray ma = plaintext.toUtf8();
     const QByteArray na = base64Decode(nonce);
     const QByteArray ca = base64Decode(m_clientPublicKey);
@@ -614,7 +602,6 @@ QString BrowserAction::encrypt(const QString& plaintext, const QString& nonce)
 
 QByteArray BrowserAction::decrypt(const QString& encrypted, const QString& nonce)
 {
-    QMutexLocker locker(&m_mutex);
     const QByteArray ma = base64Decode(encrypted);
     const QByteArray na = base64Decode(nonce);
     const QByteArray ca = base64Decode(m_clientPublicKey);
@@ -21,10 +21,17 @@
 
 #include "BrowserService.h"
 #include <QJsonObject>
-#include <QMutex>
 #include <QObject>
 #include <QtCore>
 
+/**
+ * Handles the requests of a single browser client.
+ *
+ * Requests are handled on a worker thread, BrowserClients guarantees that
+ * only one request of a client is handled at a time and in the order received.
+ * Database access goes through BrowserService, which reads from a snapshot and
+ * only calls into the GUI thread for modifications and user interaction.
+ */
 class BrowserAction : public QObject
 {
     Q_OBJECT
@@ -90,7 +97,6 @@ private:
     QString incrementNonce(const QString& nonce);
 
 private:
-    QMutex m_mutex;
     BrowserService& m_browserService;
     QString m_clientPublicKey;
     QString m_publicKey;
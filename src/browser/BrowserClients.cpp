@@ -17,30 +17,86 @@
  */
 
 #include "BrowserClients.h"
+#include "core/Global.h"
+#include <QCoreApplication>
 #include <QJsonParseError>
 #include <QJsonValue>
+#include <QtConcurrent>
 
-BrowserClients::BrowserClients(BrowserService& browserService)
-    : m_mutex(QMutex::Recursive)
+BrowserClients::BrowserClients(BrowserService& browserService, QObject* parent)
+    : QObject(parent)
+    , m_mutex(QMutex::Recursive)
     , m_browserService(browserService)
 {
     m_clients.reserve(1000);
 }
 
-QJsonObject BrowserClients::readResponse(const QByteArray& arr)
+BrowserClients::~BrowserClients()
+{
+    clearRequests();
+
+    // Running requests may wait for the GUI thread, keep serving it until they are done
+    while (!m_threadPool.waitForDone(10)) {
+        QCoreApplication::processEvents();
+    }
+}
+
+/**
+ * Queue a request for its client and handle it on the thread pool.
+ * responseReady() is emitted with socket once the request was handled,
+ * requests without a client are answered immediately with an empty response.
+ *
+ * @param arr raw JSON message
+ * @param socket connection the response belongs to, nullptr for stdio
+ */
+void BrowserClients::queueRequest(const QByteArray& arr, QLocalSocket* socket)
 {
-    QJsonObject json;
     const QJsonObject message = byteArrayToJson(arr);
     const QString clientID = getClientID(message);
+    if (clientID.isEmpty()) {
+        emit responseReady(socket, QJsonObject());
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    const ClientPtr client = getClient(clientID);
+    client->requests.enqueue({message, socket});
+    if (!client->active) {
+        client->active = true;
+        QtConcurrent::run(&m_threadPool, [this, client] { processRequests(client); });
+    }
+}
+
+/**
+ * Drop all requests that were not started yet.
+ */
+void BrowserClients::clearRequests()
+{
+    QMutexLocker locker(&m_mutex);
+    for (const auto& client : asConst(m_clients)) {
+        client->requests.clear();
+    }
+}
+
+void BrowserClients::processRequests(ClientPtr client)
+{
+    while (true) {
+        Request request;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (client->requests.isEmpty()) {
+                client->active = false;
+                return;
+            }
+            request = client->requests.dequeue();
+        }
 
-    if (!clientID.isEmpty()) {
-        const ClientPtr client = getClient(clientID);
+        QJsonObject json;
         if (client->browserAction) {
-            json = client->browserAction->readResponse(message);
+            json = client->browserAction->readResponse(request.message);
         }
+        emit responseReady(request.socket, json);
     }
-
-    return json;
 }
 
 QJsonObject BrowserClients::byteArrayToJson(const QByteArray& arr) const
@@ -23,39 +23,65 @@
 #include <QJsonObject>
 #include <QLocalSocket>
 #include <QMutex>
+#include <QQueue>
 #include <QSharedPointer>
+#include <QThreadPool>
 #include <QVector>
 
-class BrowserClients
+/**
+ * Dispatches browser requests to the BrowserAction of their client.
+ *
+ * Requests are handled on a thread pool. Requests of different clients run
+ * concurrently while the requests of a single client are handled one after
+ * another in the order they were queued.
+ */
+class BrowserClients : public QObject
 {
+    Q_OBJECT
+
+    struct Request
+    {
+        QJsonObject message;
+        QLocalSocket* socket;
+    };
+
     struct Client
     {
         Client(const QString& id, QSharedPointer<BrowserAction> ba)
             : clientID(id)
             , browserAction(ba)
+            , active(false)
         {
         }
         QString clientID;
         QSharedPointer<BrowserAction> browserAction;
+        QQueue<Request> requests;
+        bool active;
     };
 
     typedef QSharedPointer<Client> ClientPtr;
 
 public:
-    BrowserClients(BrowserService& browserService);
-    ~BrowserClients() = default;
+    explicit BrowserClients(BrowserService& browserService, QObject* parent = nullptr);
+    ~BrowserClients() override;
+
+    void queueRequest(const QByteArray& arr, QLocalSocket* socket = nullptr);
+    void clearRequests();
 
-    QJsonObject readResponse(const QByteArray& arr);
+signals:
+    void responseReady(QLocalSocket* socket, const QJsonObject& json);
 
 private:
     QJsonObject byteArrayToJson(const QByteArray& arr) const;
     QString getClientID(const QJsonObject& json) const;
     ClientPtr getClient(const QString& clientID);
+    void processRequests(ClientPtr client);
 
 private:
     QMutex m_mutex;
     QVector<ClientPtr> m_clients;
     BrowserService& m_browserService;
+    QThreadPool m_threadPool;
 };
 
 #endif // BROWSERCLIENTS_H
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BrowserDatabaseView.h"
+#include "BrowserService.h"
+
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "core/Metadata.h"
+
+/**
+ * Copy the searchable entries and the browser keys of db.
+ * Entries in the recycle bin or in groups excluded from searching are skipped.
+ */
+BrowserDatabaseView::BrowserDatabaseView(const QSharedPointer<Database>& db)
+{
+    if (!db || !db->rootGroup()) {
+        return;
+    }
+
+    m_rootGroupUuid = db->rootGroup()->uuidToHex();
+    if (Group* recycleBin = db->metadata()->recycleBin()) {
+        m_recycleBinUuid = recycleBin->uuidToHex();
+    }
+
+    const CustomData* customData = db->metadata()->customData();
+    for (const QString& key : customData->keys()) {
+        if (key.startsWith(BrowserService::ASSOCIATE_KEY_PREFIX)) {
+            m_keys.insert(key.mid(BrowserService::ASSOCIATE_KEY_PREFIX.length()), customData->value(key));
+        }
+    }
+
+    for (auto* group : db->rootGroup()->groupsRecursive(true)) {
+        if (group->isRecycled() || !group->resolveSearchingEnabled()) {
+            continue;
+        }
+
+        for (auto* entry : group->entries()) {
+            if (entry->isRecycled()) {
+                continue;
+            }
+
+            EntryData data;
+            data.entry = entry;
+            data.url = entry->url();
+
+            // Additional URLs are only considered if the plain KP2A_URL attribute exists
+            const QList<QString> keys = entry->attributes()->keys();
+            if (keys.contains(BrowserService::ADDITIONAL_URL)) {
+                for (const QString& key : keys) {
+                    if (key.startsWith(BrowserService::ADDITIONAL_URL)) {
+                        data.additionalUrls.append(entry->attributes()->value(key));
+                    }
+                }
+            }
+
+            m_entries.append(data);
+        }
+    }
+}
+
+QString BrowserDatabaseView::rootGroupUuid() const
+{
+    return m_rootGroupUuid;
+}
+
+QString BrowserDatabaseView::recycleBinUuid() const
+{
+    return m_recycleBinUuid;
+}
+
+/**
+ * @param id name the connection was stored with
+ * @return public key of the connection or an empty string if unknown
+ */
+QString BrowserDatabaseView::key(const QString& id) const
+{
+    return m_keys.value(id);
+}
+
+const QVector<BrowserDatabaseView::EntryData>& BrowserDatabaseView::entries() const
+{
+    return m_entries;
+}
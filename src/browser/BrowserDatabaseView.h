@@ -0,0 +1,63 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BROWSERDATABASEVIEW_H
+#define BROWSERDATABASEVIEW_H
+
+#include <QHash>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class Database;
+class Entry;
+
+/**
+ * Immutable copy of the parts of a database that browser requests are
+ * matched against. A view is created on the GUI thread and may then be
+ * read from any thread while the database itself keeps changing.
+ *
+ * Entries are only referenced through guarded pointers, they must not be
+ * dereferenced outside of the GUI thread.
+ */
+class BrowserDatabaseView
+{
+public:
+    struct EntryData
+    {
+        QPointer<Entry> entry;
+        QString url;
+        QStringList additionalUrls;
+    };
+
+    explicit BrowserDatabaseView(const QSharedPointer<Database>& db);
+
+    QString rootGroupUuid() const;
+    QString recycleBinUuid() const;
+    QString key(const QString& id) const;
+    const QVector<EntryData>& entries() const;
+
+private:
+    QString m_rootGroupUuid;
+    QString m_recycleBinUuid;
+    QHash<QString, QString> m_keys;
+    QVector<EntryData> m_entries;
+};
+
+#endif // BROWSERDATABASEVIEW_H
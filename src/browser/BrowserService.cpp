@@ -30,12 +30,14 @@
 #include "BrowserEntrySaveDialog.h"
 #include "BrowserService.h"
 #include "BrowserSettings.h"
+#include "core/Config.h"
 #include "core/Database.h"
 #include "core/EntrySearcher.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
 #include "core/PasswordGenerator.h"
 #include "core/Tools.h"
+#include "core/Tracing.h"
 #include "gui/MainWindow.h"
 #include "gui/MessageBox.h"
 #ifdef Q_OS_MACOS
@@ -63,9 +65,18 @@ BrowserService::BrowserService(DatabaseTabWidget* parent)
     , m_bringToFrontRequested(false)
     , m_prevWindowState(WindowState::Normal)
     , m_keepassBrowserUUID(Tools::hexToUuid("de887cc3036343b8974b5911b8816224"))
+    , m_snapshotStale(true)
 {
+    // Requests are handled on worker threads which call into the GUI thread with these types
+    qRegisterMetaType<QSharedPointer<Database>>();
+    qRegisterMetaType<QList<QPointer<Entry>>>();
+
+    connect(config(), SIGNAL(changed(QString)), this, SLOT(invalidateSnapshot()));
+
     // Don't connect the signals when used from DatabaseSettingsWidgetBrowser (parent is nullptr)
     if (m_dbTabWidget) {
+        connect(m_dbTabWidget, SIGNAL(databaseOpened(DatabaseWidget*)), this, SLOT(invalidateSnapshot()));
+        connect(m_dbTabWidget, SIGNAL(databaseClosed(QString)), this, SLOT(invalidateSnapshot()));
         connect(m_dbTabWidget, SIGNAL(databaseLocked(DatabaseWidget*)), this, SLOT(databaseLocked(DatabaseWidget*)));
         connect(
             m_dbTabWidget, SIGNAL(databaseUnlocked(DatabaseWidget*)), this, SLOT(databaseUnlocked(DatabaseWidget*)));
@@ -89,6 +100,16 @@ bool BrowserService::isDatabaseOpened() const
 
 bool BrowserService::openDatabase(bool triggerUnlock)
 {
+    if (thread() != QThread::currentThread()) {
+        bool result = false;
+        QMetaObject::invokeMethod(this,
+                                  "openDatabase",
+                                  Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(bool, result),
+                                  Q_ARG(bool, triggerUnlock));
+        return result;
+    }
+
     if (!browserSettings()->unlockDatabase()) {
         return false;
     }
@@ -115,6 +136,7 @@ void BrowserService::lockDatabase()
 {
     if (thread() != QThread::currentThread()) {
         QMetaObject::invokeMethod(this, "lockDatabase", Qt::BlockingQueuedConnection);
+        return;
     }
 
     DatabaseWidget* dbWidget = m_dbTabWidget->currentDatabaseWidget();
@@ -181,6 +203,16 @@ QJsonArray BrowserService::getChildrenFromGroup(Group* group)
 
 QJsonObject BrowserService::getDatabaseGroups(const QSharedPointer<Database>& selectedDb)
 {
+    if (thread() != QThread::currentThread()) {
+        QJsonObject result;
+        QMetaObject::invokeMethod(this,
+                                  "getDatabaseGroups",
+                                  Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(QJsonObject, result),
+                                  Q_ARG(QSharedPointer<Database>, selectedDb));
+        return result;
+    }
+
     auto db = selectedDb ? selectedDb : getDatabase();
     if (!db) {
         return {};
@@ -283,6 +315,22 @@ QJsonObject BrowserService::createNewGroup(const QString& groupName)
     return result;
 }
 
+/**
+ * Generate a password with the browser password generator settings.
+ * The generator is shared, so this always runs on the GUI thread.
+ */
+QJsonObject BrowserService::generatePassword()
+{
+    if (thread() != QThread::currentThread()) {
+        QJsonObject result;
+        QMetaObject::invokeMethod(
+            this, "generatePassword", Qt::BlockingQueuedConnection, Q_RETURN_ARG(QJsonObject, result));
+        return result;
+    }
+
+    return browserSettings()->generatePassword();
+}
+
 QString BrowserService::storeKey(const QString& key)
 {
     QString id;
@@ -342,32 +390,53 @@ QString BrowserService::storeKey(const QString& key)
 
 QString BrowserService::getKey(const QString& id)
 {
-    auto db = getDatabase();
-    if (!db) {
+    const auto currentDatabase = snapshot()->currentDatabase;
+    if (!currentDatabase) {
         return {};
     }
 
-    return db->metadata()->customData()->value(ASSOCIATE_KEY_PREFIX + id);
+    return currentDatabase->key(id);
 }
 
+/**
+ * Find the entries matching url in the connected databases.
+ *
+ * The databases are searched on the calling thread against a snapshot, only
+ * the matches are handed to the GUI thread for access checks and confirmation.
+ */
 QJsonArray BrowserService::findMatchingEntries(const QString& id,
                                                const QString& url,
                                                const QString& submitUrl,
                                                const QString& realm,
                                                const StringPairList& keyList,
                                                const bool httpAuth)
+{
+    Q_UNUSED(id);
+
+    const QList<QPointer<Entry>> entries = searchEntries(*snapshot(), url, keyList);
+    if (entries.isEmpty()) {
+        return QJsonArray();
+    }
+
+    return prepareMatchingEntries(entries, url, submitUrl, realm, httpAuth);
+}
+
+QJsonArray BrowserService::prepareMatchingEntries(const QList<QPointer<Entry>>& entries,
+                                                  const QString& url,
+                                                  const QString& submitUrl,
+                                                  const QString& realm,
+                                                  const bool httpAuth)
 {
     QJsonArray result;
     if (thread() != QThread::currentThread()) {
         QMetaObject::invokeMethod(this,
-                                  "findMatchingEntries",
+                                  "prepareMatchingEntries",
                                   Qt::BlockingQueuedConnection,
                                   Q_RETURN_ARG(QJsonArray, result),
-                                  Q_ARG(QString, id),
+                                  Q_ARG(QList<QPointer<Entry>>, entries),
                                   Q_ARG(QString, url),
                                   Q_ARG(QString, submitUrl),
                                   Q_ARG(QString, realm),
-                                  Q_ARG(StringPairList, keyList),
                                   Q_ARG(bool, httpAuth));
         return result;
     }
@@ -380,7 +449,12 @@ QJsonArray BrowserService::findMatchingEntries(const QString& id,
     // Check entries for authorization
     QList<Entry*> pwEntriesToConfirm;
     QList<Entry*> pwEntries;
-    for (auto* entry : searchEntries(url, keyList)) {
+    for (const auto& entry : entries) {
+        // The database may have changed since the snapshot was taken
+        if (!entry || entry->isRecycled()) {
+            continue;
+        }
+
         if (entry->customData()->contains(BrowserService::OPTION_HIDE_ENTRY)
             && entry->customData()->value(BrowserService::OPTION_HIDE_ENTRY) == "true") {
             continue;
@@ -458,6 +532,7 @@ void BrowserService::addEntry(const QString& id,
                                   Q_ARG(QString, group),
                                   Q_ARG(QString, groupUuid),
                                   Q_ARG(QSharedPointer<Database>, selectedDb));
+        return;
     }
 
     auto db = selectedDb ? selectedDb : selectedDatabase();
@@ -520,6 +595,7 @@ BrowserService::ReturnValue BrowserService::updateEntry(const QString& id,
                                   Q_ARG(QString, password),
                                   Q_ARG(QString, url),
                                   Q_ARG(QString, submitUrl));
+        return result;
     }
 
     auto db = selectedDatabase();
@@ -586,51 +662,24 @@ QList<Entry*>
 BrowserService::searchEntries(const QSharedPointer<Database>& db, const QString& hostname, const QString& url)
 {
     QList<Entry*> entries;
-    auto* rootGroup = db->rootGroup();
-    if (!rootGroup) {
-        return entries;
-    }
-
-    for (const auto& group : rootGroup->groupsRecursive(true)) {
-        if (group->isRecycled() || !group->resolveSearchingEnabled()) {
-            continue;
-        }
-
-        for (auto* entry : group->entries()) {
-            if (entry->isRecycled()) {
-                continue;
-            }
-
-            auto domain = baseDomain(hostname);
-
-            // Search for additional URL's starting with KP2A_URL
-            if (entry->attributes()->keys().contains(ADDITIONAL_URL)) {
-                for (const auto& key : entry->attributes()->keys()) {
-                    if (key.startsWith(ADDITIONAL_URL)
-                        && handleURL(entry->attributes()->value(key), domain, url)) {
-                        entries.append(entry);
-                        continue;
-                    }
-                }
-            }
-
-            if (!handleURL(entry->url(), domain, url)) {
-                continue;
-            }
-
-            entries.append(entry);
-        }
+    const BrowserDatabaseView view(db);
+    for (const auto& entry : searchEntries(view, hostname, url, browserSettings()->matchUrlScheme())) {
+        entries.append(entry.data());
     }
-
     return entries;
 }
 
-QList<Entry*> BrowserService::searchEntries(const QString& url, const StringPairList& keyList)
+/**
+ * Search the databases of snapshot that are connected with one of the keys in keyList.
+ * Only the snapshot is accessed, so this may be called from any thread.
+ */
+QList<QPointer<Entry>>
+BrowserService::searchEntries(const Snapshot& snapshot, const QString& url, const StringPairList& keyList)
 {
     // Check if database is connected with KeePassXC-Browser
-    auto databaseConnected = [&](const QSharedPointer<Database>& db) {
+    auto databaseConnected = [&](const BrowserDatabaseView& view) {
         for (const StringPair& keyPair : keyList) {
-            QString key = db->metadata()->customData()->value(ASSOCIATE_KEY_PREFIX + keyPair.first);
+            QString key = view.key(keyPair.first);
             if (!key.isEmpty() && keyPair.second == key) {
                 return true;
             }
@@ -639,36 +688,51 @@ QList<Entry*> BrowserService::searchEntries(const QString& url, const StringPair
     };
 
     // Get the list of databases to search
-    QList<QSharedPointer<Database>> databases;
-    if (browserSettings()->searchInAllDatabases()) {
-        const int count = m_dbTabWidget->count();
-        for (int i = 0; i < count; ++i) {
-            if (auto* dbWidget = qobject_cast<DatabaseWidget*>(m_dbTabWidget->widget(i))) {
-                if (const auto& db = dbWidget->database()) {
-                    if (databaseConnected(db)) {
-                        databases << db;
-                    }
-                }
-            }
-        }
-    } else if (const auto& db = getDatabase()) {
-        if (databaseConnected(db)) {
-            databases << db;
+    QList<QSharedPointer<const BrowserDatabaseView>> databases;
+    for (const auto& view : snapshot.searchDatabases) {
+        if (databaseConnected(*view)) {
+            databases << view;
         }
     }
 
     // Search entries matching the hostname
     QString hostname = QUrl(url).host();
-    QList<Entry*> entries;
+    QList<QPointer<Entry>> entries;
     do {
-        for (const auto& db : databases) {
-            entries << searchEntries(db, hostname, url);
+        for (const auto& view : databases) {
+            entries << searchEntries(*view, hostname, url, snapshot.matchUrlScheme);
         }
     } while (entries.isEmpty() && removeFirstDomain(hostname));
 
     return entries;
 }
 
+QList<QPointer<Entry>> BrowserService::searchEntries(const BrowserDatabaseView& view,
+                                                     const QString& hostname,
+                                                     const QString& url,
+                                                     const bool matchUrlScheme)
+{
+    QList<QPointer<Entry>> entries;
+    const auto domain = baseDomain(hostname);
+
+    for (const auto& data : view.entries()) {
+        // Search for additional URL's starting with KP2A_URL
+        for (const auto& additionalUrl : data.additionalUrls) {
+            if (handleURL(additionalUrl, domain, url, matchUrlScheme)) {
+                entries.append(data.entry);
+            }
+        }
+
+        if (!handleURL(data.url, domain, url, matchUrlScheme)) {
+            continue;
+        }
+
+        entries.append(data.entry);
+    }
+
+    return entries;
+}
+
 void BrowserService::convertAttributesToCustomData(const QSharedPointer<Database>& currentDb)
 {
     auto db = currentDb ? currentDb : getDatabase();
@@ -682,8 +746,10 @@ void BrowserService::convertAttributesToCustomData(const QSharedPointer<Database
 
     int counter = 0;
     int keyCounter = 0;
+    db->beginUpdate();
     for (auto* entry : entries) {
         if (progress.wasCanceled()) {
+            db->endUpdate();
             return;
         }
 
@@ -706,6 +772,7 @@ void BrowserService::convertAttributesToCustomData(const QSharedPointer<Database
 
         progress.setValue(progress.value() + 1);
     }
+    db->endUpdate();
     progress.reset();
 
     if (counter > 0) {
@@ -1000,7 +1067,10 @@ bool BrowserService::removeFirstDomain(QString& hostname)
     return false;
 }
 
-bool BrowserService::handleURL(const QString& entryUrl, const QString& hostname, const QString& url)
+bool BrowserService::handleURL(const QString& entryUrl,
+                               const QString& hostname,
+                               const QString& url,
+                               const bool matchUrlScheme)
 {
     if (entryUrl.isEmpty()) {
         return false;
@@ -1012,13 +1082,13 @@ bool BrowserService::handleURL(const QString& entryUrl, const QString& hostname,
     } else {
         entryQUrl = QUrl::fromUserInput(entryUrl);
 
-        if (browserSettings()->matchUrlScheme()) {
+        if (matchUrlScheme) {
             entryQUrl.setScheme("https");
         }
     }
 
     // URL host validation fails
-    if (browserSettings()->matchUrlScheme() && entryQUrl.host().isEmpty()) {
+    if (matchUrlScheme && entryQUrl.host().isEmpty()) {
         return false;
     }
 
@@ -1029,7 +1099,7 @@ bool BrowserService::handleURL(const QString& entryUrl, const QString& hostname,
     }
 
     // Match scheme
-    if (browserSettings()->matchUrlScheme() && !entryQUrl.scheme().isEmpty() && entryQUrl.scheme().compare(qUrl.scheme()) != 0) {
+    if (matchUrlScheme && !entryQUrl.scheme().isEmpty() && entryQUrl.scheme().compare(qUrl.scheme()) != 0) {
         return false;
     }
 
@@ -1087,6 +1157,93 @@ QSharedPointer<Database> BrowserService::getDatabase()
     return {};
 }
 
+/**
+ * Get the current snapshot of the open databases, it is rebuilt on the
+ * GUI thread if a database changed since the last call.
+ * May be called from any thread.
+ */
+QSharedPointer<const BrowserService::Snapshot> BrowserService::snapshot()
+{
+    {
+        QMutexLocker locker(&m_snapshotMutex);
+        if (m_snapshot && !m_snapshotStale) {
+            return m_snapshot;
+        }
+    }
+
+    if (thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, "updateSnapshot", Qt::BlockingQueuedConnection);
+    } else {
+        updateSnapshot();
+    }
+
+    QMutexLocker locker(&m_snapshotMutex);
+    return m_snapshot;
+}
+
+void BrowserService::updateSnapshot()
+{
+    auto snapshot = QSharedPointer<Snapshot>::create();
+    if (m_dbTabWidget) {
+        snapshot->databaseOpened = isDatabaseOpened();
+        snapshot->matchUrlScheme = browserSettings()->matchUrlScheme();
+        snapshot->currentDatabase = databaseView(getDatabase());
+
+        if (browserSettings()->searchInAllDatabases()) {
+            const int count = m_dbTabWidget->count();
+            for (int i = 0; i < count; ++i) {
+                if (auto* dbWidget = qobject_cast<DatabaseWidget*>(m_dbTabWidget->widget(i))) {
+                    if (const auto& view = databaseView(dbWidget->database())) {
+                        snapshot->searchDatabases << view;
+                    }
+                }
+            }
+        } else if (snapshot->currentDatabase) {
+            snapshot->searchDatabases << snapshot->currentDatabase;
+        }
+    }
+
+    QMutexLocker locker(&m_snapshotMutex);
+    m_snapshot = snapshot;
+    m_snapshotStale = false;
+}
+
+void BrowserService::invalidateSnapshot()
+{
+    QMutexLocker locker(&m_snapshotMutex);
+    m_snapshotStale = true;
+}
+
+void BrowserService::databaseViewChanged()
+{
+    m_databaseViews.remove(sender());
+    invalidateSnapshot();
+}
+
+/**
+ * Get the cached view of db, the view is dropped as soon as db is modified.
+ */
+QSharedPointer<const BrowserDatabaseView> BrowserService::databaseView(const QSharedPointer<Database>& db)
+{
+    if (!db) {
+        return {};
+    }
+
+    auto view = m_databaseViews.value(db.data());
+    if (!view) {
+        view.reset(new BrowserDatabaseView(db));
+        m_databaseViews.insert(db.data(), view);
+        connect(db.data(),
+                SIGNAL(databaseModifiedImmediate()),
+                this,
+                SLOT(databaseViewChanged()),
+                Qt::UniqueConnection);
+        connect(db.data(), SIGNAL(destroyed(QObject*)), this, SLOT(databaseViewChanged()), Qt::UniqueConnection);
+    }
+
+    return view;
+}
+
 QSharedPointer<Database> BrowserService::selectedDatabase()
 {
     QList<DatabaseWidget*> databaseWidgets;
@@ -1249,6 +1406,9 @@ void BrowserService::raiseWindow(const bool force)
 
 void BrowserService::databaseLocked(DatabaseWidget* dbWidget)
 {
+    // The data of a locked database is released without modifying it
+    m_databaseViews.clear();
+    invalidateSnapshot();
     if (dbWidget) {
         emit databaseLocked();
     }
@@ -1256,6 +1416,9 @@ void BrowserService::databaseLocked(DatabaseWidget* dbWidget)
 
 void BrowserService::databaseUnlocked(DatabaseWidget* dbWidget)
 {
+    TRACE_SPAN("BrowserService::databaseUnlocked", "plugins,browser");
+    m_databaseViews.clear();
+    invalidateSnapshot();
     if (dbWidget) {
         if (m_bringToFrontRequested) {
             hideWindow();
@@ -1271,6 +1434,7 @@ void BrowserService::databaseUnlocked(DatabaseWidget* dbWidget)
 
 void BrowserService::activateDatabaseChanged(DatabaseWidget* dbWidget)
 {
+    invalidateSnapshot();
     if (dbWidget) {
         auto currentMode = dbWidget->currentMode();
         if (currentMode == DatabaseWidget::Mode::ViewMode || currentMode == DatabaseWidget::Mode::EditMode) {
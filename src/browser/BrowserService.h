@@ -20,8 +20,10 @@
 #ifndef BROWSERSERVICE_H
 #define BROWSERSERVICE_H
 
+#include "BrowserDatabaseView.h"
 #include "core/Entry.h"
 #include "gui/DatabaseTabWidget.h"
+#include <QMutex>
 #include <QObject>
 #include <QtCore>
 
@@ -45,26 +47,27 @@ public:
         Canceled
     };
 
+    /**
+     * Read-consistent state of the open databases that browser requests are
+     * answered from. A snapshot is never modified and may be used on any thread.
+     */
+    struct Snapshot
+    {
+        bool databaseOpened = false;
+        bool matchUrlScheme = false;
+        QSharedPointer<const BrowserDatabaseView> currentDatabase;
+        QList<QSharedPointer<const BrowserDatabaseView>> searchDatabases;
+    };
+
     explicit BrowserService(DatabaseTabWidget* parent);
 
     bool isDatabaseOpened() const;
-    bool openDatabase(bool triggerUnlock);
     QString getDatabaseRootUuid();
     QString getDatabaseRecycleBinUuid();
-    QJsonObject getDatabaseGroups(const QSharedPointer<Database>& selectedDb = {});
-    QJsonObject createNewGroup(const QString& groupName);
     QString getKey(const QString& id);
-    void addEntry(const QString& id,
-                  const QString& login,
-                  const QString& password,
-                  const QString& url,
-                  const QString& submitUrl,
-                  const QString& realm,
-                  const QString& group,
-                  const QString& groupUuid,
-                  const QSharedPointer<Database>& selectedDb = {});
+    QSharedPointer<const Snapshot> snapshot();
     QList<Entry*> searchEntries(const QSharedPointer<Database>& db, const QString& hostname, const QString& url);
-    QList<Entry*> searchEntries(const QString& url, const StringPairList& keyList);
+    QList<QPointer<Entry>> searchEntries(const Snapshot& snapshot, const QString& url, const StringPairList& keyList);
     void convertAttributesToCustomData(const QSharedPointer<Database>& currentDb = {});
 
 public:
@@ -77,6 +80,19 @@ public:
     static const QString ADDITIONAL_URL;
 
 public slots:
+    bool openDatabase(bool triggerUnlock);
+    QJsonObject getDatabaseGroups(const QSharedPointer<Database>& selectedDb = {});
+    QJsonObject createNewGroup(const QString& groupName);
+    QJsonObject generatePassword();
+    void addEntry(const QString& id,
+                  const QString& login,
+                  const QString& password,
+                  const QString& url,
+                  const QString& submitUrl,
+                  const QString& realm,
+                  const QString& group,
+                  const QString& groupUuid,
+                  const QSharedPointer<Database>& selectedDb = {});
     QJsonArray findMatchingEntries(const QString& id,
                                    const QString& url,
                                    const QString& submitUrl,
@@ -100,6 +116,16 @@ signals:
     void databaseUnlocked();
     void databaseChanged();
 
+private slots:
+    QJsonArray prepareMatchingEntries(const QList<QPointer<Entry>>& entries,
+                                      const QString& url,
+                                      const QString& submitUrl,
+                                      const QString& realm,
+                                      const bool httpAuth);
+    void updateSnapshot();
+    void invalidateSnapshot();
+    void databaseViewChanged();
+
 private:
     enum Access
     {
@@ -116,6 +142,11 @@ private:
     };
 
 private:
+    QList<QPointer<Entry>> searchEntries(const BrowserDatabaseView& view,
+                                         const QString& hostname,
+                                         const QString& url,
+                                         const bool matchUrlScheme);
+    QSharedPointer<const BrowserDatabaseView> databaseView(const QSharedPointer<Database>& db);
     QList<Entry*> sortEntries(QList<Entry*>& pwEntries, const QString& host, const QString& submitUrl);
     bool confirmEntries(QList<Entry*>& pwEntriesToConfirm,
                         const QString& url,
@@ -130,7 +161,7 @@ private:
     sortPriority(const Entry* entry, const QString& host, const QString& submitUrl, const QString& baseSubmitUrl) const;
     bool schemeFound(const QString& url);
     bool removeFirstDomain(QString& hostname);
-    bool handleURL(const QString& entryUrl, const QString& hostname, const QString& url);
+    bool handleURL(const QString& entryUrl, const QString& hostname, const QString& url, const bool matchUrlScheme);
     QString baseDomain(const QString& hostname) const;
     QSharedPointer<Database> getDatabase();
     QSharedPointer<Database> selectedDatabase();
@@ -148,6 +179,12 @@ private:
     WindowState m_prevWindowState;
     QUuid m_keepassBrowserUUID;
 
+    // Guards m_snapshot and m_snapshotStale, m_databaseViews is only used on the GUI thread
+    QMutex m_snapshotMutex;
+    QSharedPointer<const Snapshot> m_snapshot;
+    bool m_snapshotStale;
+    QHash<const QObject*, QSharedPointer<const BrowserDatabaseView>> m_databaseViews;
+
     friend class TestBrowser;
 };
 
@@ -0,0 +1,139 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "NativeMessageBuffer.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+namespace
+{
+    const int HeaderSize = 4;
+} // namespace
+
+void NativeMessageBuffer::append(const char* data, int size)
+{
+    if (size > 0) {
+        m_buffer.append(data, size);
+    }
+}
+
+void NativeMessageBuffer::append(const QByteArray& data)
+{
+    if (m_buffer.isEmpty()) {
+        // implicitly shared, no copy
+        m_buffer = data;
+        m_offset = 0;
+    } else {
+        m_buffer.append(data);
+    }
+}
+
+/**
+ * Remove the next complete message from the buffer.
+ *
+ * @param message receives the message without length prefix
+ * @return true if a complete message was available
+ */
+bool NativeMessageBuffer::takeMessage(QByteArray& message)
+{
+    if (m_error || m_buffer.size() - m_offset < HeaderSize) {
+        return false;
+    }
+
+    const quint32 length = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(m_buffer.constData() + m_offset));
+    if (length > static_cast<quint32>(NATIVE_MSG_MAX_LENGTH)) {
+        m_error = true;
+        return false;
+    }
+
+    const int frameSize = HeaderSize + static_cast<int>(length);
+    if (m_buffer.size() - m_offset < frameSize) {
+        return false;
+    }
+
+    message = m_buffer.mid(m_offset + HeaderSize, static_cast<int>(length));
+    m_offset += frameSize;
+
+    if (m_offset == m_buffer.size()) {
+        m_buffer.clear();
+        m_offset = 0;
+    } else if (m_offset > m_buffer.size() / 2) {
+        // drop consumed messages once they make up most of the buffer
+        m_buffer.remove(0, m_offset);
+        m_offset = 0;
+    }
+    return true;
+}
+
+/**
+ * Remove all buffered bytes regardless of message boundaries,
+ * used to relay framed data as is.
+ */
+QByteArray NativeMessageBuffer::takeAll()
+{
+    QByteArray data = m_offset == 0 ? m_buffer : m_buffer.mid(m_offset);
+    clear();
+    return data;
+}
+
+void NativeMessageBuffer::clear()
+{
+    m_buffer.clear();
+    m_offset = 0;
+    m_error = false;
+}
+
+bool NativeMessageBuffer::isEmpty() const
+{
+    return m_buffer.size() == m_offset;
+}
+
+/**
+ * @return true if a message exceeding NATIVE_MSG_MAX_LENGTH was announced,
+ *         the stream cannot be resynchronized afterwards
+ */
+bool NativeMessageBuffer::hasError() const
+{
+    return m_error;
+}
+
+/**
+ * Detect plain JSON sent without length prefix by older versions of keepassxc-proxy.
+ * The most significant length byte is always zero for valid messages,
+ * while a JSON message starts with '{' followed by printable characters.
+ */
+bool NativeMessageBuffer::isUnframed() const
+{
+    if (m_buffer.size() - m_offset < HeaderSize) {
+        return false;
+    }
+    const char* data = m_buffer.constData() + m_offset;
+    return data[0] == '{' && data[HeaderSize - 1] != '\0';
+}
+
+/**
+ * @return message preceded by its length as expected by the receiving side
+ */
+QByteArray NativeMessageBuffer::frame(const QByteArray& message)
+{
+    QByteArray frame(HeaderSize + message.size(), Qt::Uninitialized);
+    qToLittleEndian<quint32>(static_cast<quint32>(message.size()), reinterpret_cast<uchar*>(frame.data()));
+    memcpy(frame.data() + HeaderSize, message.constData(), static_cast<size_t>(message.size()));
+    return frame;
+}
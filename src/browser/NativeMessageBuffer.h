@@ -0,0 +1,55 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NATIVEMESSAGEBUFFER_H
+#define NATIVEMESSAGEBUFFER_H
+
+#include <QByteArray>
+
+static const int NATIVE_MSG_MAX_LENGTH = 1024 * 1024;
+
+/**
+ * Receive buffer for length prefixed native messages.
+ *
+ * Every message is preceded by its length as 32 bit little endian integer,
+ * the format used by browsers for native messaging. The same framing is used
+ * between keepassxc-proxy and KeePassXC, so several messages sent in a burst
+ * can be split apart again and a message spread over several reads is
+ * only handled once complete.
+ */
+class NativeMessageBuffer
+{
+public:
+    void append(const char* data, int size);
+    void append(const QByteArray& data);
+    bool takeMessage(QByteArray& message);
+    QByteArray takeAll();
+    void clear();
+
+    bool isEmpty() const;
+    bool hasError() const;
+    bool isUnframed() const;
+
+    static QByteArray frame(const QByteArray& message);
+
+private:
+    QByteArray m_buffer;
+    int m_offset = 0;
+    bool m_error = false;
+};
+
+#endif // NATIVEMESSAGEBUFFER_H
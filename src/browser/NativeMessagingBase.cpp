@@ -34,6 +34,7 @@
 #endif
 
 #ifdef Q_OS_WIN
+#include <cstring>
 #include <fcntl.h>
 #include <io.h>
 #endif
@@ -94,22 +95,62 @@ void NativeMessagingBase::newNativeMessage()
         return;
     }
 #endif
-    readLength();
+    if (!readStdIn()) {
+        stdInClosed();
+    }
 #ifndef Q_OS_WIN
     ::close(fd);
 #endif
 }
 
+/**
+ * Read all data currently available on stdin in one go and pass it on,
+ * a single read may contain several messages or only part of one.
+ *
+ * @return false if stdin was closed
+ */
+bool NativeMessagingBase::readStdIn()
+{
+#ifndef Q_OS_WIN
+    char buffer[64 * 1024];
+    const ssize_t size = ::read(fileno(stdin), buffer, sizeof(buffer));
+    if (size <= 0) {
+        return false;
+    }
+
+    m_stdinBuffer.append(buffer, static_cast<int>(size));
+    processStdIn();
+    return !m_stdinBuffer.hasError();
+#else
+    return false;
+#endif
+}
+
 void NativeMessagingBase::readNativeMessages()
 {
 #ifdef Q_OS_WIN
-    quint32 length = 0;
+    // stdin cannot be polled on Windows, read one complete message at a time
     while (m_running.load() != 0 && !std::cin.eof()) {
-        length = 0;
-        std::cin.read(reinterpret_cast<char*>(&length), 4);
-        readStdIn(length);
-        QThread::msleep(1);
+        char header[4];
+        quint32 length = 0;
+        if (!std::cin.read(header, sizeof(header))) {
+            break;
+        }
+        memcpy(&length, header, sizeof(length));
+        if (length == 0 || length > static_cast<quint32>(NATIVE_MSG_MAX_LENGTH)) {
+            break;
+        }
+
+        QByteArray message(static_cast<int>(length), Qt::Uninitialized);
+        if (!std::cin.read(message.data(), length)) {
+            break;
+        }
+
+        m_stdinBuffer.append(header, sizeof(header));
+        m_stdinBuffer.append(message);
+        processStdIn();
     }
+    stdInClosed();
 #endif
 }
 
@@ -128,14 +169,19 @@ void NativeMessagingBase::sendReply(const QJsonObject& json)
 void NativeMessagingBase::sendReply(const QString& reply)
 {
     if (!reply.isEmpty()) {
-        QByteArray bytes = reply.toUtf8();
-        uint len = bytes.size();
-        std::cout << char(((len >> 0) & 0xFF)) << char(((len >> 8) & 0xFF)) << char(((len >> 16) & 0xFF))
-                  << char(((len >> 24) & 0xFF));
-        std::cout << reply.toStdString() << std::flush;
+        writeStdOut(NativeMessageBuffer::frame(reply.toUtf8()));
     }
 }
 
+/**
+ * Write raw, already framed data to stdout.
+ */
+void NativeMessagingBase::writeStdOut(const QByteArray& data)
+{
+    std::cout.write(data.constData(), data.size());
+    std::cout.flush();
+}
+
 QString NativeMessagingBase::getLocalServerPath() const
 {
     const QString serverPath = "/kpxc_server";
@@ -19,6 +19,8 @@
 #ifndef NATIVEMESSAGINGBASE_H
 #define NATIVEMESSAGINGBASE_H
 
+#include "NativeMessageBuffer.h"
+
 #include <QAtomicInt>
 #include <QFuture>
 #include <QJsonDocument>
@@ -37,8 +39,6 @@
 #include <sys/types.h>
 #endif
 
-static const int NATIVE_MSG_MAX_LENGTH = 1024 * 1024;
-
 class NativeMessagingBase : public QObject
 {
     Q_OBJECT
@@ -51,18 +51,27 @@ protected slots:
     void newNativeMessage();
 
 protected:
-    virtual void readLength() = 0;
-    virtual bool readStdIn(const quint32 length) = 0;
+    /**
+     * Called whenever new data from stdin was added to m_stdinBuffer.
+     */
+    virtual void processStdIn() = 0;
+    /**
+     * Called when stdin was closed or a malformed message was received.
+     */
+    virtual void stdInClosed() = 0;
     virtual void readNativeMessages();
+    bool readStdIn();
     QString jsonToString(const QJsonObject& json) const;
     void sendReply(const QJsonObject& json);
     void sendReply(const QString& reply);
+    void writeStdOut(const QByteArray& data);
     QString getLocalServerPath() const;
 
 protected:
     QAtomicInt m_running;
     QSharedPointer<QSocketNotifier> m_notifier;
     QFuture<void> m_future;
+    NativeMessageBuffer m_stdinBuffer;
 };
 
 #endif // NATIVEMESSAGINGBASE_H
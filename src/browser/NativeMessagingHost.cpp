@@ -18,6 +18,7 @@
 
 #include "NativeMessagingHost.h"
 #include "BrowserSettings.h"
+#include "core/Global.h"
 #include "sodium.h"
 #include <QMutexLocker>
 #include <QtNetwork>
@@ -43,11 +44,17 @@ NativeMessagingHost::NativeMessagingHost(DatabaseTabWidget* parent, const bool e
 
     connect(&m_browserService, SIGNAL(databaseLocked()), this, SLOT(databaseLocked()));
     connect(&m_browserService, SIGNAL(databaseUnlocked()), this, SLOT(databaseUnlocked()));
+    connect(&m_browserClients,
+            SIGNAL(responseReady(QLocalSocket*, QJsonObject)),
+            this,
+            SLOT(sendResponse(QLocalSocket*, QJsonObject)));
 }
 
 NativeMessagingHost::~NativeMessagingHost()
 {
     stop();
+    // Requests still running finish while the members are destroyed, drop their responses
+    m_browserClients.disconnect(this);
 }
 
 int NativeMessagingHost::init()
@@ -98,48 +105,38 @@ void NativeMessagingHost::run()
 void NativeMessagingHost::stop()
 {
     databaseLocked();
+    m_browserClients.clearRequests();
     QMutexLocker locker(&m_mutex);
     m_socketList.clear();
+    m_socketBuffers.clear();
+    m_unframedSockets.clear();
     m_running.testAndSetOrdered(1, 0);
     m_future.waitForFinished();
     m_localServer->close();
 }
 
-void NativeMessagingHost::readLength()
+void NativeMessagingHost::processStdIn()
 {
-    quint32 length = 0;
-    std::cin.read(reinterpret_cast<char*>(&length), 4);
-    if (!std::cin.eof() && length > 0) {
-        readStdIn(length);
-    } else {
-        m_notifier->setEnabled(false);
-    }
-}
+    QMutexLocker locker(&m_mutex);
 
-bool NativeMessagingHost::readStdIn(const quint32 length)
-{
-    if (length <= 0) {
-        return false;
+    QList<QByteArray> messages;
+    QByteArray message;
+    while (m_stdinBuffer.takeMessage(message)) {
+        messages.append(message);
     }
 
-    QByteArray arr;
-    arr.reserve(length);
-
-    QMutexLocker locker(&m_mutex);
-
-    for (quint32 i = 0; i < length; ++i) {
-        int c = std::getchar();
-        if (c == EOF) {
-            // message ended prematurely, ignore it and return
-            return false;
+    for (const QByteArray& request : asConst(messages)) {
+        if (!request.isEmpty()) {
+            m_browserClients.queueRequest(request);
         }
-        arr.append(static_cast<char>(c));
     }
+}
 
-    if (arr.length() > 0) {
-        sendReply(m_browserClients.readResponse(arr));
+void NativeMessagingHost::stdInClosed()
+{
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
     }
-    return true;
 }
 
 void NativeMessagingHost::newLocalConnection()
@@ -175,10 +172,56 @@ void NativeMessagingHost::newLocalMessage()
         m_socketList.push_back(socket);
     }
 
-    QString reply = jsonToString(m_browserClients.readResponse(arr));
+    NativeMessageBuffer& buffer = m_socketBuffers[socket];
+    buffer.append(arr);
+    if (m_unframedSockets.contains(socket) || buffer.isUnframed()) {
+        // Older proxies write each message with a single unframed write
+        m_unframedSockets.insert(socket);
+        m_browserClients.queueRequest(buffer.takeAll(), socket);
+        return;
+    }
+
+    // Requests are handled on worker threads, the responses arrive through sendResponse()
+    QByteArray message;
+    while (buffer.takeMessage(message)) {
+        if (!message.isEmpty()) {
+            m_browserClients.queueRequest(message, socket);
+        } else if (socket->isValid()) {
+            // keepassxc-proxy probes for framing support with an empty frame, acknowledge it in kind
+            socket->write(NativeMessageBuffer::frame(QByteArray()));
+            socket->flush();
+        }
+    }
+
+    if (buffer.hasError()) {
+        // Oversized message, the stream cannot be recovered
+        m_socketBuffers.remove(socket);
+        socket->disconnectFromServer();
+    }
+}
+
+/**
+ * Deliver the response to a request, a null socket stands for stdio.
+ */
+void NativeMessagingHost::sendResponse(QLocalSocket* socket, const QJsonObject& json)
+{
+    if (!socket) {
+        sendReply(json);
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    // The client may have disconnected while the request was handled
+    if (m_socketList.contains(socket)) {
+        sendReplyToSocket(socket, jsonToString(json));
+    }
+}
+
+void NativeMessagingHost::sendReplyToSocket(QLocalSocket* socket, const QString& reply)
+{
     if (socket && socket->isValid() && socket->state() == QLocalSocket::ConnectedState) {
-        QByteArray arr = reply.toUtf8();
-        socket->write(arr.constData(), arr.length());
+        const QByteArray arr = reply.toUtf8();
+        socket->write(m_unframedSockets.contains(socket) ? arr : NativeMessageBuffer::frame(arr));
         socket->flush();
     }
 }
@@ -188,11 +231,7 @@ void NativeMessagingHost::sendReplyToAllClients(const QJsonObject& json)
     QString reply = jsonToString(json);
     QMutexLocker locker(&m_mutex);
     for (const auto socket : m_socketList) {
-        if (socket && socket->isValid() && socket->state() == QLocalSocket::ConnectedState) {
-            QByteArray arr = reply.toUtf8();
-            socket->write(arr.constData(), arr.length());
-            socket->flush();
-        }
+        sendReplyToSocket(socket, reply);
     }
 }
 
@@ -200,6 +239,8 @@ void NativeMessagingHost::disconnectSocket()
 {
     QLocalSocket* socket(qobject_cast<QLocalSocket*>(QObject::sender()));
     QMutexLocker locker(&m_mutex);
+    m_socketBuffers.remove(socket);
+    m_unframedSockets.remove(socket);
     for (auto s : m_socketList) {
         if (s == socket) {
             m_socketList.removeOne(s);
@@ -41,15 +41,17 @@ signals:
     void quit();
 
 private:
-    void readLength() override;
-    bool readStdIn(const quint32 length) override;
+    void processStdIn() override;
+    void stdInClosed() override;
     void sendReplyToAllClients(const QJsonObject& json);
+    void sendReplyToSocket(QLocalSocket* socket, const QString& reply);
 
 private slots:
     void databaseLocked();
     void databaseUnlocked();
     void newLocalConnection();
     void newLocalMessage();
+    void sendResponse(QLocalSocket* socket, const QJsonObject& json);
     void disconnectSocket();
 
 private:
@@ -58,6 +60,9 @@ private:
     BrowserClients m_browserClients;
     QSharedPointer<QLocalServer> m_localServer;
     SocketList m_socketList;
+    QHash<QLocalSocket*, NativeMessageBuffer> m_socketBuffers;
+    // Sockets of older proxies that send and expect plain JSON without framing
+    QSet<QLocalSocket*> m_unframedSockets;
 };
 
 #endif // NATIVEMESSAGINGHOST_H
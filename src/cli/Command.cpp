@@ -42,6 +42,7 @@
 #include "Merge.h"
 #include "Move.h"
 #include "Open.h"
+#include "Prune.h"
 #include "Remove.h"
 #include "RemoveGroup.h"
 #include "Show.h"
@@ -172,6 +173,7 @@ namespace Commands
         s_commands.insert(QStringLiteral("mkdir"), QSharedPointer<Command>(new AddGroup()));
         s_commands.insert(QStringLiteral("mv"), QSharedPointer<Command>(new Move()));
         s_commands.insert(QStringLiteral("open"), QSharedPointer<Command>(new Open()));
+        s_commands.insert(QStringLiteral("prune"), QSharedPointer<Command>(new Prune()));
         s_commands.insert(QStringLiteral("rm"), QSharedPointer<Command>(new Remove()));
         s_commands.insert(QStringLiteral("rmdir"), QSharedPointer<Command>(new RemoveGroup()));
         s_commands.insert(QStringLiteral("show"), QSharedPointer<Command>(new Show()));
@@ -0,0 +1,72 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+
+#include "Prune.h"
+
+#include "cli/TextStream.h"
+#include "cli/Utils.h"
+#include "core/Database.h"
+#include "core/HistoryMaintenance.h"
+#include "core/Tools.h"
+
+const QCommandLineOption Prune::DryRunOption =
+    QCommandLineOption(QStringList() << "dry-run",
+                       QObject::tr("Only print the history that would be removed without changing the database."));
+
+Prune::Prune()
+{
+    name = QString("prune");
+    description = QObject::tr("Remove history exceeding the history settings of the database.");
+    options.append(Prune::DryRunOption);
+}
+
+int Prune::executeWithDatabase(QSharedPointer<Database> database, QSharedPointer<QCommandLineParser> parser)
+{
+    TextStream outputTextStream(parser->isSet(Command::QuietOption) ? Utils::DEVNULL : Utils::STDOUT,
+                                QIODevice::WriteOnly);
+    TextStream errorTextStream(Utils::STDERR, QIODevice::WriteOnly);
+
+    const bool dryRun = parser->isSet(Prune::DryRunOption);
+    HistoryMaintenance maintenance(database.data());
+    const HistoryMaintenance::Report report = maintenance.run(dryRun);
+
+    outputTextStream << QObject::tr("Entries with removed history: %1").arg(report.entries) << endl;
+    outputTextStream << QObject::tr("Removed history items: %1").arg(report.historyItems) << endl;
+    outputTextStream << QObject::tr("Dropped attachments: %1").arg(report.attachments) << endl;
+    outputTextStream << QObject::tr("Reclaimed space: %1").arg(Tools::humanReadableFileSize(report.reclaimedBytes))
+                     << endl;
+
+    if (report.isEmpty()) {
+        outputTextStream << QObject::tr("Database was not modified, the history is within the limits.") << endl;
+        return EXIT_SUCCESS;
+    }
+    if (dryRun) {
+        outputTextStream << QObject::tr("Database was not modified by the dry run.") << endl;
+        return EXIT_SUCCESS;
+    }
+
+    QString errorMessage;
+    if (!database->save(&errorMessage, true, false)) {
+        errorTextStream << QObject::tr("Unable to save database to file: %1").arg(errorMessage) << endl;
+        return EXIT_FAILURE;
+    }
+    outputTextStream << QObject::tr("Successfully pruned the history of %1.").arg(database->filePath()) << endl;
+
+    return EXIT_SUCCESS;
+}
@@ -21,6 +21,7 @@
 #include <QCommandLineParser>
 #include <QCoreApplication>
 #include <QDir>
+#include <QRegularExpression>
 #include <QScopedPointer>
 #include <QStringList>
 
@@ -33,6 +34,7 @@
 #include "config-keepassx.h"
 #include "core/Bootstrap.h"
 #include "core/Tools.h"
+#include "core/Tracing.h"
 #include "crypto/Crypto.h"
 
 #if defined(WITH_ASAN) && defined(WITH_LSAN)
@@ -204,6 +206,10 @@ int main(int argc, char** argv)
 
     QCommandLineOption debugInfoOption(QStringList() << "debug-info", QObject::tr("Displays debugging information."));
     parser.addOption(debugInfoOption);
+#ifdef WITH_XC_TRACING
+    QCommandLineOption traceOption("trace", QObject::tr("Write a performance trace to the given file."), "file");
+    parser.addOption(traceOption);
+#endif
     parser.addHelpOption();
     parser.addVersionOption();
     // TODO : use the setOptionsAfterPositionalArgumentsMode (Qt 5.6) function
@@ -224,6 +230,21 @@ int main(int argc, char** argv)
         parser.showHelp();
     }
 
+#ifdef WITH_XC_TRACING
+    if (parser.isSet(traceOption)) {
+        Tracing::start(parser.value(traceOption));
+        // Sub-commands do not know the option, remove it along with its value
+        const int index = arguments.indexOf(QRegularExpression("^--?trace(=.*)?$"));
+        if (index > 0) {
+            const bool inlineValue = arguments.at(index).contains('=');
+            arguments.removeAt(index);
+            if (!inlineValue && index < arguments.size()) {
+                arguments.removeAt(index);
+            }
+        }
+    }
+#endif
+
     QString commandName = parser.positionalArguments().at(0);
     if (commandName == "open") {
         enterInteractiveMode(arguments);
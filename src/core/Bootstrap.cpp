@@ -18,6 +18,7 @@
 #include "Bootstrap.h"
 #include "config-keepassx.h"
 #include "core/Config.h"
+#include "core/Tracing.h"
 #include "core/Translator.h"
 #include "gui/MessageBox.h"
 
@@ -73,6 +74,9 @@ namespace Bootstrap
         setupSearchPaths();
         applyEarlyQNetworkAccessManagerWorkaround();
         Translator::installTranslators();
+#ifdef WITH_XC_TRACING
+        Tracing::startFromEnvironment();
+#endif
     }
 
     /**
@@ -217,6 +217,7 @@ void Config::init(const QString& fileName)
     m_defaults.insert("security/HidePasswordPreviewPanel", true);
     m_defaults.insert("security/autotypeask", true);
     m_defaults.insert("security/IconDownloadFallback", false);
+    m_defaults.insert("security/IconDownloadCache", false);
     m_defaults.insert("security/resettouchid", false);
     m_defaults.insert("security/resettouchidtimeout", 30);
     m_defaults.insert("security/resettouchidscreenlock", true);
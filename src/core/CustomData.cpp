@@ -119,6 +119,31 @@ void CustomData::copyDataFrom(const CustomData* other)
     emit customDataModified();
 }
 
+/**
+ * Let equal values use the storage of the other custom data.
+ * The values do not change, so no signals are emitted.
+ */
+void CustomData::shareDataWith(const CustomData* other)
+{
+    if (m_data == other->m_data) {
+        m_data = other->m_data;
+        return;
+    }
+
+    // Collect first, writing to a shared container detaches it
+    QList<QString> keys;
+    for (auto it = m_data.constBegin(); it != m_data.constEnd(); ++it) {
+        const auto otherValue = other->m_data.constFind(it.key());
+        if (otherValue != other->m_data.constEnd() && it.value().constData() != otherValue.value().constData()
+            && it.value() == otherValue.value()) {
+            keys.append(it.key());
+        }
+    }
+    for (const QString& key : asConst(keys)) {
+        m_data[key] = other->m_data.value(key);
+    }
+}
+
 QDateTime CustomData::getLastModified() const
 {
     if (m_data.contains(LastModified)) {
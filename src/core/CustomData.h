@@ -42,6 +42,7 @@ public:
     int size() const;
     int dataSize() const;
     void copyDataFrom(const CustomData* other);
+    void shareDataWith(const CustomData* other);
     QDateTime getLastModified() const;
     bool operator==(const CustomData& other) const;
     bool operator!=(const CustomData& other) const;
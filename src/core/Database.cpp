@@ -23,6 +23,7 @@
 #include "core/Group.h"
 #include "core/Merger.h"
 #include "core/Metadata.h"
+#include "core/Tracing.h"
 #include "format/KdbxXmlReader.h"
 #include "format/KeePass2Reader.h"
 #include "format/KeePass2Writer.h"
@@ -31,6 +32,7 @@
 
 #include <QFile>
 #include <QFileInfo>
+#include <QMutex>
 #include <QSaveFile>
 #include <QTemporaryFile>
 #include <QTimer>
@@ -38,6 +40,12 @@
 
 QHash<QUuid, QPointer<Database>> Database::s_uuidMap;
 
+namespace
+{
+    // databases may be created on worker threads, e.g. for KeeShare imports
+    QMutex s_uuidMapMutex;
+} // namespace
+
 Database::Database()
     : m_metadata(new Metadata(this))
     , m_data()
@@ -52,13 +60,19 @@ Database::Database()
     rootGroup()->setName(tr("Root", "Root group name"));
     m_timer->setSingleShot(true);
 
-    s_uuidMap.insert(m_uuid, this);
+    {
+        QMutexLocker locker(&s_uuidMapMutex);
+        s_uuidMap.insert(m_uuid, this);
+    }
 
     connect(m_metadata, SIGNAL(metadataModified()), SLOT(markAsModified()));
     connect(m_timer, SIGNAL(timeout()), SIGNAL(databaseModified()));
     connect(this, SIGNAL(databaseOpened()), SLOT(updateCommonUsernames()));
     connect(this, SIGNAL(databaseSaved()), SLOT(updateCommonUsernames()));
     connect(m_fileWatcher, SIGNAL(fileChanged()), SIGNAL(databaseFileChanged()));
+    connect(this, SIGNAL(groupAboutToAdd(Group*,int)), SLOT(handleGroupAdded(Group*)));
+    connect(this, SIGNAL(groupAboutToRemove(Group*)), SLOT(handleGroupRemoved(Group*)));
+    connect(this, SIGNAL(groupAboutToMove(Group*,Group*,int)), SLOT(handleGroupMoved(Group*)));
 
     m_modified = false;
     m_emitModified = true;
@@ -112,6 +126,7 @@ bool Database::open(QSharedPointer<const CompositeKey> key, QString* error, bool
  */
 bool Database::open(const QString& filePath, QSharedPointer<const CompositeKey> key, QString* error, bool readOnly)
 {
+    TRACE_SPAN("Database::open", "database");
     if (isInitialized() && m_modified) {
         emit databaseDiscarded();
     }
@@ -241,6 +256,7 @@ bool Database::saveAs(const QString& filePath, QString* error, bool atomic, bool
 
 bool Database::performSave(const QString& filePath, QString* error, bool atomic, bool backup)
 {
+    TRACE_SPAN("Database::performSave", "database");
     if (atomic) {
         QSaveFile saveFile(filePath);
         if (saveFile.open(QIODevice::WriteOnly)) {
@@ -308,6 +324,7 @@ bool Database::performSave(const QString& filePath, QString* error, bool atomic,
 
 bool Database::writeDatabase(QIODevice* device, QString* error)
 {
+    TRACE_SPAN("Database::writeDatabase", "database");
     Q_ASSERT(!m_data.isReadOnly);
     if (m_data.isReadOnly) {
         if (error) {
@@ -390,7 +407,10 @@ bool Database::import(const QString& xmlExportPath, QString* error)
 
 void Database::releaseData()
 {
-    s_uuidMap.remove(m_uuid);
+    {
+        QMutexLocker locker(&s_uuidMapMutex);
+        s_uuidMap.remove(m_uuid);
+    }
     m_uuid = QUuid();
 
     if (m_modified) {
@@ -398,6 +418,7 @@ void Database::releaseData()
     }
 
     m_data.clear();
+    resetReferenceIndex();
 
     if (m_rootGroup && m_rootGroup->parent() == this) {
         delete m_rootGroup;
@@ -425,6 +446,7 @@ void Database::releaseData()
  */
 bool Database::backupDatabase(const QString& filePath)
 {
+    TRACE_SPAN("Database::backupDatabase", "database,io");
     static auto re = QRegularExpression("(\\.[^.]+)$");
 
     auto match = re.match(filePath);
@@ -510,6 +532,7 @@ void Database::setRootGroup(Group* group)
         emit databaseDiscarded();
     }
 
+    resetReferenceIndex();
     m_rootGroup = group;
     m_rootGroup->setParent(this);
 }
@@ -729,6 +752,27 @@ bool Database::setKey(const QSharedPointer<const CompositeKey>& key,
     return true;
 }
 
+/**
+ * Set a key together with the KDF it has already been transformed with,
+ * e.g. remembered from a previous save. Unlike setKey() the KDF is not run.
+ *
+ * @param key composite key
+ * @param kdf KDF including the seed the key was transformed with
+ * @param transformedMasterKey result of transforming key with kdf
+ */
+void Database::setTransformedKey(const QSharedPointer<const CompositeKey>& key,
+                                 const QSharedPointer<Kdf>& kdf,
+                                 const QByteArray& transformedMasterKey)
+{
+    Q_ASSERT(!m_data.isReadOnly);
+    Q_ASSERT(key && kdf && !transformedMasterKey.isEmpty());
+
+    m_data.key = key;
+    m_data.kdf = kdf;
+    m_data.transformedMasterKey->setHash(transformedMasterKey);
+    m_data.hasKey = true;
+}
+
 bool Database::hasKey() const
 {
     return m_data.hasKey;
@@ -816,6 +860,7 @@ void Database::emptyRecycleBin()
 {
     Q_ASSERT(!m_data.isReadOnly);
     if (m_metadata->recycleBinEnabled() && m_metadata->recycleBin()) {
+        beginUpdate();
         // destroying direct entries of the recycle bin
         QList<Entry*> subEntries = m_metadata->recycleBin()->entries();
         for (Entry* entry : subEntries) {
@@ -826,6 +871,7 @@ void Database::emptyRecycleBin()
         for (Group* group : subGroups) {
             delete group;
         }
+        endUpdate();
     }
 }
 
@@ -846,11 +892,151 @@ bool Database::isModified() const
 void Database::markAsModified()
 {
     m_modified = true;
+
+    // entries and groups are connected directly to this slot
+    if (m_referencesIndexed) {
+        if (auto entry = qobject_cast<Entry*>(sender())) {
+            indexReferences(entry);
+        }
+    }
+
+    if (m_updateDepth > 0) {
+        if (auto entry = qobject_cast<Entry*>(sender())) {
+            if (!m_changes.addedEntries.contains(entry->uuid())) {
+                m_changes.modifiedEntries.insert(entry->uuid());
+            }
+        } else if (auto group = qobject_cast<Group*>(sender())) {
+            if (!m_changes.addedGroups.contains(group->uuid())) {
+                m_changes.modifiedGroups.insert(group->uuid());
+            }
+        }
+        m_updateModified = true;
+        return;
+    }
+
+    emit databaseModifiedImmediate();
     if (m_emitModified) {
         startModifiedTimer();
     }
 }
 
+/**
+ * Start a bulk update of the database.
+ *
+ * Until the matching endUpdate() call the modified timer is not restarted
+ * and all added, removed and modified entries and groups are collected.
+ * Views may ignore per-object change signals while isUpdating() is true
+ * and refresh once on updateFinished(). Calls may be nested.
+ */
+void Database::beginUpdate()
+{
+    if (m_updateDepth++ > 0) {
+        return;
+    }
+
+    m_updateModified = false;
+    m_changes = DatabaseChanges();
+    emit updateStarted();
+}
+
+/**
+ * Finish a bulk update started with beginUpdate() and emit
+ * the coalesced changes with updateFinished().
+ */
+void Database::endUpdate()
+{
+    Q_ASSERT(m_updateDepth > 0);
+    if (m_updateDepth == 0 || --m_updateDepth > 0) {
+        return;
+    }
+
+    DatabaseChanges changes;
+    qSwap(changes, m_changes);
+    emit updateFinished(changes);
+
+    if (m_updateModified) {
+        emit databaseModifiedImmediate();
+        if (m_emitModified) {
+            startModifiedTimer();
+        }
+    }
+}
+
+bool Database::isUpdating() const
+{
+    return m_updateDepth > 0;
+}
+
+void Database::recordAdded(QSet<QUuid>& added, QSet<QUuid>& removed, QSet<QUuid>& modified, const QUuid& uuid)
+{
+    if (removed.remove(uuid)) {
+        // removed and added again, e.g. moved between groups
+        modified.insert(uuid);
+    } else {
+        added.insert(uuid);
+    }
+}
+
+void Database::recordRemoved(QSet<QUuid>& added, QSet<QUuid>& removed, QSet<QUuid>& modified, const QUuid& uuid)
+{
+    modified.remove(uuid);
+    if (!added.remove(uuid)) {
+        removed.insert(uuid);
+    }
+}
+
+void Database::handleEntryAdded(Entry* entry)
+{
+    if (m_referencesIndexed) {
+        indexReferences(entry);
+    }
+    if (m_updateDepth > 0) {
+        recordAdded(m_changes.addedEntries, m_changes.removedEntries, m_changes.modifiedEntries, entry->uuid());
+    }
+}
+
+void Database::handleEntryRemoved(Entry* entry)
+{
+    if (m_referencesIndexed) {
+        unindexReferences(entry);
+    }
+    if (m_updateDepth > 0) {
+        recordRemoved(m_changes.addedEntries, m_changes.removedEntries, m_changes.modifiedEntries, entry->uuid());
+    }
+}
+
+void Database::handleGroupAdded(Group* group)
+{
+    // groups moved in from another database bring their entries along
+    if (m_referencesIndexed) {
+        for (Entry* entry : group->entriesRecursive()) {
+            indexReferences(entry);
+        }
+    }
+    if (m_updateDepth > 0) {
+        recordAdded(m_changes.addedGroups, m_changes.removedGroups, m_changes.modifiedGroups, group->uuid());
+    }
+}
+
+void Database::handleGroupRemoved(Group* group)
+{
+    if (m_referencesIndexed) {
+        for (Entry* entry : group->entriesRecursive()) {
+            unindexReferences(entry);
+        }
+    }
+    if (m_updateDepth > 0) {
+        recordRemoved(m_changes.addedGroups, m_changes.removedGroups, m_changes.modifiedGroups, group->uuid());
+    }
+}
+
+void Database::handleGroupMoved(Group* group)
+{
+    if (m_updateDepth > 0 && !m_changes.addedGroups.contains(group->uuid())) {
+        m_changes.modifiedGroups.insert(group->uuid());
+    }
+}
+
 void Database::markAsClean()
 {
     bool emitSignal = m_modified;
@@ -860,12 +1046,74 @@ void Database::markAsClean()
     }
 }
 
+/**
+ * Find all entries that reference the entry with the given uuid
+ * in one of their default attributes ({REF:<WantedField>@I:<uuid>}).
+ *
+ * The reverse reference index is built on the first call and kept up to
+ * date as entries are added, removed or modified afterwards.
+ *
+ * @param uuid UUID of the referenced entry
+ * @return referencing entries in no particular order
+ */
+QList<Entry*> Database::referencingEntries(const QUuid& uuid)
+{
+    if (!m_referencesIndexed) {
+        m_referencesIndexed = true;
+        if (m_rootGroup) {
+            for (Entry* entry : m_rootGroup->entriesRecursive()) {
+                indexReferences(entry);
+            }
+        }
+    }
+
+    return m_referencingEntries.value(uuid).toList();
+}
+
+void Database::indexReferences(Entry* entry)
+{
+    const QSet<QUuid> uuids = entry->referencedUuids();
+    if (uuids == m_referencedUuids.value(entry)) {
+        return;
+    }
+
+    unindexReferences(entry);
+    if (!uuids.isEmpty()) {
+        for (const QUuid& uuid : uuids) {
+            m_referencingEntries[uuid].insert(entry);
+        }
+        m_referencedUuids.insert(entry, uuids);
+    }
+}
+
+void Database::unindexReferences(Entry* entry)
+{
+    const QSet<QUuid> oldUuids = m_referencedUuids.take(entry);
+    for (const QUuid& uuid : oldUuids) {
+        auto it = m_referencingEntries.find(uuid);
+        if (it != m_referencingEntries.end()) {
+            it->remove(entry);
+            if (it->isEmpty()) {
+                m_referencingEntries.erase(it);
+            }
+        }
+    }
+}
+
+void Database::resetReferenceIndex()
+{
+    m_referencesIndexed = false;
+    m_referencingEntries.clear();
+    m_referencedUuids.clear();
+}
+
 /**
  * @param uuid UUID of the database
  * @return pointer to the database or nullptr if no such database exists
  */
 Database* Database::databaseByUuid(const QUuid& uuid)
 {
+    QMutexLocker locker(&s_uuidMapMutex);
     return s_uuidMap.value(uuid, nullptr);
 }
 
@@ -24,6 +24,8 @@
 #include <QObject>
 #include <QPointer>
 #include <QScopedPointer>
+#include <QSet>
+#include <QUuid>
 
 #include "config-keepassx.h"
 #include "crypto/kdf/AesKdf.h"
@@ -52,6 +54,28 @@ struct DeletedObject
 
 Q_DECLARE_TYPEINFO(DeletedObject, Q_MOVABLE_TYPE);
 
+/**
+ * Coalesced set of changes made between Database::beginUpdate()
+ * and the matching Database::endUpdate() call.
+ * An object that was added and removed again within the same update
+ * is not reported, an entry or group that was moved is reported as modified.
+ */
+struct DatabaseChanges
+{
+    QSet<QUuid> addedEntries;
+    QSet<QUuid> removedEntries;
+    QSet<QUuid> modifiedEntries;
+    QSet<QUuid> addedGroups;
+    QSet<QUuid> removedGroups;
+    QSet<QUuid> modifiedGroups;
+
+    bool isEmpty() const
+    {
+        return addedEntries.isEmpty() && removedEntries.isEmpty() && modifiedEntries.isEmpty()
+               && addedGroups.isEmpty() && removedGroups.isEmpty() && modifiedGroups.isEmpty();
+    }
+};
+
 class Database : public QObject
 {
     Q_OBJECT
@@ -113,6 +137,7 @@ public:
     void setDeletedObjects(const QList<DeletedObject>& delObjs);
 
     QList<QString> commonUsernames();
+    QList<Entry*> referencingEntries(const QUuid& uuid);
 
     bool hasKey() const;
     QSharedPointer<const CompositeKey> key() const;
@@ -120,6 +145,9 @@ public:
                 bool updateChangedTime = true,
                 bool updateTransformSalt = false,
                 bool transformKey = true);
+    void setTransformedKey(const QSharedPointer<const CompositeKey>& key,
+                           const QSharedPointer<Kdf>& kdf,
+                           const QByteArray& transformedMasterKey);
     QByteArray challengeResponseKey() const;
     bool challengeMasterSeed(const QByteArray& masterSeed);
     bool verifyKey(const QSharedPointer<CompositeKey>& key) const;
@@ -133,6 +161,10 @@ public:
     bool changeKdf(const QSharedPointer<Kdf>& kdf);
     QByteArray transformedMasterKey() const;
 
+    void beginUpdate();
+    void endUpdate();
+    bool isUpdating() const;
+
     static Database* databaseByUuid(const QUuid& uuid);
 
 public slots:
@@ -151,12 +183,20 @@ signals:
     void groupMoved();
     void databaseOpened();
     void databaseModified();
+    void databaseModifiedImmediate();
     void databaseSaved();
     void databaseDiscarded();
     void databaseFileChanged();
+    void updateStarted();
+    void updateFinished(const DatabaseChanges& changes);
 
 private slots:
     void startModifiedTimer();
+    void handleEntryAdded(Entry* entry);
+    void handleEntryRemoved(Entry* entry);
+    void handleGroupAdded(Group* group);
+    void handleGroupRemoved(Group* group);
+    void handleGroupMoved(Group* group);
 
 private:
     struct DatabaseData
@@ -201,6 +241,11 @@ private:
     };
 
     void createRecycleBin();
+    static void recordAdded(QSet<QUuid>& added, QSet<QUuid>& removed, QSet<QUuid>& modified, const QUuid& uuid);
+    static void recordRemoved(QSet<QUuid>& added, QSet<QUuid>& removed, QSet<QUuid>& modified, const QUuid& uuid);
+    void indexReferences(Entry* entry);
+    void unindexReferences(Entry* entry);
+    void resetReferenceIndex();
 
     bool writeDatabase(QIODevice* device, QString* error = nullptr);
     bool backupDatabase(const QString& filePath);
@@ -217,6 +262,15 @@ private:
     bool m_modified = false;
     bool m_emitModified;
 
+    int m_updateDepth = 0;
+    bool m_updateModified = false;
+    DatabaseChanges m_changes;
+
+    // Reverse reference index, built on first use by referencingEntries()
+    bool m_referencesIndexed = false;
+    QHash<QUuid, QSet<Entry*>> m_referencingEntries;
+    QHash<const Entry*, QSet<QUuid>> m_referencedUuids;
+
     QList<QString> m_commonUsernames;
 
     QUuid m_uuid;
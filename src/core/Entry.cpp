@@ -43,6 +43,8 @@ Entry::Entry()
     , m_customData(new CustomData(this))
     , m_modifiedSinceBegin(false)
     , m_updateTimeinfo(true)
+    , m_dataSize(-1)
+    , m_historySize(0)
 {
     m_data.iconNumber = DefaultIconNumber;
     m_data.autoTypeEnabled = true;
@@ -57,6 +59,7 @@ Entry::Entry()
 
     connect(this, SIGNAL(entryModified()), SLOT(updateTimeinfo()));
     connect(this, SIGNAL(entryModified()), SLOT(updateModifiedSinceBegin()));
+    connect(this, SIGNAL(entryModified()), SLOT(invalidateDataSize()));
 }
 
 Entry::~Entry()
@@ -101,6 +104,26 @@ void Entry::setUpdateTimeinfo(bool value)
     m_updateTimeinfo = value;
 }
 
+/**
+ * Block the signals of the entry and its attribute containers while it is filled in bulk,
+ * e.g. by a database reader. Unblocking refreshes the data derived from the attributes.
+ */
+void Entry::setSignalsBlocked(bool blocked)
+{
+    blockSignals(blocked);
+    m_attributes->blockSignals(blocked);
+    m_attachments->blockSignals(blocked);
+    m_autoTypeAssociations->blockSignals(blocked);
+    m_customData->blockSignals(blocked);
+
+    if (!blocked) {
+        // changes made while blocked were not tracked
+        invalidateDataSize();
+        invalidateHistorySize();
+        updateTotp();
+    }
+}
+
 QString Entry::buildReference(const QUuid& uuid, const QString& field)
 {
     Q_ASSERT(EntryAttributes::DefaultAttributes.count(field) > 0);
@@ -387,6 +410,34 @@ bool Entry::hasReferencesTo(const QUuid& uuid) const
     return false;
 }
 
+/**
+ * @return uuids of all entries this entry references in its default attributes,
+ *         i.e. every uuid for which hasReferencesTo() returns true
+ */
+QSet<QUuid> Entry::referencedUuids() const
+{
+    // Same rule as isAttributeReferenceOf(): a reference attribute refers to every
+    // uuid whose hex form it contains, regardless of case and search field
+    static const QRegularExpression hexRunRegExp("[0-9a-f]{32,}", QRegularExpression::CaseInsensitiveOption);
+    static const int uuidHexLength = 32;
+
+    QSet<QUuid> uuids;
+    for (const QString& key : EntryAttributes::DefaultAttributes) {
+        if (!m_attributes->isReference(key)) {
+            continue;
+        }
+
+        auto it = hexRunRegExp.globalMatch(m_attributes->value(key));
+        while (it.hasNext()) {
+            const QString hexRun = it.next().captured();
+            for (int i = 0; i + uuidHexLength <= hexRun.size(); ++i) {
+                uuids.insert(Tools::hexToUuid(hexRun.mid(i, uuidHexLength)));
+            }
+        }
+    }
+    return uuids;
+}
+
 void Entry::replaceReferencesWithValues(const Entry* other)
 {
     for (const QString& key : EntryAttributes::DefaultAttributes) {
@@ -620,7 +671,13 @@ void Entry::addHistoryItem(Entry* entry)
 {
     Q_ASSERT(!entry->parent());
 
+    entry->shareDataWith(this);
     m_history.append(entry);
+    if (m_historySize >= 0) {
+        m_historySize += entry->dataSize();
+    }
+    // history items are rarely changed, but their size must stay accurate when they are
+    connect(entry, SIGNAL(entryModified()), this, SLOT(invalidateHistorySize()));
     emit entryModified();
 }
 
@@ -636,12 +693,38 @@ void Entry::removeHistoryItems(const QList<Entry*>& historyEntries)
         Q_ASSERT(m_history.contains(entry));
 
         m_history.removeOne(entry);
+        if (m_historySize >= 0) {
+            m_historySize -= entry->dataSize();
+        }
         delete entry;
     }
 
     emit entryModified();
 }
 
+/**
+ * Let every history item share unchanged attributes, attachments and custom data
+ * with the next newer item instead of keeping its own copy.
+ *
+ * Items added through addHistoryItem() only share with the current entry, this
+ * also catches values that were changed back and forth in deep history.
+ */
+void Entry::shareHistoryData()
+{
+    const Entry* newer = this;
+    for (int i = m_history.size() - 1; i >= 0; --i) {
+        m_history[i]->shareDataWith(newer);
+        newer = m_history[i];
+    }
+}
+
+void Entry::shareDataWith(const Entry* other)
+{
+    m_attributes->shareDataWith(other->m_attributes);
+    m_attachments->shareDataWith(other->m_attachments);
+    m_customData->shareDataWith(other->m_customData);
+}
+
 void Entry::truncateHistory()
 {
     const Database* db = database();
@@ -651,50 +734,79 @@ void Entry::truncateHistory()
     }
 
     int histMaxItems = db->metadata()->historyMaxItems();
-    if (histMaxItems > -1) {
-        int historyCount = 0;
-        QMutableListIterator<Entry*> i(m_history);
-        i.toBack();
-        while (i.hasPrevious()) {
-            historyCount++;
-            Entry* entry = i.previous();
-            if (historyCount > histMaxItems) {
-                delete entry;
-                i.remove();
+    if (histMaxItems > -1 && m_history.size() > histMaxItems) {
+        const int count = m_history.size() - histMaxItems;
+        const QList<Entry*> removed = m_history.mid(0, count);
+        m_history.erase(m_history.begin(), m_history.begin() + count);
+        for (const Entry* historyItem : removed) {
+            if (m_historySize >= 0) {
+                m_historySize -= historyItem->dataSize();
             }
         }
+        qDeleteAll(removed);
     }
 
     int histMaxSize = db->metadata()->historyMaxSize();
-    if (histMaxSize > -1) {
+    if (histMaxSize > -1 && historySize() > histMaxSize) {
+        // Keep the newest items that fit into the maximum size
         int size = 0;
-        QSet<QByteArray> foundAttachments = attachments()->values();
-
-        QMutableListIterator<Entry*> i(m_history);
-        i.toBack();
-        const QRegularExpression delimiter(",|:|;");
-        while (i.hasPrevious()) {
-            Entry* historyItem = i.previous();
-
-            // don't calculate size if it's already above the maximum
-            if (size <= histMaxSize) {
-                size += historyItem->attributes()->attributesSize();
-                size += historyItem->autoTypeAssociations()->associationsSize();
-                size += historyItem->attachments()->attachmentsSize();
-                size += historyItem->customData()->dataSize();
-                const QStringList tags = historyItem->tags().split(delimiter, QString::SkipEmptyParts);
-                for (const QString& tag : tags) {
-                    size += tag.toUtf8().size();
-                }
-                foundAttachments += historyItem->attachments()->values();
-            }
+        int keep = m_history.size();
+        while (keep > 0 && size + m_history.at(keep - 1)->dataSize() <= histMaxSize) {
+            size += m_history.at(keep - 1)->dataSize();
+            --keep;
+        }
 
-            if (size > histMaxSize) {
-                delete historyItem;
-                i.remove();
-            }
+        const QList<Entry*> removed = m_history.mid(0, keep);
+        m_history.erase(m_history.begin(), m_history.begin() + keep);
+        m_historySize = size;
+        qDeleteAll(removed);
+    }
+}
+
+/**
+ * Size of the entry data that is counted against the maximum history size.
+ * The size is cached until the entry is modified.
+ */
+int Entry::dataSize() const
+{
+    if (m_dataSize < 0) {
+        static const QRegularExpression delimiter(",|:|;");
+        int size = m_attributes->attributesSize();
+        size += m_autoTypeAssociations->associationsSize();
+        size += m_attachments->attachmentsSize();
+        size += m_customData->dataSize();
+        const QStringList tags = m_data.tags.split(delimiter, QString::SkipEmptyParts);
+        for (const QString& tag : tags) {
+            size += tag.toUtf8().size();
+        }
+        m_dataSize = size;
+    }
+    return m_dataSize;
+}
+
+/**
+ * Total data size of all history items, kept up to date as items are added and removed.
+ */
+int Entry::historySize() const
+{
+    if (m_historySize < 0) {
+        int size = 0;
+        for (const Entry* historyItem : m_history) {
+            size += historyItem->dataSize();
         }
+        m_historySize = size;
     }
+    return m_historySize;
+}
+
+void Entry::invalidateDataSize()
+{
+    m_dataSize = -1;
+}
+
+void Entry::invalidateHistorySize()
+{
+    m_historySize = -1;
 }
 
 bool Entry::equals(const Entry* other, CompareItemOptions options) const
@@ -791,6 +903,7 @@ void Entry::copyDataFrom(const Entry* other)
 {
     setUpdateTimeinfo(false);
     m_data = other->m_data;
+    invalidateDataSize();
     m_customData->copyDataFrom(other->m_customData);
     m_attributes->copyDataFrom(other->m_attributes);
     m_attachments->copyDataFrom(other->m_attachments);
@@ -1006,7 +1119,8 @@ void Entry::setGroup(Group* group)
             if (!iconUuid().isNull() && group->database()
                 && m_group->database()->metadata()->containsCustomIcon(iconUuid())
                 && !group->database()->metadata()->containsCustomIcon(iconUuid())) {
-                group->database()->metadata()->addCustomIcon(iconUuid(), icon());
+                group->database()->metadata()->addCustomIcon(
+                    iconUuid(), m_group->database()->metadata()->customIconData(iconUuid()));
             }
         }
     }
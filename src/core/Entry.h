@@ -117,6 +117,7 @@ public:
     void replaceReferencesWithValues(const Entry* other);
     bool hasReferences() const;
     bool hasReferencesTo(const QUuid& uuid) const;
+    QSet<QUuid> referencedUuids() const;
     EntryAttributes* attributes();
     const EntryAttributes* attributes() const;
     EntryAttachments* attachments();
@@ -155,6 +156,9 @@ public:
     void addHistoryItem(Entry* entry);
     void removeHistoryItems(const QList<Entry*>& historyEntries);
     void truncateHistory();
+    void shareHistoryData();
+    int dataSize() const;
+    int historySize() const;
 
     bool equals(const Entry* other, CompareItemOptions options = CompareItemDefault) const;
 
@@ -225,6 +229,7 @@ public:
 
     bool canUpdateTimeinfo() const;
     void setUpdateTimeinfo(bool value);
+    void setSignalsBlocked(bool blocked);
 
 signals:
     /**
@@ -238,6 +243,8 @@ private slots:
     void updateTimeinfo();
     void updateModifiedSinceBegin();
     void updateTotp();
+    void invalidateDataSize();
+    void invalidateHistorySize();
 
 private:
     QString resolveMultiplePlaceholdersRecursive(const QString& str, int maxDepth) const;
@@ -246,6 +253,7 @@ private:
     QString referenceFieldValue(EntryReferenceType referenceType) const;
 
     static QString buildReference(const QUuid& uuid, const QString& field);
+    void shareDataWith(const Entry* other);
     static EntryReferenceType referenceType(const QString& referenceStr);
 
     template <class T> bool set(T& property, const T& value);
@@ -262,6 +270,8 @@ private:
     bool m_modifiedSinceBegin;
     QPointer<Group> m_group;
     bool m_updateTimeinfo;
+    mutable int m_dataSize;
+    mutable int m_historySize;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(Entry::CloneFlags)
@@ -143,6 +143,27 @@ void EntryAttachments::copyDataFrom(const EntryAttachments* other)
     }
 }
 
+/**
+ * Let equal attachments use the storage of the other attachments.
+ * The attachments do not change, so no signals are emitted.
+ */
+void EntryAttachments::shareDataWith(const EntryAttachments* other)
+{
+    // Collect first, writing to a shared container detaches it
+    QList<QString> keys;
+    for (auto it = m_attachments.constBegin(); it != m_attachments.constEnd(); ++it) {
+        const auto otherValue = other->m_attachments.constFind(it.key());
+        // Shared blobs need no comparison
+        if (otherValue != other->m_attachments.constEnd() && it.value().constData() != otherValue.value().constData()
+            && it.value() == otherValue.value()) {
+            keys.append(it.key());
+        }
+    }
+    for (const QString& key : asConst(keys)) {
+        m_attachments[key] = other->m_attachments.value(key);
+    }
+}
+
 bool EntryAttachments::operator==(const EntryAttachments& other) const
 {
     return m_attachments == other.m_attachments;
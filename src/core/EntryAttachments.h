@@ -39,6 +39,7 @@ public:
     bool isEmpty() const;
     void clear();
     void copyDataFrom(const EntryAttachments* other);
+    void shareDataWith(const EntryAttachments* other);
     bool operator==(const EntryAttachments& other) const;
     bool operator!=(const EntryAttachments& other) const;
     int attachmentsSize() const;
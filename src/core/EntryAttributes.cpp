@@ -254,6 +254,34 @@ void EntryAttributes::copyDataFrom(const EntryAttributes* other)
     }
 }
 
+/**
+ * Let equal values use the storage of the other attributes.
+ * The values do not change, so no signals are emitted.
+ */
+void EntryAttributes::shareDataWith(const EntryAttributes* other)
+{
+    if (m_attributes == other->m_attributes) {
+        m_attributes = other->m_attributes;
+        if (m_protectedAttributes == other->m_protectedAttributes) {
+            m_protectedAttributes = other->m_protectedAttributes;
+        }
+        return;
+    }
+
+    // Collect first, writing to a shared container detaches it
+    QList<QString> keys;
+    for (auto it = m_attributes.constBegin(); it != m_attributes.constEnd(); ++it) {
+        const auto otherValue = other->m_attributes.constFind(it.key());
+        if (otherValue != other->m_attributes.constEnd() && it.value().constData() != otherValue.value().constData()
+            && it.value() == otherValue.value()) {
+            keys.append(it.key());
+        }
+    }
+    for (const QString& key : asConst(keys)) {
+        m_attributes[key] = other->m_attributes.value(key);
+    }
+}
+
 QUuid EntryAttributes::referenceUuid(const QString& key) const
 {
     if (!m_attributes.contains(key)) {
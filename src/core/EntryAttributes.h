@@ -49,6 +49,7 @@ public:
     void clear();
     int attributesSize() const;
     void copyDataFrom(const EntryAttributes* other);
+    void shareDataWith(const EntryAttributes* other);
     QUuid referenceUuid(const QString& key) const;
     bool operator==(const EntryAttributes& other) const;
     bool operator!=(const EntryAttributes& other) const;
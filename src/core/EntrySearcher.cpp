@@ -20,6 +20,7 @@
 
 #include "core/Group.h"
 #include "core/Tools.h"
+#include "core/Tracing.h"
 
 EntrySearcher::EntrySearcher(bool caseSensitive)
     : m_caseSensitive(caseSensitive)
@@ -68,6 +69,7 @@ QList<Entry*> EntrySearcher::search(const QString& searchString, const Group* ba
  */
 QList<Entry*> EntrySearcher::repeat(const Group* baseGroup, bool forceSearch)
 {
+    TRACE_SPAN("EntrySearcher::repeat", "search");
     Q_ASSERT(baseGroup);
 
     QList<Entry*> results;
@@ -118,6 +120,7 @@ QList<Entry*> EntrySearcher::searchEntries(const QString& searchString, const QL
  */
 QList<Entry*> EntrySearcher::repeatEntries(const QList<Entry*>& entries)
 {
+    TRACE_SPAN("EntrySearcher::repeatEntries", "search");
     QList<Entry*> results;
     for (auto* entry : entries) {
         if (searchEntryImpl(entry)) {
@@ -0,0 +1,177 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FaviconCache.h"
+
+#include "core/Clock.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+
+namespace
+{
+    const QString IndexFileName("index.json");
+    const uint IconExpiry = 30 * 24 * 60 * 60;
+} // namespace
+
+FaviconCache::FaviconCache(const QString& directory)
+    : m_directory(directory)
+    , m_modified(false)
+{
+    load();
+}
+
+QString FaviconCache::defaultDirectory()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).absoluteFilePath("favicons");
+}
+
+/**
+ * Look up the icon of a host.
+ *
+ * @param host host name of a website
+ * @param data the cached icon, only set if it was found
+ * @return Found for an icon, Missing if the host is not cached or its entry expired
+ */
+FaviconCache::Status FaviconCache::lookup(const QString& host, QByteArray& data) const
+{
+    const auto item = m_index.constFind(hostKey(host));
+    if (item == m_index.constEnd()) {
+        return Missing;
+    }
+
+    if (Clock::currentSecondsSinceEpoch() - item->time >= IconExpiry) {
+        return Missing;
+    }
+
+    QFile file(iconPath(item->icon));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return Missing;
+    }
+    data = file.readAll();
+    return Found;
+}
+
+/**
+ * Remember the icon of a host.
+ *
+ * @param host host name of a website
+ * @param data icon data, failed downloads (empty data) are not cached
+ */
+void FaviconCache::insert(const QString& host, const QByteArray& data)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+
+    const QString icon = QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+    QFile file(iconPath(icon));
+    if (!file.exists()) {
+        if (!QDir().mkpath(m_directory) || !file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+            qWarning("Unable to cache favicon: %s", qPrintable(file.errorString()));
+            file.remove();
+            return;
+        }
+    }
+
+    m_index.insert(hostKey(host), {icon, Clock::currentSecondsSinceEpoch()});
+    m_modified = true;
+}
+
+/**
+ * Write the index and delete icons no host refers to anymore.
+ *
+ * @return true on success
+ */
+bool FaviconCache::save()
+{
+    if (!m_modified) {
+        return true;
+    }
+
+    QJsonObject hosts;
+    QSet<QString> icons;
+    for (auto it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+        QJsonObject item;
+        item["icon"] = it->icon;
+        item["time"] = static_cast<qint64>(it->time);
+        hosts[it.key()] = item;
+        icons.insert(it->icon);
+    }
+
+    QDir dir(m_directory);
+    if (!dir.mkpath(".")) {
+        return false;
+    }
+    const QStringList files = dir.entryList({"*.png"}, QDir::Files);
+    for (const QString& fileName : files) {
+        if (!icons.contains(QFileInfo(fileName).completeBaseName())) {
+            dir.remove(fileName);
+        }
+    }
+
+    QJsonObject root;
+    root["hosts"] = hosts;
+    QSaveFile file(dir.absoluteFilePath(IndexFileName));
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0
+        || !file.commit()) {
+        qWarning("Unable to save the favicon cache: %s", qPrintable(file.errorString()));
+        return false;
+    }
+    m_modified = false;
+    return true;
+}
+
+QString FaviconCache::hostKey(const QString& host)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(host.toLower().toUtf8(), QCryptographicHash::Sha256).toHex());
+}
+
+QString FaviconCache::iconPath(const QString& icon) const
+{
+    return QDir(m_directory).absoluteFilePath(icon + ".png");
+}
+
+/**
+ * Read the index, expired entries and entries without an icon are dropped.
+ */
+void FaviconCache::load()
+{
+    QFile file(QDir(m_directory).absoluteFilePath(IndexFileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const uint now = Clock::currentSecondsSinceEpoch();
+    const QJsonObject hosts = QJsonDocument::fromJson(file.readAll()).object().value("hosts").toObject();
+    for (auto it = hosts.constBegin(); it != hosts.constEnd(); ++it) {
+        const QJsonObject item = it.value().toObject();
+        const QString icon = item.value("icon").toString();
+        const uint time = static_cast<uint>(item.value("time").toDouble());
+        if (icon.isEmpty() || now - time >= IconExpiry) {
+            m_modified = true;
+            continue;
+        }
+        m_index.insert(it.key(), {icon, time});
+    }
+}
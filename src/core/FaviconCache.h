@@ -0,0 +1,66 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_FAVICONCACHE_H
+#define KEEPASSXC_FAVICONCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+/**
+ * Remembers downloaded favicons between runs of the icon downloader.
+ *
+ * Every icon is stored once in the cache directory, named by the hash of its content.
+ * An index maps hosts to icons. Hosts are only stored as hashes, so the cache does not
+ * list the websites of a database in clear text. Failed downloads are not remembered,
+ * they are retried on the next run.
+ */
+class FaviconCache
+{
+public:
+    enum Status
+    {
+        Missing,
+        Found
+    };
+
+    explicit FaviconCache(const QString& directory = defaultDirectory());
+
+    static QString defaultDirectory();
+
+    Status lookup(const QString& host, QByteArray& data) const;
+    void insert(const QString& host, const QByteArray& data);
+    bool save();
+
+private:
+    struct Item
+    {
+        QString icon;
+        uint time;
+    };
+
+    static QString hostKey(const QString& host);
+    QString iconPath(const QString& icon) const;
+    void load();
+
+    QString m_directory;
+    QHash<QString, Item> m_index;
+    bool m_modified;
+};
+
+#endif // KEEPASSXC_FAVICONCACHE_H
@@ -18,32 +18,61 @@
 
 #include "FileWatcher.h"
 
-#include "core/AsyncTask.h"
 #include "core/Clock.h"
 
 #include <QCryptographicHash>
+#include <QDir>
 #include <QFileInfo>
+#include <QSocketNotifier>
+#include <QtConcurrent>
 
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
 #ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
 #include <sys/vfs.h>
+#include <unistd.h>
 #endif
 
 namespace
 {
     const int FileChangeDelay = 200;
+    // blocks hashed at the head and the tail of the file, the head covers the KDBX header
+    const qint64 DefaultChecksumBlockSize = 64 * 1024;
+    // the poll interval grows up to this factor while the file does not change
+    const int MaxChecksumBackoff = 8;
+    // signals of a path are delivered once it did not change for this long
+    const int SignalDebounceDelay = 100;
 } // namespace
 
 FileWatcher::FileWatcher(QObject* parent)
     : QObject(parent)
+    , m_fileChecksumBlockSize(DefaultChecksumBlockSize)
+    , m_fileChecksumWholeFile(false)
+    , m_fileChecksumInterval(0)
+    , m_fileGeneration(0)
+    , m_fileChecksumGeneration(0)
     , m_ignoreFileChange(false)
 {
     connect(&m_fileWatcher, SIGNAL(fileChanged(QString)), SLOT(onWatchedFileChanged()));
     connect(&m_fileChangeDelayTimer, SIGNAL(timeout()), SIGNAL(fileChanged()));
     connect(&m_fileChecksumTimer, SIGNAL(timeout()), SLOT(checkFileChecksum()));
+    connect(&m_fileChecksumWatcher, SIGNAL(finished()), SLOT(checkFileChecksumFinished()));
     m_fileChangeDelayTimer.setSingleShot(true);
     m_fileIgnoreDelayTimer.setSingleShot(true);
 }
 
+/**
+ * Watch a file.
+ *
+ * @param filePath file to watch
+ * @param checksumIntervalSeconds initial interval to poll the file, 0 to rely on file system notifications only
+ * @param checksumSizeKibibytes size of the blocks hashed at the head and the tail of the file,
+ *                              -1 to confirm changes with a hash of the whole file
+ */
 void FileWatcher::start(const QString& filePath, int checksumIntervalSeconds, int checksumSizeKibibytes)
 {
     stop();
@@ -67,10 +96,12 @@ void FileWatcher::start(const QString& filePath, int checksumIntervalSeconds, in
     m_filePath = filePath;
 
     // Handle file checksum
-    m_fileChecksumSizeBytes = checksumSizeKibibytes * 1024;
-    m_fileChecksum = calculateChecksum();
-    if (checksumIntervalSeconds > 0) {
-        m_fileChecksumTimer.start(checksumIntervalSeconds * 1000);
+    m_fileChecksumWholeFile = checksumSizeKibibytes <= 0;
+    m_fileChecksumBlockSize = m_fileChecksumWholeFile ? DefaultChecksumBlockSize : checksumSizeKibibytes * 1024;
+    m_fileSnapshot = takeSnapshot(m_filePath, m_fileChecksumBlockSize, m_fileChecksumWholeFile);
+    m_fileChecksumInterval = checksumIntervalSeconds * 1000;
+    if (m_fileChecksumInterval > 0) {
+        m_fileChecksumTimer.start(m_fileChecksumInterval);
     }
 
     m_ignoreFileChange = false;
@@ -82,8 +113,11 @@ void FileWatcher::stop()
         m_fileWatcher.removePath(m_filePath);
     }
     m_filePath.clear();
-    m_fileChecksum.clear();
+    m_fileSnapshot = Snapshot();
+    // results of a running check are outdated
+    ++m_fileGeneration;
     m_fileChangeDelayTimer.stop();
+    m_fileChecksumTimer.stop();
 }
 
 void FileWatcher::pause()
@@ -108,7 +142,11 @@ void FileWatcher::onWatchedFileChanged()
         return;
     }
 
-    m_fileChecksum = calculateChecksum();
+    m_fileSnapshot = takeSnapshot(m_filePath, m_fileChecksumBlockSize, m_fileChecksumWholeFile);
+    ++m_fileGeneration;
+    if (m_fileChecksumInterval > 0) {
+        m_fileChecksumTimer.start(m_fileChecksumInterval);
+    }
     m_fileChangeDelayTimer.start(0);
 }
 
@@ -120,39 +158,179 @@ bool FileWatcher::shouldIgnoreChanges()
 
 bool FileWatcher::hasSameFileChecksum()
 {
-    return calculateChecksum() == m_fileChecksum;
+    const Snapshot snapshot =
+        compareSnapshot(m_filePath, m_fileSnapshot, m_fileChecksumBlockSize, m_fileChecksumWholeFile);
+    if (snapshot.changed) {
+        return false;
+    }
+    // the file was only touched, don't hash it again
+    m_fileSnapshot = snapshot;
+    return true;
+}
+
+/**
+ * @return the current interval of the background check in milliseconds, 0 if the file is not polled
+ */
+int FileWatcher::checksumInterval() const
+{
+    return m_fileChecksumTimer.isActive() ? m_fileChecksumTimer.interval() : 0;
 }
 
 void FileWatcher::checkFileChecksum()
 {
-    if (shouldIgnoreChanges()) {
+    if (shouldIgnoreChanges() || m_fileChecksumWatcher.isRunning()) {
         return;
     }
 
-    if (!hasSameFileChecksum()) {
+    m_fileChecksumGeneration = m_fileGeneration;
+    m_fileChecksumWatcher.setFuture(QtConcurrent::run(&FileWatcher::compareSnapshot,
+                                                      m_filePath,
+                                                      m_fileSnapshot,
+                                                      m_fileChecksumBlockSize,
+                                                      m_fileChecksumWholeFile));
+}
+
+void FileWatcher::checkFileChecksumFinished()
+{
+    if (m_fileChecksumGeneration != m_fileGeneration || shouldIgnoreChanges()) {
+        // the file was restarted or changed in the meantime
+        return;
+    }
+
+    const Snapshot snapshot = m_fileChecksumWatcher.result();
+    if (snapshot.changed) {
         onWatchedFileChanged();
+        return;
+    }
+
+    if (snapshot.state == m_fileSnapshot.state) {
+        // nothing happened, poll less often
+        const int interval = qMin(m_fileChecksumTimer.interval() * 2, m_fileChecksumInterval * MaxChecksumBackoff);
+        if (interval != m_fileChecksumTimer.interval()) {
+            m_fileChecksumTimer.start(interval);
+        }
+    } else {
+        m_fileSnapshot = snapshot;
+        m_fileChecksumTimer.start(m_fileChecksumInterval);
     }
 }
 
-QByteArray FileWatcher::calculateChecksum()
+bool FileWatcher::FileState::operator==(const FileState& other) const
 {
-    return AsyncTask::runAndWaitForFuture([this]() -> QByteArray {
-        QFile file(m_filePath);
-        if (file.open(QFile::ReadOnly)) {
-            QCryptographicHash hash(QCryptographicHash::Sha256);
-            if (m_fileChecksumSizeBytes > 0) {
-                hash.addData(file.read(m_fileChecksumSizeBytes));
-            } else {
-                hash.addData(&file);
-            }
-            return hash.result();
-        }
+    return exists == other.exists && size == other.size && modified == other.modified && changed == other.changed
+           && inode == other.inode;
+}
+
+/**
+ * @return size, modification and status change time and inode of the file, as far as the platform provides them
+ */
+FileWatcher::FileState FileWatcher::readFileState(const QString& path)
+{
+    FileState state;
+#if defined(Q_OS_UNIX)
+    struct stat statBuf;
+    if (::stat(QFile::encodeName(path).constData(), &statBuf) != 0) {
+        return state;
+    }
+    state.exists = true;
+    state.size = statBuf.st_size;
+    state.inode = statBuf.st_ino;
+#if defined(Q_OS_MACOS)
+    state.modified = statBuf.st_mtimespec.tv_sec * Q_INT64_C(1000000000) + statBuf.st_mtimespec.tv_nsec;
+    state.changed = statBuf.st_ctimespec.tv_sec * Q_INT64_C(1000000000) + statBuf.st_ctimespec.tv_nsec;
+#elif defined(Q_OS_LINUX)
+    state.modified = statBuf.st_mtim.tv_sec * Q_INT64_C(1000000000) + statBuf.st_mtim.tv_nsec;
+    state.changed = statBuf.st_ctim.tv_sec * Q_INT64_C(1000000000) + statBuf.st_ctim.tv_nsec;
+#else
+    state.modified = statBuf.st_mtime * Q_INT64_C(1000000000);
+    state.changed = statBuf.st_ctime * Q_INT64_C(1000000000);
+#endif
+#else
+    const QFileInfo info(path);
+    if (!info.exists()) {
+        return state;
+    }
+    state.exists = true;
+    state.size = info.size();
+    state.modified = info.lastModified().toMSecsSinceEpoch() * 1000000;
+#endif
+    return state;
+}
+
+/**
+ * Hash the head and the tail of a file. Every save changes the KDBX header at the
+ * head, the tail covers files which were appended to or truncated.
+ *
+ * @param blockSize size of the hashed blocks, 0 to hash the whole file
+ */
+QByteArray FileWatcher::calculateChecksum(const QString& path, qint64 blockSize)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
         return {};
-    });
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (blockSize <= 0) {
+        hash.addData(&file);
+        return hash.result();
+    }
+
+    const qint64 size = file.size();
+    hash.addData(file.read(blockSize));
+    if (size > blockSize) {
+        file.seek(qMax(blockSize, size - blockSize));
+        hash.addData(file.read(blockSize));
+    }
+    hash.addData(QByteArray::number(size));
+    return hash.result();
+}
+
+FileWatcher::Snapshot FileWatcher::takeSnapshot(const QString& path, qint64 blockSize, bool wholeFile)
+{
+    Snapshot snapshot;
+    snapshot.state = readFileState(path);
+    snapshot.checksum = calculateChecksum(path, blockSize);
+    if (wholeFile) {
+        snapshot.fullChecksum = calculateChecksum(path, 0);
+    }
+    return snapshot;
+}
+
+/**
+ * Compare a file with a known snapshot of it, cheapest check first. The file is only read
+ * if its metadata changed and the whole file is only hashed to confirm that an unchanged head
+ * and tail mean an unchanged file. Safe to call on a worker thread.
+ *
+ * @return the snapshot of the file, changed is set if its content changed
+ */
+FileWatcher::Snapshot
+FileWatcher::compareSnapshot(const QString& path, const Snapshot& known, qint64 blockSize, bool wholeFile)
+{
+    Snapshot snapshot = known;
+    snapshot.changed = false;
+    snapshot.state = readFileState(path);
+    if (snapshot.state == known.state) {
+        return snapshot;
+    }
+
+    snapshot.checksum = calculateChecksum(path, blockSize);
+    if (snapshot.checksum != known.checksum) {
+        snapshot.changed = true;
+        return snapshot;
+    }
+
+    if (wholeFile) {
+        snapshot.fullChecksum = calculateChecksum(path, 0);
+        snapshot.changed = snapshot.fullChecksum != known.fullChecksum;
+    }
+    return snapshot;
 }
 
 BulkFileWatcher::BulkFileWatcher(QObject* parent)
     : QObject(parent)
+    , m_inotify(-1)
+    , m_inotifyNotifier(nullptr)
 {
     connect(&m_fileWatcher, SIGNAL(fileChanged(QString)), SLOT(handleFileChanged(QString)));
     connect(&m_fileWatcher, SIGNAL(directoryChanged(QString)), SLOT(handleDirectoryChanged(QString)));
@@ -160,6 +338,27 @@ BulkFileWatcher::BulkFileWatcher(QObject* parent)
     connect(&m_pendingSignalsTimer, SIGNAL(timeout()), this, SLOT(emitSignals()));
     m_watchedFilesIgnoreTimer.setSingleShot(true);
     m_pendingSignalsTimer.setSingleShot(true);
+    m_clock.start();
+
+#if defined(Q_OS_LINUX)
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify >= 0) {
+        m_inotifyNotifier = new QSocketNotifier(m_inotify, QSocketNotifier::Read, this);
+        connect(m_inotifyNotifier, SIGNAL(activated(int)), SLOT(handleInotifyEvents()));
+    } else {
+        qWarning("Unable to initialize inotify, falling back to QFileSystemWatcher");
+    }
+#endif
+}
+
+BulkFileWatcher::~BulkFileWatcher()
+{
+#if defined(Q_OS_LINUX)
+    if (m_inotify >= 0) {
+        delete m_inotifyNotifier;
+        ::close(m_inotify);
+    }
+#endif
 }
 
 void BulkFileWatcher::clear()
@@ -169,6 +368,9 @@ void BulkFileWatcher::clear()
         m_fileWatcher.removePath(info.absoluteFilePath());
         m_fileWatcher.removePath(info.absolutePath());
     }
+    for (const QString& directoryPath : m_inotifyWatches.keys()) {
+        removeInotifyWatch(directoryPath);
+    }
     m_watchedPaths.clear();
     m_watchedFilesInDirectory.clear();
     m_watchedFilesIgnored.clear();
@@ -183,6 +385,7 @@ void BulkFileWatcher::removePath(const QString& path)
     m_fileWatcher.removePath(filePath);
     m_watchedPaths.remove(filePath);
     if (m_watchedFilesInDirectory[directoryPath].isEmpty()) {
+        removeInotifyWatch(directoryPath);
         m_fileWatcher.removePath(directoryPath);
         m_watchedPaths.remove(directoryPath);
         m_watchedFilesInDirectory.remove(directoryPath);
@@ -194,6 +397,12 @@ void BulkFileWatcher::addPath(const QString& path)
     const QFileInfo info(path);
     const QString filePath = info.absoluteFilePath();
     const QString directoryPath = info.absolutePath();
+    if (m_inotifyWatches.contains(directoryPath) || addInotifyWatch(directoryPath)) {
+        // the directory watch reports all changes of the file
+        m_watchedFilesInDirectory[directoryPath][filePath] =
+            info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0;
+        return;
+    }
     if (!m_watchedPaths.value(filePath)) {
         const bool fileSuccess = m_fileWatcher.addPath(filePath);
         m_watchedPaths[filePath] = fileSuccess;
@@ -274,10 +483,198 @@ void BulkFileWatcher::handleDirectoryChanged(const QString& path)
     }
 }
 
+/**
+ * Watch a directory with inotify.
+ *
+ * @return false if inotify is not available or the directory cannot be watched,
+ *         e.g. because the limit of watches is reached
+ */
+bool BulkFileWatcher::addInotifyWatch(const QString& directoryPath)
+{
+#if defined(Q_OS_LINUX)
+    if (m_inotify < 0) {
+        return false;
+    }
+    // Only report files which are complete, partial writes are followed by IN_CLOSE_WRITE
+    const quint32 mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR;
+    const int watch = inotify_add_watch(m_inotify, QFile::encodeName(directoryPath).constData(), mask);
+    if (watch < 0) {
+        qDebug("Unable to watch %s with inotify: %s", qPrintable(directoryPath), strerror(errno));
+        return false;
+    }
+    m_inotifyWatches.insert(directoryPath, watch);
+    m_inotifyDirectories.insert(watch, directoryPath);
+    return true;
+#else
+    Q_UNUSED(directoryPath);
+    return false;
+#endif
+}
+
+void BulkFileWatcher::removeInotifyWatch(const QString& directoryPath)
+{
+#if defined(Q_OS_LINUX)
+    const auto watch = m_inotifyWatches.find(directoryPath);
+    if (watch == m_inotifyWatches.end()) {
+        return;
+    }
+    inotify_rm_watch(m_inotify, watch.value());
+    m_inotifyDirectories.remove(watch.value());
+    m_inotifyWatches.erase(watch);
+#else
+    Q_UNUSED(directoryPath);
+#endif
+}
+
+void BulkFileWatcher::handleInotifyEvents()
+{
+#if defined(Q_OS_LINUX)
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = ::read(m_inotify, buffer, sizeof(buffer))) > 0) {
+        for (const char* ptr = buffer; ptr < buffer + length;) {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // events were dropped, compare all watched files with what we know about them
+                qWarning("inotify event queue overflowed");
+                for (const QString& directoryPath : m_inotifyWatches.keys()) {
+                    rescanDirectory(directoryPath);
+                }
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                // watches removed by removeInotifyWatch() are already forgotten
+                const QString directoryPath = m_inotifyDirectories.take(event->wd);
+                if (!directoryPath.isEmpty()) {
+                    m_inotifyWatches.remove(directoryPath);
+                    rewatchDirectory(directoryPath);
+                }
+                continue;
+            }
+
+            const QString directoryPath = m_inotifyDirectories.value(event->wd);
+            if (directoryPath.isEmpty() || event->len == 0) {
+                continue;
+            }
+            handleInotifyEvent(QDir(directoryPath).absoluteFilePath(QFile::decodeName(event->name)), event->mask);
+        }
+    }
+#endif
+}
+
+/**
+ * Report the changes of all watched files in a directory that inotify did not report.
+ */
+void BulkFileWatcher::rescanDirectory(const QString& directoryPath)
+{
+#if defined(Q_OS_LINUX)
+    const QMap<QString, qint64> watchedFiles = m_watchedFilesInDirectory.value(directoryPath);
+    for (auto it = watchedFiles.cbegin(); it != watchedFiles.cend(); ++it) {
+        const QFileInfo info(it.key());
+        if (!info.exists()) {
+            handleInotifyEvent(it.key(), IN_DELETE);
+        } else if (info.lastModified().toMSecsSinceEpoch() != it.value()) {
+            handleInotifyEvent(it.key(), IN_CLOSE_WRITE);
+        }
+    }
+#else
+    Q_UNUSED(directoryPath);
+#endif
+}
+
+/**
+ * Keep watching the files of a directory whose inotify watch was dropped by the
+ * kernel, e.g. because the directory was removed, replaced or unmounted.
+ * The watch is added again if the directory still exists, otherwise the files
+ * fall back to QFileSystemWatcher.
+ */
+void BulkFileWatcher::rewatchDirectory(const QString& directoryPath)
+{
+    rescanDirectory(directoryPath);
+
+    const QStringList filePaths = m_watchedFilesInDirectory.value(directoryPath).keys();
+    if (filePaths.isEmpty() || (QFileInfo(directoryPath).isDir() && addInotifyWatch(directoryPath))) {
+        return;
+    }
+
+    qDebug("Lost the inotify watch of %s, falling back to QFileSystemWatcher", qPrintable(directoryPath));
+    for (const QString& filePath : filePaths) {
+        if (!m_watchedPaths.value(filePath)) {
+            m_watchedPaths[filePath] = m_fileWatcher.addPath(filePath);
+        }
+    }
+    if (!m_watchedPaths.value(directoryPath)) {
+        m_watchedPaths[directoryPath] = m_fileWatcher.addPath(directoryPath);
+    }
+}
+
+void BulkFileWatcher::handleInotifyEvent(const QString& filePath, quint32 mask)
+{
+#if defined(Q_OS_LINUX)
+    const QString directoryPath = QFileInfo(filePath).absolutePath();
+    auto watchedFiles = m_watchedFilesInDirectory.find(directoryPath);
+    if (watchedFiles == m_watchedFilesInDirectory.end() || !watchedFiles->contains(filePath)) {
+        // other files in the same directory are of no interest
+        return;
+    }
+
+    const bool existed = watchedFiles->value(filePath) != 0;
+    if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+        (*watchedFiles)[filePath] = 0;
+        if (existed && !isIgnored(filePath)) {
+            qDebug("File removed %s", qPrintable(filePath));
+            scheduleSignal(Removed, filePath);
+        }
+        return;
+    }
+
+    const QFileInfo info(filePath);
+    (*watchedFiles)[filePath] = info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0;
+    if (!info.exists() || isIgnored(filePath)) {
+        return;
+    }
+    if (existed) {
+        qDebug("File changed %s", qPrintable(filePath));
+        scheduleSignal(Updated, filePath);
+    } else {
+        qDebug("File created %s", qPrintable(filePath));
+        scheduleSignal(Created, filePath);
+    }
+#else
+    Q_UNUSED(filePath);
+    Q_UNUSED(mask);
+#endif
+}
+
+bool BulkFileWatcher::isIgnored(const QString& path) const
+{
+    const auto ignored = m_watchedFilesIgnored.constFind(QFileInfo(path).canonicalFilePath());
+    return ignored != m_watchedFilesIgnored.constEnd() && ignored.value() > Clock::currentDateTimeUtc();
+}
+
 void BulkFileWatcher::emitSignals()
 {
+    // only deliver the signals of paths which calmed down
+    const qint64 now = m_clock.elapsed();
+    qint64 next = -1;
     QMap<QString, QList<Signal>> queued;
-    m_pendingSignals.swap(queued);
+    for (auto it = m_pendingSignals.begin(); it != m_pendingSignals.end();) {
+        const qint64 deadline = m_pendingSignalsDeadline.value(it.key());
+        if (deadline > now) {
+            next = next < 0 ? deadline : qMin(next, deadline);
+            ++it;
+            continue;
+        }
+        queued.insert(it.key(), it.value());
+        m_pendingSignalsDeadline.remove(it.key());
+        it = m_pendingSignals.erase(it);
+    }
+    if (next >= 0) {
+        m_pendingSignalsTimer.start(static_cast<int>(next - now));
+    }
+
     for (const auto& path : queued.keys()) {
         const auto& signal = queued[path];
         if (signal.last() == Removed) {
@@ -301,9 +698,10 @@ void BulkFileWatcher::scheduleSignal(Signal signal, const QString& path)
     // therefore we wait until the event loop finished before starting to import any changes
     const QString filePath = QFileInfo(path).absoluteFilePath();
     m_pendingSignals[filePath] << signal;
+    m_pendingSignalsDeadline[filePath] = m_clock.elapsed() + SignalDebounceDelay;
 
     if (!m_pendingSignalsTimer.isActive()) {
-        m_pendingSignalsTimer.start();
+        m_pendingSignalsTimer.start(SignalDebounceDelay);
     }
 }
 
@@ -18,11 +18,22 @@
 #ifndef KEEPASSXC_FILEWATCHER_H
 #define KEEPASSXC_FILEWATCHER_H
 
+#include <QElapsedTimer>
 #include <QFileSystemWatcher>
+#include <QFutureWatcher>
 #include <QSet>
 #include <QTimer>
 #include <QVariant>
 
+class QSocketNotifier;
+
+/**
+ * Notifies about changes of a database file.
+ *
+ * Besides the notifications of the file system, the file is polled in the background since
+ * those are unreliable on network shares. Polling compares the metadata of the file first,
+ * the file is only read if its metadata changed. The poll interval grows while nothing changes.
+ */
 class FileWatcher : public QObject
 {
     Q_OBJECT
@@ -34,6 +45,7 @@ public:
     void stop();
 
     bool hasSameFileChecksum();
+    int checksumInterval() const;
 
 signals:
     void fileChanged();
@@ -45,21 +57,57 @@ public slots:
 private slots:
     void onWatchedFileChanged();
     void checkFileChecksum();
+    void checkFileChecksumFinished();
 
 private:
-    QByteArray calculateChecksum();
+    struct FileState
+    {
+        bool exists = false;
+        qint64 size = 0;
+        qint64 modified = 0;
+        qint64 changed = 0;
+        quint64 inode = 0;
+
+        bool operator==(const FileState& other) const;
+    };
+
+    struct Snapshot
+    {
+        FileState state;
+        QByteArray checksum;
+        QByteArray fullChecksum;
+        bool changed = false;
+    };
+
+    static FileState readFileState(const QString& path);
+    static QByteArray calculateChecksum(const QString& path, qint64 blockSize);
+    static Snapshot takeSnapshot(const QString& path, qint64 blockSize, bool wholeFile);
+    static Snapshot compareSnapshot(const QString& path, const Snapshot& known, qint64 blockSize, bool wholeFile);
     bool shouldIgnoreChanges();
 
     QString m_filePath;
     QFileSystemWatcher m_fileWatcher;
-    QByteArray m_fileChecksum;
+    Snapshot m_fileSnapshot;
+    QFutureWatcher<Snapshot> m_fileChecksumWatcher;
     QTimer m_fileChangeDelayTimer;
     QTimer m_fileIgnoreDelayTimer;
     QTimer m_fileChecksumTimer;
-    int m_fileChecksumSizeBytes;
+    qint64 m_fileChecksumBlockSize;
+    bool m_fileChecksumWholeFile;
+    int m_fileChecksumInterval;
+    int m_fileGeneration;
+    int m_fileChecksumGeneration;
     bool m_ignoreFileChange;
 };
 
+/**
+ * Notifies about created, changed and removed files of many paths.
+ *
+ * On Linux, a single inotify instance watches the directories of the files and only reports
+ * files which were closed after writing, moved into place or removed. Elsewhere, or if inotify
+ * is not available, QFileSystemWatcher watches each file and its directory. Signals are debounced
+ * per path and delivered in batches.
+ */
 class BulkFileWatcher : public QObject
 {
     Q_OBJECT
@@ -73,6 +121,7 @@ class BulkFileWatcher : public QObject
 
 public:
     explicit BulkFileWatcher(QObject* parent = nullptr);
+    ~BulkFileWatcher() override;
 
     void clear();
 
@@ -92,10 +141,17 @@ public slots:
 private slots:
     void handleFileChanged(const QString& path);
     void handleDirectoryChanged(const QString& path);
+    void handleInotifyEvents();
     void emitSignals();
 
 private:
     void scheduleSignal(Signal event, const QString& path);
+    bool addInotifyWatch(const QString& directoryPath);
+    void removeInotifyWatch(const QString& directoryPath);
+    void rescanDirectory(const QString& directoryPath);
+    void rewatchDirectory(const QString& directoryPath);
+    void handleInotifyEvent(const QString& filePath, quint32 mask);
+    bool isIgnored(const QString& path) const;
 
 private:
     QMap<QString, bool> m_watchedPaths;
@@ -107,6 +163,13 @@ private:
     // needed to tolerate multiple signals for same event
     QTimer m_pendingSignalsTimer;
     QMap<QString, QList<Signal>> m_pendingSignals;
+    QHash<QString, qint64> m_pendingSignalsDeadline;
+    QElapsedTimer m_clock;
+
+    int m_inotify;
+    QSocketNotifier* m_inotifyNotifier;
+    QHash<int, QString> m_inotifyDirectories;
+    QHash<QString, int> m_inotifyWatches;
 };
 
 #endif // KEEPASSXC_FILEWATCHER_H
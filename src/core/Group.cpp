@@ -24,9 +24,12 @@
 #include "core/Global.h"
 #include "core/Metadata.h"
 #include "core/Tools.h"
+#include "core/Tracing.h"
 
 #include <QtConcurrent>
 
+#include <algorithm>
+
 const int Group::DefaultIconNumber = 48;
 const int Group::RecycleBinIconNumber = 43;
 const QString Group::RootAutoTypeSequence = "{USERNAME}{TAB}{PASSWORD}{ENTER}";
@@ -453,10 +456,11 @@ void Group::setParent(Group* parent, int index)
             // copy custom icon to the new database
             if (!iconUuid().isNull() && parent->m_db && m_db->metadata()->containsCustomIcon(iconUuid())
                 && !parent->m_db->metadata()->containsCustomIcon(iconUuid())) {
-                parent->m_db->metadata()->addCustomIcon(iconUuid(), icon());
+                parent->m_db->metadata()->addCustomIcon(iconUuid(), m_db->metadata()->customIconData(iconUuid()));
             }
         }
         if (m_db != parent->m_db) {
+            TRACE_SPAN("Group::connectDatabaseSignalsRecursive", "database");
             connectDatabaseSignalsRecursive(parent->m_db);
         }
         QObject::setParent(parent);
@@ -493,7 +497,10 @@ void Group::setParent(Database* db)
     cleanupParent();
 
     m_parent = nullptr;
-    connectDatabaseSignalsRecursive(db);
+    {
+        TRACE_SPAN("Group::connectDatabaseSignalsRecursive", "database");
+        connectDatabaseSignalsRecursive(db);
+    }
 
     QObject::setParent(db);
 }
@@ -580,9 +587,26 @@ QList<Entry*> Group::entriesRecursive(bool includeHistoryItems) const
 
 QList<Entry*> Group::referencesRecursive(const Entry* entry) const
 {
-    auto entries = entriesRecursive();
-    return QtConcurrent::blockingFiltered(entries,
-                                          [entry](const Entry* e) { return e->hasReferencesTo(entry->uuid()); });
+    if (!m_db) {
+        auto entries = entriesRecursive();
+        return QtConcurrent::blockingFiltered(entries,
+                                              [entry](const Entry* e) { return e->hasReferencesTo(entry->uuid()); });
+    }
+
+    // Use the reference index of the database and only keep entries below this group
+    QList<Entry*> references = m_db->referencingEntries(entry->uuid());
+    references.erase(std::remove_if(references.begin(),
+                                    references.end(),
+                                    [this](const Entry* e) {
+                                        for (const Group* group = e->group(); group; group = group->parentGroup()) {
+                                            if (group == this) {
+                                                return false;
+                                            }
+                                        }
+                                        return true;
+                                    }),
+                     references.end());
+    return references;
 }
 
 Entry* Group::findEntryByUuid(const QUuid& uuid, bool recursive) const
@@ -975,6 +999,8 @@ void Group::connectDatabaseSignalsRecursive(Database* db)
         disconnect(SIGNAL(aboutToMove(Group*, Group*, int)), m_db);
         disconnect(SIGNAL(groupMoved()), m_db);
         disconnect(SIGNAL(groupModified()), m_db);
+        disconnect(SIGNAL(entryAdded(Entry*)), m_db);
+        disconnect(SIGNAL(entryRemoved(Entry*)), m_db);
     }
 
     for (Entry* entry : asConst(m_entries)) {
@@ -996,6 +1022,8 @@ void Group::connectDatabaseSignalsRecursive(Database* db)
         connect(this, SIGNAL(aboutToMove(Group*,Group*,int)), db, SIGNAL(groupAboutToMove(Group*,Group*,int)));
         connect(this, SIGNAL(groupMoved()), db, SIGNAL(groupMoved()));
         connect(this, SIGNAL(groupModified()), db, SLOT(markAsModified()));
+        connect(this, SIGNAL(entryAdded(Entry*)), db, SLOT(handleEntryAdded(Entry*)));
+        connect(this, SIGNAL(entryRemoved(Entry*)), db, SLOT(handleEntryRemoved(Entry*)));
         // clang-format on
     }
 
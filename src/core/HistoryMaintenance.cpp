@@ -0,0 +1,181 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HistoryMaintenance.h"
+
+#include "core/Clock.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Global.h"
+#include "core/Group.h"
+#include "core/Metadata.h"
+
+#include <QSet>
+#include <QtConcurrent>
+#include <functional>
+
+namespace
+{
+    struct Plan
+    {
+        Entry* entry = nullptr;
+        QList<Entry*> removed;
+        QList<QByteArray> keptAttachments;
+        QList<QByteArray> removedAttachments;
+        qint64 removedSize = 0;
+    };
+
+    /**
+     * Find the history items of an entry that exceed the limits.
+     * Only reads the entry and its history, so entries can be planned in parallel.
+     */
+    Plan planEntry(Entry* entry, int maxItems, int maxSize, const QDateTime& cutoff)
+    {
+        Plan plan;
+        plan.entry = entry;
+        plan.keptAttachments = entry->attachments()->values().toList();
+
+        // Like Entry::truncateHistory(), all items older than the first one
+        // exceeding the number or the size are removed as well
+        int count = 0;
+        int size = 0;
+        bool full = false;
+        const QList<Entry*>& history = entry->historyItems();
+        for (int i = history.size() - 1; i >= 0; --i) {
+            Entry* historyItem = history.at(i);
+            const int itemSize = historyItem->dataSize();
+
+            full = full || (maxItems > -1 && count >= maxItems) || (maxSize > -1 && size + itemSize > maxSize);
+            const bool keep = !full && (!cutoff.isValid() || historyItem->timeInfo().lastModificationTime() >= cutoff);
+            if (keep) {
+                ++count;
+                size += itemSize;
+                plan.keptAttachments += historyItem->attachments()->values().toList();
+            } else {
+                plan.removed.prepend(historyItem);
+                // attachments are accounted for once the whole database is planned
+                plan.removedSize += itemSize - historyItem->attachments()->attachmentsSize();
+                plan.removedAttachments += historyItem->attachments()->values().toList();
+            }
+        }
+        return plan;
+    }
+} // namespace
+
+bool HistoryMaintenance::Report::isEmpty() const
+{
+    return historyItems == 0;
+}
+
+HistoryMaintenance::HistoryMaintenance(Database* db)
+    : m_db(db)
+    , m_maxItems(db->metadata()->historyMaxItems())
+    , m_maxSize(db->metadata()->historyMaxSize())
+    , m_maxAgeDays(db->metadata()->maintenanceHistoryDays())
+{
+}
+
+/**
+ * @param maxItems maximum number of history items per entry, -1 for no limit
+ */
+void HistoryMaintenance::setMaxItems(int maxItems)
+{
+    m_maxItems = maxItems;
+}
+
+/**
+ * @param maxSize maximum size of the history of an entry in bytes, -1 for no limit
+ */
+void HistoryMaintenance::setMaxSize(int maxSize)
+{
+    m_maxSize = maxSize;
+}
+
+/**
+ * @param days remove history items last modified more than this many days ago, 0 or less for no limit
+ */
+void HistoryMaintenance::setMaxAgeDays(int days)
+{
+    m_maxAgeDays = days;
+}
+
+/**
+ * Remove the history items that exceed the limits from all entries of the database.
+ *
+ * @param dryRun only report what would be removed without changing the database
+ * @return the removed history items and the reclaimed space
+ */
+HistoryMaintenance::Report HistoryMaintenance::run(bool dryRun)
+{
+    Report report;
+    if (!m_db->rootGroup()) {
+        return report;
+    }
+
+    QDateTime cutoff;
+    if (m_maxAgeDays > 0) {
+        cutoff = Clock::currentDateTimeUtc().addDays(-m_maxAgeDays);
+    }
+
+    // The database must not change while the entries are planned
+    const QList<Entry*> entries = m_db->rootGroup()->entriesRecursive(false);
+    const QList<Plan> plans = QtConcurrent::blockingMapped(
+        entries,
+        std::function<Plan(Entry*)>(std::bind(&planEntry, std::placeholders::_1, m_maxItems, m_maxSize, cutoff)));
+
+    QSet<QByteArray> keptAttachments;
+    QSet<QByteArray> removedAttachments;
+    for (const Plan& plan : plans) {
+        for (const QByteArray& attachment : plan.keptAttachments) {
+            keptAttachments.insert(attachment);
+        }
+        if (plan.removed.isEmpty()) {
+            continue;
+        }
+        ++report.entries;
+        report.historyItems += plan.removed.size();
+        report.reclaimedBytes += plan.removedSize;
+        for (const QByteArray& attachment : plan.removedAttachments) {
+            removedAttachments.insert(attachment);
+        }
+    }
+
+    // Attachments still used elsewhere stay in the binary pool
+    for (const QByteArray& attachment : asConst(removedAttachments)) {
+        if (!keptAttachments.contains(attachment)) {
+            ++report.attachments;
+            report.reclaimedBytes += attachment.size();
+        }
+    }
+
+    if (dryRun) {
+        return report;
+    }
+
+    for (const Plan& plan : plans) {
+        if (plan.removed.isEmpty()) {
+            continue;
+        }
+        // Cleaning up the history does not modify the entry itself
+        const bool updateTimeinfo = plan.entry->canUpdateTimeinfo();
+        plan.entry->setUpdateTimeinfo(false);
+        plan.entry->removeHistoryItems(plan.removed);
+        plan.entry->setUpdateTimeinfo(updateTimeinfo);
+    }
+
+    return report;
+}
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_HISTORYMAINTENANCE_H
+#define KEEPASSXC_HISTORYMAINTENANCE_H
+
+#include <QtGlobal>
+
+class Database;
+
+/**
+ * Applies the history limits of a database to all of its entries at once.
+ *
+ * Entries only truncate their own history when they are edited, so old databases
+ * keep history that no limit allows anymore. The maintenance removes history items
+ * that exceed the maximum number of items or the maximum size, or that are older
+ * than the maintenance history days. The entries are planned in parallel, the
+ * history items are removed on the calling thread.
+ *
+ * Attachments are stored once in the binary pool of the file. The report counts
+ * the attachments that no entry or history item refers to after the maintenance,
+ * they are dropped from the pool when the database is saved.
+ */
+class HistoryMaintenance
+{
+public:
+    struct Report
+    {
+        int entries = 0;
+        int historyItems = 0;
+        int attachments = 0;
+        qint64 reclaimedBytes = 0;
+
+        bool isEmpty() const;
+    };
+
+    explicit HistoryMaintenance(Database* db);
+
+    void setMaxItems(int maxItems);
+    void setMaxSize(int maxSize);
+    void setMaxAgeDays(int days);
+
+    Report run(bool dryRun = false);
+
+private:
+    Database* const m_db;
+    int m_maxItems;
+    int m_maxSize;
+    int m_maxAgeDays;
+};
+
+#endif // KEEPASSXC_HISTORYMAINTENANCE_H
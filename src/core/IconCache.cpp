@@ -0,0 +1,186 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IconCache.h"
+
+#include "core/Global.h"
+
+#include <QCoreApplication>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <functional>
+
+// 16 MiB holds several thousand 16x16 icons
+const int IconCache::DefaultMaxCost(16 * 1024);
+
+uint qHash(const IconCache::Key& key, uint seed)
+{
+    return qHash(key.uuid, seed) ^ qHash(key.size, seed);
+}
+
+IconCache::IconCache(QObject* parent)
+    : QObject(parent)
+    , m_cache(DefaultMaxCost)
+{
+}
+
+/**
+ * The instance is created on first use, the initialization of the static is thread-safe.
+ */
+IconCache* IconCache::instance()
+{
+    static IconCache* const instance = []() {
+        auto cache = new IconCache();
+        // The cache lives on the GUI thread even if first used by a worker
+        if (QCoreApplication::instance()) {
+            cache->moveToThread(QCoreApplication::instance()->thread());
+        }
+        return cache;
+    }();
+
+    return instance;
+}
+
+/**
+ * Get the pixmap of an icon scaled to size x size logical pixels.
+ * On a cache miss the image is decoded and scaled synchronously and cached.
+ *
+ * @param uuid uuid of the custom icon
+ * @param source encoded full size image of the icon
+ * @param size edge length of the scaled icon in pixels
+ * @return scaled pixmap or a null pixmap if the source cannot be decoded
+ */
+QPixmap IconCache::scaledPixmap(const QUuid& uuid, const Source& source, int size)
+{
+    if (source.data.isEmpty()) {
+        return QPixmap();
+    }
+
+    const Key key{uuid, size};
+    const Item* item = m_cache.object(key);
+    if (item && item->sourceKey == source.key) {
+        return item->pixmap;
+    }
+
+    const QImage scaled = scaleImage(source.data, size);
+    if (scaled.isNull()) {
+        return QPixmap();
+    }
+    return insert(key, scaled, source.key);
+}
+
+/**
+ * Decode and scale the given icons on the global thread pool and fill the cache
+ * with the results. Icons that are already cached or being scaled in this size are skipped.
+ *
+ * @param icons map of icon uuid to encoded full size image
+ * @param size edge length of the scaled icons in pixels
+ */
+void IconCache::prefetch(const QHash<QUuid, Source>& icons, int size)
+{
+    QList<ScaledImage> jobs;
+    for (auto it = icons.constBegin(); it != icons.constEnd(); ++it) {
+        const Key key{it.key(), size};
+        const Item* item = m_cache.object(key);
+        if (it.value().data.isEmpty() || m_pending.contains(key)
+            || (item && item->sourceKey == it.value().key)) {
+            continue;
+        }
+        m_pending.insert(key);
+        jobs.append({key, it.value(), QImage()});
+    }
+
+    if (jobs.isEmpty()) {
+        return;
+    }
+
+    auto* watcher = new QFutureWatcher<ScaledImage>(this);
+    connect(watcher, &QFutureWatcher<ScaledImage>::resultReadyAt, this, [this, watcher](int index) {
+        const ScaledImage result = watcher->resultAt(index);
+        m_pending.remove(result.key);
+        // Do not overwrite a pixmap that was produced synchronously in the meantime
+        const Item* item = m_cache.object(result.key);
+        if (!result.image.isNull() && (!item || item->sourceKey != result.source.key)) {
+            insert(result.key, result.image, result.source.key);
+        }
+    });
+    connect(watcher, &QFutureWatcher<ScaledImage>::finished, watcher, &QObject::deleteLater);
+
+    std::function<ScaledImage(const ScaledImage&)> scale = [size](const ScaledImage& job) {
+        return ScaledImage{job.key, job.source, scaleImage(job.source.data, size)};
+    };
+    watcher->setFuture(QtConcurrent::mapped(jobs, scale));
+}
+
+/**
+ * Drop all scaled variants of an icon, must be called whenever
+ * the image behind a uuid changes or the icon is removed.
+ * May be called from any thread, the cache is updated on the GUI thread.
+ */
+void IconCache::invalidate(const QUuid& uuid)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, "invalidate", Qt::QueuedConnection, Q_ARG(QUuid, uuid));
+        return;
+    }
+
+    for (int size : asConst(m_sizes)) {
+        m_cache.remove(Key{uuid, size});
+    }
+}
+
+void IconCache::clear()
+{
+    m_cache.clear();
+}
+
+int IconCache::maxCost() const
+{
+    return m_cache.maxCost();
+}
+
+/**
+ * @param kibibytes maximum amount of pixel memory the cache may hold
+ */
+void IconCache::setMaxCost(int kibibytes)
+{
+    m_cache.setMaxCost(kibibytes);
+}
+
+QImage IconCache::scaleImage(const QByteArray& data, int size)
+{
+    const QImage image = QImage::fromData(data);
+    if (image.isNull() || (image.width() == size && image.height() == size)) {
+        return image;
+    }
+    return image.scaled(size, size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+int IconCache::cost(const QPixmap& pixmap)
+{
+    return qMax(1, pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024);
+}
+
+QPixmap IconCache::insert(const Key& key, const QImage& scaled, qint64 sourceKey)
+{
+    const QPixmap pixmap = QPixmap::fromImage(scaled);
+    m_sizes.insert(key.size);
+    m_cache.insert(key, new Item{pixmap, sourceKey}, cost(pixmap));
+    return pixmap;
+}
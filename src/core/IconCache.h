@@ -0,0 +1,114 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_ICONCACHE_H
+#define KEEPASSXC_ICONCACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QUuid>
+
+/**
+ * Application wide LRU cache of pre-scaled custom icon pixmaps.
+ *
+ * Pixmaps are keyed by icon uuid and target size so that all models and
+ * views share the same scaled copies. Each cached
+ * pixmap remembers the key of the source it was produced from, so an icon
+ * that was replaced (or an equal uuid from another database) is never
+ * served stale. Sources are encoded images and only decoded on a miss.
+ *
+ * The cache must only be accessed from the GUI thread. Decoding and scaling
+ * for prefetch() happen on the global thread pool, only the final
+ * QImage -> QPixmap conversion runs on the GUI thread.
+ */
+class IconCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Source
+    {
+        // identifies the content of data, e.g. derived from its hash
+        qint64 key;
+        QByteArray data;
+    };
+
+    QPixmap scaledPixmap(const QUuid& uuid, const Source& source, int size);
+    void prefetch(const QHash<QUuid, Source>& icons, int size);
+    Q_INVOKABLE void invalidate(const QUuid& uuid);
+    void clear();
+
+    int maxCost() const;
+    void setMaxCost(int kibibytes);
+
+    static IconCache* instance();
+
+    static const int DefaultMaxCost;
+
+private:
+    struct Key
+    {
+        QUuid uuid;
+        int size;
+
+        bool operator==(const Key& other) const
+        {
+            return uuid == other.uuid && size == other.size;
+        }
+    };
+
+    struct Item
+    {
+        QPixmap pixmap;
+        qint64 sourceKey;
+    };
+
+    struct ScaledImage
+    {
+        Key key;
+        Source source;
+        QImage image;
+    };
+
+    explicit IconCache(QObject* parent = nullptr);
+
+    static QImage scaleImage(const QByteArray& data, int size);
+    static int cost(const QPixmap& pixmap);
+    QPixmap insert(const Key& key, const QImage& scaled, qint64 sourceKey);
+
+    friend uint qHash(const IconCache::Key& key, uint seed);
+    friend class TestIconCache;
+
+    QCache<Key, Item> m_cache;
+    // all sizes an icon may be cached in, an icon is invalidated by its uuid and these sizes
+    QSet<int> m_sizes;
+    // icons being scaled by prefetch() in a given size
+    QSet<Key> m_pending;
+
+    Q_DISABLE_COPY(IconCache)
+};
+
+inline IconCache* iconCache()
+{
+    return IconCache::instance();
+}
+
+#endif // KEEPASSXC_ICONCACHE_H
@@ -19,10 +19,13 @@
 #include "core/Config.h"
 #include "core/NetworkManager.h"
 
-#include <QHostInfo>
+#include <QBuffer>
+#include <QHostAddress>
+#include <QtConcurrent>
 #include <QtNetwork>
 
 #define MAX_REDIRECTS 5
+#define MAX_ICON_SIZE 128
 
 IconDownloader::IconDownloader(QObject* parent)
     : QObject(parent)
@@ -31,6 +34,7 @@ IconDownloader::IconDownloader(QObject* parent)
 {
     m_timeout.setSingleShot(true);
     connect(&m_timeout, SIGNAL(timeout()), SLOT(abortDownload()));
+    connect(&m_iconWatcher, SIGNAL(finished()), SLOT(iconProcessed()));
 }
 
 IconDownloader::~IconDownloader()
@@ -67,8 +71,36 @@ namespace
         QUrl url = convertVariantToUrl(var);
         return url;
     }
+
+    QUrl completeUrl(const QString& entryUrl)
+    {
+        QUrl url(entryUrl);
+        if (url.isValid() && url.scheme().isEmpty()) {
+            url.setUrl(QString("https://%1").arg(url.toString()));
+        }
+        return url;
+    }
+
+    QUrl faviconUrl(const QUrl& url, const QString& host)
+    {
+        QUrl favicon;
+        favicon.setScheme(url.scheme());
+        favicon.setHost(host);
+        favicon.setPort(url.port());
+        favicon.setPath("/favicon.ico");
+        return favicon;
+    }
 } // namespace
 
+/**
+ * @return the host an icon is downloaded for, downloads of the same host yield the same icon
+ */
+QString IconDownloader::hostOf(const QString& entryUrl)
+{
+    const QUrl url = completeUrl(entryUrl);
+    return url.port() < 0 ? url.host() : QString("%1:%2").arg(url.host()).arg(url.port());
+}
+
 void IconDownloader::setUrl(const QString& entryUrl)
 {
     m_url = entryUrl;
@@ -80,21 +112,12 @@ void IconDownloader::setUrl(const QString& entryUrl)
     m_redirects = 0;
     m_urlsToTry.clear();
 
-    if (url.scheme().isEmpty()) {
-        url.setUrl(QString("https://%1").arg(url.toString()));
-    }
+    url = completeUrl(m_url);
 
     QString fullyQualifiedDomain = url.host();
 
-    // Determine if host portion of URL is an IP address by resolving it and
-    // searching for a match with the returned address(es).
-    bool hostIsIp = false;
-    QList<QHostAddress> hostAddressess = QHostInfo::fromName(fullyQualifiedDomain).addresses();
-    for (const auto& addr : hostAddressess) {
-        if (addr.toString() == fullyQualifiedDomain) {
-            hostIsIp = true;
-        }
-    }
+    // Determine if host portion of URL is an IP address, without resolving it
+    const bool hostIsIp = !QHostAddress(fullyQualifiedDomain).isNull();
 
     // Determine the second-level domain, if available
     QString secondLevelDomain;
@@ -116,14 +139,22 @@ void IconDownloader::setUrl(const QString& entryUrl)
     }
 
     // Add a direct pull of the website's own favicon.ico file
-    m_urlsToTry.append(QUrl(url.scheme() + "://" + fullyQualifiedDomain + "/favicon.ico"));
+    m_urlsToTry.append(faviconUrl(url, fullyQualifiedDomain));
 
     // Also try a direct pull of the second-level domain (if possible)
     if (!hostIsIp && fullyQualifiedDomain != secondLevelDomain) {
-        m_urlsToTry.append(QUrl(url.scheme() + "://" + secondLevelDomain + "/favicon.ico"));
+        m_urlsToTry.append(faviconUrl(url, secondLevelDomain));
     }
 }
 
+/**
+ * @return PNG data of the icon passed to finished(), empty if the download failed
+ */
+QByteArray IconDownloader::iconData() const
+{
+    return m_iconData;
+}
+
 void IconDownloader::download()
 {
     if (!m_timeout.isActive()) {
@@ -146,6 +177,7 @@ void IconDownloader::abortDownload()
 void IconDownloader::fetchFavicon(const QUrl& url)
 {
     m_bytesReceived.clear();
+    m_iconData.clear();
     m_fetchUrl = url;
 
     QNetworkRequest request(url);
@@ -162,9 +194,6 @@ void IconDownloader::fetchReadyRead()
 
 void IconDownloader::fetchFinished()
 {
-    QImage image;
-    QString url = m_url;
-
     bool error = (m_reply->error() != QNetworkReply::NoError);
     QUrl redirectTarget = getRedirectTarget(m_reply);
 
@@ -184,21 +213,59 @@ void IconDownloader::fetchFinished()
             }
         } else {
             // No redirect, and we theoretically have some icon data now.
-            image.loadFromData(m_bytesReceived);
+            // Decode it in the background, favicons come in any size and format
+            m_iconWatcher.setFuture(QtConcurrent::run(&IconDownloader::processIcon, m_bytesReceived));
+            return;
         }
     }
 
-    if (!image.isNull()) {
+    fetchNext();
+}
+
+void IconDownloader::iconProcessed()
+{
+    const Icon icon = m_iconWatcher.result();
+    if (!icon.image.isNull()) {
         // Valid icon received
         m_timeout.stop();
-        emit finished(url, image);
-    } else if (!m_urlsToTry.empty()) {
+        m_iconData = icon.data;
+        emit finished(m_url, icon.image);
+    } else {
+        fetchNext();
+    }
+}
+
+void IconDownloader::fetchNext()
+{
+    if (!m_urlsToTry.empty()) {
         // Try the next url
         m_redirects = 0;
         fetchFavicon(m_urlsToTry.takeFirst());
     } else {
         // No icon found
         m_timeout.stop();
-        emit finished(url, image);
+        emit finished(m_url, QImage());
     }
 }
+
+/**
+ * Decode a downloaded icon, scale it down to at most 128x128 and encode it as PNG.
+ * Safe to call on a worker thread.
+ */
+IconDownloader::Icon IconDownloader::processIcon(const QByteArray& bytes)
+{
+    Icon icon;
+    if (!icon.image.loadFromData(bytes)) {
+        return icon;
+    }
+
+    // Don't add an icon larger than 128x128, but retain original size if smaller
+    if (icon.image.width() > MAX_ICON_SIZE || icon.image.height() > MAX_ICON_SIZE) {
+        icon.image = icon.image.scaled(MAX_ICON_SIZE, MAX_ICON_SIZE);
+    }
+
+    QBuffer buffer(&icon.data);
+    buffer.open(QIODevice::WriteOnly);
+    icon.image.save(&buffer, "PNG");
+    return icon;
+}
@@ -18,6 +18,7 @@
 #ifndef KEEPASSXC_ICONDOWNLOADER_H
 #define KEEPASSXC_ICONDOWNLOADER_H
 
+#include <QFutureWatcher>
 #include <QImage>
 #include <QObject>
 #include <QTimer>
@@ -38,6 +39,9 @@ public:
     void setUrl(const QString& entryUrl);
     void download();
 
+    static QString hostOf(const QString& entryUrl);
+    QByteArray iconData() const;
+
 signals:
     void finished(const QString& entryUrl, const QImage& image);
 
@@ -47,15 +51,26 @@ public slots:
 private slots:
     void fetchFinished();
     void fetchReadyRead();
+    void iconProcessed();
 
 private:
     void fetchFavicon(const QUrl& url);
+    void fetchNext();
+
+    struct Icon
+    {
+        QImage image;
+        QByteArray data;
+    };
+    static Icon processIcon(const QByteArray& bytes);
 
     QString m_url;
     QUrl m_fetchUrl;
     QList<QUrl> m_urlsToTry;
     QByteArray m_bytesReceived;
     QNetworkReply* m_reply;
+    QFutureWatcher<Icon> m_iconWatcher;
+    QByteArray m_iconData;
     QTimer m_timeout;
     int m_redirects;
 };
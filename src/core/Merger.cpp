@@ -21,6 +21,7 @@
 #include "core/Database.h"
 #include "core/Entry.h"
 #include "core/Metadata.h"
+#include "core/Tracing.h"
 
 Merger::Merger(const Database* sourceDb, Database* targetDb)
     : m_mode(Group::Default)
@@ -62,12 +63,15 @@ void Merger::resetForcedMergeMode()
 
 QStringList Merger::merge()
 {
+    TRACE_SPAN("Merger::merge", "merge");
     // Order of merge steps is important - it is possible that we
     // create some items before deleting them afterwards
     ChangeList changes;
+    m_context.m_targetDb->beginUpdate();
     changes << mergeGroup(m_context);
     changes << mergeDeletions(m_context);
     changes << mergeMetadata(m_context);
+    m_context.m_targetDb->endUpdate();
 
     // qDebug("Merged %s", qPrintable(changes.join("\n\t")));
 
@@ -615,8 +619,7 @@ Merger::ChangeList Merger::mergeMetadata(const MergeContext& context)
     const auto keys = sourceMetadata->customIcons().keys();
     for (QUuid customIconId : keys) {
         if (!targetMetadata->containsCustomIcon(customIconId)) {
-            QImage customIcon = sourceMetadata->customIcon(customIconId);
-            targetMetadata->addCustomIcon(customIconId, customIcon);
+            targetMetadata->addCustomIcon(customIconId, sourceMetadata->customIconData(customIconId));
             changes << tr("Adding missing icon %1").arg(QString::fromLatin1(customIconId.toRfc4122().toHex()));
         }
     }
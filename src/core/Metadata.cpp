@@ -18,9 +18,13 @@
 #include "Metadata.h"
 #include <QtCore/QCryptographicHash>
 
+#include <QBuffer>
+
 #include "core/Clock.h"
+#include "core/Endian.h"
 #include "core/Entry.h"
 #include "core/Group.h"
+#include "core/IconCache.h"
 #include "core/Tools.h"
 
 const int Metadata::DefaultHistoryMaxItems = 10;
@@ -161,9 +165,21 @@ bool Metadata::protectNotes() const
     return m_data.protectNotes;
 }
 
+/**
+ * Decode a custom icon. Icons are kept encoded, so every call decodes the
+ * image again. Views should use customIconPixmap() or customIconScaledPixmap().
+ */
 QImage Metadata::customIcon(const QUuid& uuid) const
 {
-    return m_customIcons.value(uuid);
+    return QImage::fromData(customIconData(uuid));
+}
+
+/**
+ * @return custom icon as stored in the database file, usually PNG
+ */
+QByteArray Metadata::customIconData(const QUuid& uuid) const
+{
+    return m_customIcons.value(uuid).data;
 }
 
 QPixmap Metadata::customIconPixmap(const QUuid& uuid) const
@@ -177,30 +193,21 @@ QPixmap Metadata::customIconPixmap(const QUuid& uuid) const
     QPixmapCache::Key& cacheKey = m_customIconCacheKeys[uuid];
 
     if (!QPixmapCache::find(cacheKey, &pixmap)) {
-        pixmap = QPixmap::fromImage(m_customIcons.value(uuid));
+        pixmap = QPixmap::fromImage(customIcon(uuid));
         cacheKey = QPixmapCache::insert(pixmap);
     }
 
     return pixmap;
 }
 
-QPixmap Metadata::customIconScaledPixmap(const QUuid& uuid) const
+QPixmap Metadata::customIconScaledPixmap(const QUuid& uuid, int size) const
 {
-    QPixmap pixmap;
-
     if (!m_customIcons.contains(uuid)) {
-        return pixmap;
+        return QPixmap();
     }
 
-    QPixmapCache::Key& cacheKey = m_customIconScaledCacheKeys[uuid];
-
-    if (!QPixmapCache::find(cacheKey, &pixmap)) {
-        QImage image = m_customIcons.value(uuid).scaled(16, 16, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-        pixmap = QPixmap::fromImage(image);
-        cacheKey = QPixmapCache::insert(pixmap);
-    }
-
-    return pixmap;
+    const CustomIcon& icon = m_customIcons[uuid];
+    return iconCache()->scaledPixmap(uuid, {icon.cacheKey, icon.data}, size);
 }
 
 bool Metadata::containsCustomIcon(const QUuid& uuid) const
@@ -208,20 +215,48 @@ bool Metadata::containsCustomIcon(const QUuid& uuid) const
     return m_customIcons.contains(uuid);
 }
 
-QHash<QUuid, QImage> Metadata::customIcons() const
+/**
+ * @return all custom icons as stored in the database file, usually PNG
+ */
+QHash<QUuid, QByteArray> Metadata::customIcons() const
 {
-    return m_customIcons;
+    QHash<QUuid, QByteArray> icons;
+    icons.reserve(m_customIcons.size());
+    for (auto it = m_customIcons.constBegin(); it != m_customIcons.constEnd(); ++it) {
+        icons.insert(it.key(), it.value().data);
+    }
+    return icons;
 }
 
+/**
+ * @return all custom icons scaled to the default size, the result is kept until the icons change
+ */
 QHash<QUuid, QPixmap> Metadata::customIconsScaledPixmaps() const
 {
-    QHash<QUuid, QPixmap> result;
-
-    for (const QUuid& uuid : m_customIconsOrder) {
-        result.insert(uuid, customIconScaledPixmap(uuid));
+    if (m_customIconsScaledPixmaps.size() != m_customIconsOrder.size()) {
+        m_customIconsScaledPixmaps.reserve(m_customIconsOrder.size());
+        for (const QUuid& uuid : m_customIconsOrder) {
+            if (!m_customIconsScaledPixmaps.contains(uuid)) {
+                m_customIconsScaledPixmaps.insert(uuid, customIconScaledPixmap(uuid));
+            }
+        }
     }
 
-    return result;
+    return m_customIconsScaledPixmaps;
+}
+
+/**
+ * Scale all custom icons in the background so that
+ * views can be populated from the icon cache.
+ */
+void Metadata::prefetchCustomIconsScaled(int size) const
+{
+    QHash<QUuid, IconCache::Source> icons;
+    icons.reserve(m_customIcons.size());
+    for (auto it = m_customIcons.constBegin(); it != m_customIcons.constEnd(); ++it) {
+        icons.insert(it.key(), {it.value().cacheKey, it.value().data});
+    }
+    iconCache()->prefetch(icons, size);
 }
 
 QList<QUuid> Metadata::customIconsOrder() const
@@ -378,19 +413,35 @@ void Metadata::setProtectNotes(bool value)
 }
 
 void Metadata::addCustomIcon(const QUuid& uuid, const QImage& icon)
+{
+    const QByteArray iconData = encodeIcon(icon);
+    if (iconData.isEmpty()) {
+        return;
+    }
+    addCustomIcon(uuid, iconData);
+}
+
+/**
+ * Add an encoded custom icon, the data is not decoded until a view needs the icon
+ * and is written to the database file as is.
+ */
+void Metadata::addCustomIcon(const QUuid& uuid, const QByteArray& iconData)
 {
     Q_ASSERT(!uuid.isNull());
     Q_ASSERT(!m_customIcons.contains(uuid));
 
-    m_customIcons[uuid] = icon;
+    // Associate data hash to uuid
+    const QByteArray hash = hashIcon(iconData);
+    // The content hash doubles as icon cache key, a replaced icon is never served stale
+    const qint64 cacheKey = Endian::bytesToSizedInt<qint64>(hash.left(8), QSysInfo::LittleEndian);
+    m_customIcons[uuid] = {iconData, hash, cacheKey};
     // reset cache in case there is also an icon with that uuid
     m_customIconCacheKeys[uuid] = QPixmapCache::Key();
-    m_customIconScaledCacheKeys[uuid] = QPixmapCache::Key();
+    m_customIconsScaledPixmaps.remove(uuid);
+    iconCache()->invalidate(uuid);
     // remove all uuids to prevent duplicates in release mode
     m_customIconsOrder.removeAll(uuid);
     m_customIconsOrder.append(uuid);
-    // Associate image hash to uuid
-    QByteArray hash = hashImage(icon);
     m_customIconsHashes[hash] = uuid;
     Q_ASSERT(m_customIcons.count() == m_customIconsOrder.count());
     emit metadataModified();
@@ -416,7 +467,7 @@ void Metadata::removeCustomIcon(const QUuid& uuid)
     Q_ASSERT(m_customIcons.contains(uuid));
 
     // Remove hash record only if this is the same uuid
-    QByteArray hash = hashImage(m_customIcons[uuid]);
+    const QByteArray hash = m_customIcons[uuid].hash;
     if (m_customIconsHashes.contains(hash) && m_customIconsHashes[hash] == uuid) {
         m_customIconsHashes.remove(hash);
     }
@@ -424,8 +475,8 @@ void Metadata::removeCustomIcon(const QUuid& uuid)
     m_customIcons.remove(uuid);
     QPixmapCache::remove(m_customIconCacheKeys.value(uuid));
     m_customIconCacheKeys.remove(uuid);
-    QPixmapCache::remove(m_customIconScaledCacheKeys.value(uuid));
-    m_customIconScaledCacheKeys.remove(uuid);
+    m_customIconsScaledPixmaps.remove(uuid);
+    iconCache()->invalidate(uuid);
     m_customIconsOrder.removeAll(uuid);
     Q_ASSERT(m_customIcons.count() == m_customIconsOrder.count());
     emit metadataModified();
@@ -433,8 +484,16 @@ void Metadata::removeCustomIcon(const QUuid& uuid)
 
 QUuid Metadata::findCustomIcon(const QImage& candidate)
 {
-    QByteArray hash = hashImage(candidate);
-    return m_customIconsHashes.value(hash, QUuid());
+    const QByteArray candidateData = encodeIcon(candidate);
+    if (candidateData.isEmpty()) {
+        return QUuid();
+    }
+    return findCustomIcon(candidateData);
+}
+
+QUuid Metadata::findCustomIcon(const QByteArray& candidateData)
+{
+    return m_customIconsHashes.value(hashIcon(candidateData), QUuid());
 }
 
 void Metadata::copyCustomIcons(const QSet<QUuid>& iconList, const Metadata* otherMetadata)
@@ -443,19 +502,30 @@ void Metadata::copyCustomIcons(const QSet<QUuid>& iconList, const Metadata* othe
         Q_ASSERT(otherMetadata->containsCustomIcon(uuid));
 
         if (!containsCustomIcon(uuid) && otherMetadata->containsCustomIcon(uuid)) {
-            addCustomIcon(uuid, otherMetadata->customIcon(uuid));
+            addCustomIcon(uuid, otherMetadata->customIconData(uuid));
         }
     }
 }
 
-QByteArray Metadata::hashImage(const QImage& image)
+/**
+ * @return the icon encoded as PNG, empty if it cannot be encoded
+ */
+QByteArray Metadata::encodeIcon(const QImage& icon)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    if (!icon.save(&buffer, "PNG")) {
+        qWarning("Unable to encode a custom icon as PNG");
+        return QByteArray();
+    }
+    buffer.close();
+    return data;
+}
+
+QByteArray Metadata::hashIcon(const QByteArray& iconData)
 {
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-    auto data = QByteArray(reinterpret_cast<const char*>(image.bits()), static_cast<int>(image.sizeInBytes()));
-#else
-    auto data = QByteArray(reinterpret_cast<const char*>(image.bits()), image.byteCount());
-#endif
-    return QCryptographicHash::hash(data, QCryptographicHash::Md5);
+    return QCryptographicHash::hash(iconData, QCryptographicHash::Md5);
 }
 
 void Metadata::setRecycleBinEnabled(bool value)
@@ -79,13 +79,15 @@ public:
     bool protectUrl() const;
     bool protectNotes() const;
     QImage customIcon(const QUuid& uuid) const;
+    QByteArray customIconData(const QUuid& uuid) const;
     QPixmap customIconPixmap(const QUuid& uuid) const;
-    QPixmap customIconScaledPixmap(const QUuid& uuid) const;
+    QPixmap customIconScaledPixmap(const QUuid& uuid, int size = 16) const;
     bool containsCustomIcon(const QUuid& uuid) const;
-    QHash<QUuid, QImage> customIcons() const;
+    QHash<QUuid, QByteArray> customIcons() const;
     QList<QUuid> customIconsOrder() const;
     bool recycleBinEnabled() const;
     QHash<QUuid, QPixmap> customIconsScaledPixmaps() const;
+    void prefetchCustomIconsScaled(int size = 16) const;
     Group* recycleBin();
     const Group* recycleBin() const;
     QDateTime recycleBinChanged() const;
@@ -120,10 +122,12 @@ public:
     void setProtectUrl(bool value);
     void setProtectNotes(bool value);
     void addCustomIcon(const QUuid& uuid, const QImage& icon);
+    void addCustomIcon(const QUuid& uuid, const QByteArray& iconData);
     void addCustomIconScaled(const QUuid& uuid, const QImage& icon);
     void removeCustomIcon(const QUuid& uuid);
     void copyCustomIcons(const QSet<QUuid>& iconList, const Metadata* otherMetadata);
     QUuid findCustomIcon(const QImage& candidate);
+    QUuid findCustomIcon(const QByteArray& candidateData);
     void setRecycleBinEnabled(bool value);
     void setRecycleBin(Group* group);
     void setRecycleBinChanged(const QDateTime& value);
@@ -154,13 +158,23 @@ private:
     template <class P, class V> bool set(P& property, const V& value);
     template <class P, class V> bool set(P& property, const V& value, QDateTime& dateTime);
 
-    QByteArray hashImage(const QImage& image);
+    static QByteArray encodeIcon(const QImage& icon);
+    static QByteArray hashIcon(const QByteArray& iconData);
+
+    struct CustomIcon
+    {
+        // icon as stored in the database file, usually PNG
+        QByteArray data;
+        QByteArray hash;
+        qint64 cacheKey;
+    };
 
     MetadataData m_data;
 
-    QHash<QUuid, QImage> m_customIcons;
+    QHash<QUuid, CustomIcon> m_customIcons;
     mutable QHash<QUuid, QPixmapCache::Key> m_customIconCacheKeys;
-    mutable QHash<QUuid, QPixmapCache::Key> m_customIconScaledCacheKeys;
+    // scaled pixmaps of all custom icons, filled on demand from the icon cache
+    mutable QHash<QUuid, QPixmap> m_customIconsScaledPixmaps;
     QList<QUuid> m_customIconsOrder;
     QHash<QByteArray, QUuid> m_customIconsHashes;
 
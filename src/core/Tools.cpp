@@ -207,12 +207,26 @@ namespace Tools
 
     bool isBase64(const QByteArray& ba)
     {
-        constexpr auto pattern = R"(^(?:[a-z0-9+/]{4})*(?:[a-z0-9+/]{3}=|[a-z0-9+/]{2}==)?$)";
-        QRegExp regexp(pattern, Qt::CaseInsensitive, QRegExp::RegExp2);
+        // Called for every timestamp of a KDBX 4 database, so avoid a regular expression
+        if (ba.size() % 4 != 0) {
+            return false;
+        }
+
+        int padding = 0;
+        if (ba.endsWith("==")) {
+            padding = 2;
+        } else if (ba.endsWith('=')) {
+            padding = 1;
+        }
 
-        QString base64 = QString::fromLatin1(ba.constData(), ba.size());
+        for (int i = 0; i < ba.size() - padding; ++i) {
+            const uchar c = static_cast<uchar>(ba.at(i));
+            if (!(std::isalnum(c) && c < 0x80) && c != '+' && c != '/') {
+                return false;
+            }
+        }
 
-        return regexp.exactMatch(base64);
+        return true;
     }
 
     void sleep(int ms)
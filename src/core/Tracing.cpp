@@ -0,0 +1,172 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Tracing.h"
+
+#include "core/Global.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+namespace Tracing
+{
+    const QString EnvironmentVariable("KEEPASSXC_TRACE");
+
+    namespace
+    {
+        struct Event
+        {
+            QByteArray name;
+            const char* category;
+            qint64 start;
+            qint64 duration;
+            int thread;
+        };
+
+        struct Trace
+        {
+            QMutex mutex;
+            QString fileName;
+            QElapsedTimer clock;
+            QVector<Event> events;
+            QHash<Qt::HANDLE, int> threads;
+            Qt::HANDLE mainThread = nullptr;
+        };
+
+        QAtomicInt s_enabled(0);
+
+        Trace& trace()
+        {
+            static Trace trace;
+            return trace;
+        }
+    } // namespace
+
+    /**
+     * Start recording spans, they are written to fileName when the application exits.
+     * Calling start() while tracing is already running has no effect.
+     */
+    void start(const QString& fileName)
+    {
+        if (fileName.isEmpty() || isEnabled()) {
+            return;
+        }
+
+        Trace& t = trace();
+        QMutexLocker locker(&t.mutex);
+        t.fileName = fileName;
+        t.mainThread = QThread::currentThreadId();
+        t.clock.start();
+        s_enabled.storeRelease(1);
+        qAddPostRoutine(finish);
+    }
+
+    void startFromEnvironment()
+    {
+        start(QString::fromLocal8Bit(qgetenv(EnvironmentVariable.toLatin1().constData())));
+    }
+
+    /**
+     * Stop recording and write all spans recorded so far as Chrome trace event JSON.
+     */
+    void finish()
+    {
+        if (!s_enabled.testAndSetOrdered(1, 0)) {
+            return;
+        }
+
+        Trace& t = trace();
+        QMutexLocker locker(&t.mutex);
+        const qint64 pid = QCoreApplication::applicationPid();
+
+        QJsonArray events;
+        for (auto it = t.threads.constBegin(); it != t.threads.constEnd(); ++it) {
+            QJsonObject args;
+            args["name"] = it.key() == t.mainThread ? QString("main") : QString("worker %1").arg(it.value());
+            QJsonObject event;
+            event["name"] = QString("thread_name");
+            event["ph"] = QString("M");
+            event["pid"] = pid;
+            event["tid"] = it.value();
+            event["args"] = args;
+            events.append(event);
+        }
+        for (const Event& e : asConst(t.events)) {
+            QJsonObject event;
+            event["name"] = QString::fromUtf8(e.name);
+            event["cat"] = QString::fromLatin1(e.category);
+            event["ph"] = QString("X");
+            // Chrome traces use microseconds
+            event["ts"] = e.start / 1000.0;
+            event["dur"] = e.duration / 1000.0;
+            event["pid"] = pid;
+            event["tid"] = e.thread;
+            events.append(event);
+        }
+
+        QJsonObject root;
+        root["traceEvents"] = events;
+        root["displayTimeUnit"] = QString("ms");
+
+        QFile file(t.fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning("Unable to write trace to %s: %s", qPrintable(t.fileName), qPrintable(file.errorString()));
+        } else {
+            file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        }
+        t.events.clear();
+        t.threads.clear();
+    }
+
+    bool isEnabled()
+    {
+        return s_enabled.loadAcquire() != 0;
+    }
+
+    Span::Span(const QByteArray& name, const char* category)
+        : m_name(name)
+        , m_category(category)
+        , m_start(isEnabled() ? trace().clock.nsecsElapsed() : -1)
+    {
+    }
+
+    Span::~Span()
+    {
+        if (m_start < 0 || !isEnabled()) {
+            return;
+        }
+
+        Trace& t = trace();
+        const qint64 end = t.clock.nsecsElapsed();
+        const Qt::HANDLE threadId = QThread::currentThreadId();
+
+        QMutexLocker locker(&t.mutex);
+        auto thread = t.threads.constFind(threadId);
+        if (thread == t.threads.constEnd()) {
+            thread = t.threads.insert(threadId, t.threads.size() + 1);
+        }
+        t.events.append({m_name, m_category, m_start, end - m_start, thread.value()});
+    }
+} // namespace Tracing
@@ -0,0 +1,87 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_TRACING_H
+#define KEEPASSXC_TRACING_H
+
+#include "config-keepassx.h"
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * Records timed spans of hot paths and writes them as a Chrome trace
+ * (chrome://tracing, Perfetto) when the application exits.
+ *
+ * Tracing is started with the --trace <file> command line option or the
+ * KEEPASSXC_TRACE environment variable. While it is not started, a span
+ * costs a single atomic load and its name is not evaluated. Builds configured
+ * without WITH_XC_TRACING compile all TRACE_SPAN() statements away.
+ */
+namespace Tracing
+{
+    extern const QString EnvironmentVariable;
+
+    void start(const QString& fileName);
+    void startFromEnvironment();
+    void finish();
+    bool isEnabled();
+
+    inline QByteArray spanName(const char* name)
+    {
+        return QByteArray(name);
+    }
+
+    inline QByteArray spanName(const QString& name)
+    {
+        return name.toUtf8();
+    }
+
+    class Span
+    {
+    public:
+        Span(const QByteArray& name, const char* category);
+        ~Span();
+
+    private:
+        QByteArray m_name;
+        const char* m_category;
+        qint64 m_start;
+
+        Q_DISABLE_COPY(Span)
+    };
+} // namespace Tracing
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef WITH_XC_TRACING
+/**
+ * Record the time from this statement to the end of the enclosing scope.
+ * @param name span name, either a string literal or a QString, only evaluated while tracing is enabled
+ * @param category comma separated categories, used for filtering in the viewer
+ */
+#define TRACE_SPAN(name, category)                                                                                     \
+    const Tracing::Span TRACE_CONCAT(traceSpan, __LINE__)(                                                             \
+        Tracing::isEnabled() ? Tracing::spanName(name) : QByteArray(), category)
+#else
+#define TRACE_SPAN(name, category)                                                                                     \
+    do {                                                                                                               \
+    } while (false)
+#endif
+
+#endif // KEEPASSXC_TRACING_H
@@ -25,6 +25,7 @@
 #include "core/Config.h"
 #include "core/Database.h"
 #include "core/Tools.h"
+#include "core/Tracing.h"
 #include "gui/DatabaseTabWidget.h"
 #include "gui/DatabaseWidget.h"
 
@@ -419,6 +420,7 @@ namespace FdoSecrets
 
     void Collection::onDatabaseLockChanged()
     {
+        TRACE_SPAN("Collection::onDatabaseLockChanged", "plugins,fdosecrets");
         auto locked = backendLocked();
         if (!locked) {
             populateContents();
@@ -481,6 +483,10 @@ namespace FdoSecrets
             onDatabaseExposedGroupChanged();
         });
 
+        // Change notifications are suppressed during bulk updates, send them once afterwards
+        m_updateConnection =
+            connect(m_backend->database().data(), &Database::updateFinished, this, &Collection::onDatabaseUpdated);
+
         // Add items for existing entry
         const auto entries = m_exposedGroup->entriesRecursive(false);
         for (const auto& entry : entries) {
@@ -504,6 +510,18 @@ namespace FdoSecrets
         populateContents();
     }
 
+    void Collection::onDatabaseUpdated(const DatabaseChanges& changes)
+    {
+        for (const auto& item : asConst(m_items)) {
+            if (item->backend() && changes.modifiedEntries.contains(item->backend()->uuid())) {
+                emit itemChanged(item);
+            }
+        }
+        if (!changes.isEmpty()) {
+            emit collectionChanged();
+        }
+    }
+
     void Collection::onEntryAdded(Entry* entry, bool emitSignal)
     {
         if (inRecycleBin(entry)) {
@@ -540,7 +558,11 @@ namespace FdoSecrets
             return;
         }
 
-        connect(group, &Group::groupModified, this, &Collection::collectionChanged);
+        connect(group, &Group::groupModified, this, [this, group]() {
+            if (!group->database() || !group->database()->isUpdating()) {
+                emit collectionChanged();
+            }
+        });
         connect(group, &Group::entryAdded, this, [this](Entry* entry) { onEntryAdded(entry, true); });
 
         const auto children = group->children();
@@ -593,6 +615,7 @@ namespace FdoSecrets
         if (m_exposedGroup) {
             m_exposedGroup->disconnect(this);
         }
+        disconnect(m_updateConnection);
         m_items.clear();
     }
 
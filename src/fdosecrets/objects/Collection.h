@@ -27,6 +27,7 @@
 #include <QSet>
 
 class Database;
+struct DatabaseChanges;
 class DatabaseWidget;
 class Entry;
 class Group;
@@ -106,6 +107,7 @@ namespace FdoSecrets
     private slots:
         void onDatabaseLockChanged();
         void onDatabaseExposedGroupChanged();
+        void onDatabaseUpdated(const DatabaseChanges& changes);
         void reloadBackend();
 
     private:
@@ -142,6 +144,7 @@ namespace FdoSecrets
         QPointer<DatabaseWidget> m_backend;
         QString m_backendPath;
         QPointer<Group> m_exposedGroup;
+        QMetaObject::Connection m_updateConnection;
 
         QSet<QString> m_aliases;
         QList<Item*> m_items;
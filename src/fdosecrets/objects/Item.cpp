@@ -56,7 +56,13 @@ namespace FdoSecrets
         registerWithPath(QStringLiteral(DBUS_PATH_TEMPLATE_ITEM).arg(p()->objectPath().path(), m_backend->uuidToHex()),
                          new ItemAdaptor(this));
 
-        connect(m_backend.data(), &Entry::entryModified, this, &Item::itemChanged);
+        connect(m_backend.data(), &Entry::entryModified, this, [this]() {
+            // changes during bulk updates are reported by the collection
+            auto group = m_backend ? m_backend->group() : nullptr;
+            if (!group || !group->database() || !group->database()->isUpdating()) {
+                emit itemChanged();
+            }
+        });
     }
 
     DBusReturn<bool> Item::locked() const
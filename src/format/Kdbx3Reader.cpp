@@ -20,6 +20,7 @@
 
 #include "core/Endian.h"
 #include "core/Group.h"
+#include "core/Tracing.h"
 #include "crypto/CryptoHash.h"
 #include "format/KdbxXmlReader.h"
 #include "format/KeePass2RandomStream.h"
@@ -34,6 +35,7 @@ bool Kdbx3Reader::readDatabaseImpl(QIODevice* device,
                                    QSharedPointer<const CompositeKey> key,
                                    Database* db)
 {
+    TRACE_SPAN("Kdbx3Reader::readDatabaseImpl", "format");
     Q_ASSERT(m_kdbxVersion <= KeePass2::FILE_VERSION_3_1);
 
     if (hasError()) {
@@ -95,9 +97,10 @@ bool Kdbx3Reader::readDatabaseImpl(QIODevice* device,
     if (db->compressionAlgorithm() == Database::CompressionNone) {
         xmlDevice = &hashedStream;
     } else {
-        ioCompressor.reset(new QtIOCompressor(&hashedStream));
+        ioCompressor.reset(new QtIOCompressor(&hashedStream, 6, KeePass2::INFLATE_BUFFER_SIZE));
         ioCompressor->setStreamFormat(QtIOCompressor::GzipFormat);
-        if (!ioCompressor->open(QIODevice::ReadOnly)) {
+        // inflate directly into the reader's buffer instead of going through QIODevice's buffer
+        if (!ioCompressor->open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
             raiseError(ioCompressor->errorString());
             return false;
         }
@@ -21,17 +21,19 @@
 #include <QBuffer>
 
 #include "core/Database.h"
+#include "core/Tracing.h"
 #include "crypto/CryptoHash.h"
 #include "crypto/Random.h"
 #include "format/KdbxXmlWriter.h"
 #include "format/KeePass2.h"
 #include "format/KeePass2RandomStream.h"
 #include "streams/HashedBlockStream.h"
-#include "streams/QtIOCompressor"
+#include "streams/ParallelGzipStream.h"
 #include "streams/SymmetricCipherStream.h"
 
 bool Kdbx3Writer::writeDatabase(QIODevice* device, Database* db)
 {
+    TRACE_SPAN("Kdbx3Writer::writeDatabase", "format");
     m_error = false;
     m_errorStr.clear();
 
@@ -46,7 +48,7 @@ bool Kdbx3Writer::writeDatabase(QIODevice* device, Database* db)
         return false;
     }
 
-    if (!db->setKey(db->key(), false, true)) {
+    if (!transformKey(db)) {
         raiseError(tr("Unable to calculate master key"));
         return false;
     }
@@ -111,13 +113,12 @@ bool Kdbx3Writer::writeDatabase(QIODevice* device, Database* db)
     }
 
     QIODevice* outputDevice = nullptr;
-    QScopedPointer<QtIOCompressor> ioCompressor;
+    QScopedPointer<ParallelGzipStream> ioCompressor;
 
     if (db->compressionAlgorithm() == Database::CompressionNone) {
         outputDevice = &hashedStream;
     } else {
-        ioCompressor.reset(new QtIOCompressor(&hashedStream));
-        ioCompressor->setStreamFormat(QtIOCompressor::GzipFormat);
+        ioCompressor.reset(new ParallelGzipStream(&hashedStream));
         if (!ioCompressor->open(QIODevice::WriteOnly)) {
             raiseError(ioCompressor->errorString());
             return false;
@@ -138,8 +139,9 @@ bool Kdbx3Writer::writeDatabase(QIODevice* device, Database* db)
 
     // Explicitly close/reset streams so they are flushed and we can detect
     // errors. QIODevice::close() resets errorString() etc.
-    if (ioCompressor) {
-        ioCompressor->close();
+    if (ioCompressor && !ioCompressor->reset()) {
+        raiseError(ioCompressor->errorString());
+        return false;
     }
     if (!hashedStream.reset()) {
         raiseError(hashedStream.errorString());
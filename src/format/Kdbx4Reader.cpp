@@ -21,6 +21,7 @@
 
 #include "core/Endian.h"
 #include "core/Group.h"
+#include "core/Tracing.h"
 #include "crypto/CryptoHash.h"
 #include "format/KdbxXmlReader.h"
 #include "format/KeePass2RandomStream.h"
@@ -33,6 +34,7 @@ bool Kdbx4Reader::readDatabaseImpl(QIODevice* device,
                                    QSharedPointer<const CompositeKey> key,
                                    Database* db)
 {
+    TRACE_SPAN("Kdbx4Reader::readDatabaseImpl", "format");
     Q_ASSERT(m_kdbxVersion == KeePass2::FILE_VERSION_4);
 
     m_binaryPool.clear();
@@ -103,9 +105,10 @@ bool Kdbx4Reader::readDatabaseImpl(QIODevice* device,
     if (db->compressionAlgorithm() == Database::CompressionNone) {
         xmlDevice = &cipherStream;
     } else {
-        ioCompressor.reset(new QtIOCompressor(&cipherStream));
+        ioCompressor.reset(new QtIOCompressor(&cipherStream, 6, KeePass2::INFLATE_BUFFER_SIZE));
         ioCompressor->setStreamFormat(QtIOCompressor::GzipFormat);
-        if (!ioCompressor->open(QIODevice::ReadOnly)) {
+        // inflate directly into the reader's buffer instead of going through QIODevice's buffer
+        if (!ioCompressor->open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
             raiseError(ioCompressor->errorString());
             return false;
         }
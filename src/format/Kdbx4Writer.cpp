@@ -23,16 +23,18 @@
 #include "core/CustomData.h"
 #include "core/Database.h"
 #include "core/Metadata.h"
+#include "core/Tracing.h"
 #include "crypto/CryptoHash.h"
 #include "crypto/Random.h"
 #include "format/KdbxXmlWriter.h"
 #include "format/KeePass2RandomStream.h"
 #include "streams/HmacBlockStream.h"
-#include "streams/QtIOCompressor"
+#include "streams/ParallelGzipStream.h"
 #include "streams/SymmetricCipherStream.h"
 
 bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
 {
+    TRACE_SPAN("Kdbx4Writer::writeDatabase", "format");
     m_error = false;
     m_errorStr.clear();
 
@@ -52,7 +54,7 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
     QByteArray protectedStreamKey = randomGen()->randomArray(64);
     QByteArray endOfHeader = "\r\n\r\n";
 
-    if (!db->setKey(db->key(), false, true)) {
+    if (!transformKey(db)) {
         raiseError(tr("Unable to calculate master key"));
         return false;
     }
@@ -137,13 +139,12 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
     }
 
     QIODevice* outputDevice = nullptr;
-    QScopedPointer<QtIOCompressor> ioCompressor;
+    QScopedPointer<ParallelGzipStream> ioCompressor;
 
     if (db->compressionAlgorithm() == Database::CompressionNone) {
         outputDevice = cipherStream.data();
     } else {
-        ioCompressor.reset(new QtIOCompressor(cipherStream.data()));
-        ioCompressor->setStreamFormat(QtIOCompressor::GzipFormat);
+        ioCompressor.reset(new ParallelGzipStream(cipherStream.data()));
         if (!ioCompressor->open(QIODevice::WriteOnly)) {
             raiseError(ioCompressor->errorString());
             return false;
@@ -176,8 +177,9 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
 
     // Explicitly close/reset streams so they are flushed and we can detect
     // errors. QIODevice::close() resets errorString() etc.
-    if (ioCompressor) {
-        ioCompressor->close();
+    if (ioCompressor && !ioCompressor->reset()) {
+        raiseError(ioCompressor->errorString());
+        return false;
     }
     if (!cipherStream->reset()) {
         raiseError(cipherStream->errorString());
@@ -76,6 +76,32 @@ void KdbxWriter::extractDatabase(QByteArray& xmlOutput, Database* db)
     writer.writeDatabase(&buffer, db);
 }
 
+/**
+ * Keep the KDF seed and the transformed key of the database instead of deriving
+ * a fresh one on write. Only meant for databases whose key was restored with
+ * Database::setTransformedKey(), the master seed is still random on every write.
+ *
+ * @param reuse true to skip the KDF if the database has a transformed key
+ */
+void KdbxWriter::setReuseTransformedKey(bool reuse)
+{
+    m_reuseTransformedKey = reuse;
+}
+
+/**
+ * Transform the database key with a newly randomized KDF seed unless
+ * the transformed key should be reused.
+ *
+ * @return true on success
+ */
+bool KdbxWriter::transformKey(Database* db)
+{
+    if (m_reuseTransformedKey && !db->transformedMasterKey().isEmpty()) {
+        return true;
+    }
+    return db->setKey(db->key(), false, true);
+}
+
 /**
  * Raise an error. Use in case of an unexpected write error.
  *
@@ -58,6 +58,7 @@ public:
     virtual quint32 formatVersion() = 0;
 
     void extractDatabase(QByteArray& xmlOutput, Database* db);
+    void setReuseTransformedKey(bool reuse);
 
     bool hasError() const;
     QString errorString() const;
@@ -89,9 +90,11 @@ protected:
 
     bool writeData(QIODevice* device, const QByteArray& data);
     void raiseError(const QString& errorMessage);
+    bool transformKey(Database* db);
 
     bool m_error = false;
     QString m_errorStr = "";
+    bool m_reuseTransformedKey = false;
 };
 
 #endif // KEEPASSXC_KDBXWRITER_H
@@ -24,6 +24,7 @@
 #include "core/Global.h"
 #include "core/Group.h"
 #include "core/Tools.h"
+#include "core/Tracing.h"
 #include "streams/QtIOCompressor"
 
 #include <QBuffer>
@@ -85,6 +86,7 @@ QSharedPointer<Database> KdbxXmlReader::readDatabase(QIODevice* device)
  */
 void KdbxXmlReader::readDatabase(QIODevice* device, Database* db, KeePass2RandomStream* randomStream)
 {
+    TRACE_SPAN("KdbxXmlReader::readDatabase", "format,xml");
     m_error = false;
     m_errorStr.clear();
 
@@ -100,6 +102,11 @@ void KdbxXmlReader::readDatabase(QIODevice* device, Database* db, KeePass2Random
 
     m_tmpParent.reset(new Group());
 
+    m_internedKeys.clear();
+    for (const QString& key : EntryAttributes::DefaultAttributes) {
+        m_internedKeys.insert(key);
+    }
+
     bool rootGroupParsed = false;
 
     if (m_xml.hasError()) {
@@ -150,14 +157,19 @@ void KdbxXmlReader::readDatabase(QIODevice* device, Database* db, KeePass2Random
         iGroup.value()->setUpdateTimeinfo(true);
     }
 
+    // entries were built with their signals blocked, the tree is complete now
     QHash<QUuid, Entry*>::const_iterator iEntry;
     for (iEntry = m_entries.constBegin(); iEntry != m_entries.constEnd(); ++iEntry) {
         iEntry.value()->setUpdateTimeinfo(true);
+        iEntry.value()->setSignalsBlocked(false);
 
         const QList<Entry*> historyItems = iEntry.value()->historyItems();
         for (Entry* histEntry : historyItems) {
             histEntry->setUpdateTimeinfo(true);
+            histEntry->setSignalsBlocked(false);
         }
+        // history items were read one by one, let them share unchanged values
+        iEntry.value()->shareHistoryData();
     }
 }
 
@@ -350,7 +362,7 @@ void KdbxXmlReader::parseIcon()
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "Icon");
 
     QUuid uuid;
-    QImage icon;
+    QByteArray iconData;
     bool uuidSet = false;
     bool iconSet = false;
 
@@ -359,7 +371,8 @@ void KdbxXmlReader::parseIcon()
             uuid = readUuid();
             uuidSet = !uuid.isNull();
         } else if (m_xml.name() == "Data") {
-            icon.loadFromData(readBinary());
+            // Decoded on demand, most icons are never displayed
+            iconData = readBinary();
             iconSet = true;
         } else {
             skipCurrentElement();
@@ -371,7 +384,7 @@ void KdbxXmlReader::parseIcon()
         if (m_meta->containsCustomIcon(uuid)) {
             uuid = QUuid::createUuid();
         }
-        m_meta->addCustomIcon(uuid, icon);
+        m_meta->addCustomIcon(uuid, iconData);
         return;
     }
 
@@ -424,7 +437,7 @@ void KdbxXmlReader::parseCustomDataItem(CustomData* customData)
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
         if (m_xml.name() == "Key") {
-            key = readString();
+            key = internKey(readString());
             keySet = true;
         } else if (m_xml.name() == "Value") {
             value = readString();
@@ -599,11 +612,16 @@ Group* KdbxXmlReader::parseGroup()
     }
 
     if (!group->uuid().isNull()) {
-        Group* tmpGroup = group;
-        group = getGroup(tmpGroup->uuid());
-        group->copyDataFrom(tmpGroup);
-        group->setUpdateTimeinfo(false);
-        delete tmpGroup;
+        Group* placeholder = m_groups.value(group->uuid());
+        if (placeholder) {
+            // the group was referenced before, fill the placeholder instead
+            placeholder->copyDataFrom(group);
+            placeholder->setUpdateTimeinfo(false);
+            delete group;
+            group = placeholder;
+        } else {
+            m_groups.insert(group->uuid(), group);
+        }
     } else if (!hasError()) {
         raiseError(tr("No group uuid found"));
     }
@@ -674,6 +692,7 @@ Entry* KdbxXmlReader::parseEntry(bool history)
 
     auto entry = new Entry();
     entry->setUpdateTimeinfo(false);
+    entry->setSignalsBlocked(true);
     QList<Entry*> historyItems;
     QList<StringPair> binaryRefs;
 
@@ -766,14 +785,14 @@ Entry* KdbxXmlReader::parseEntry(bool history)
     if (!entry->uuid().isNull()) {
         if (history) {
             entry->setUpdateTimeinfo(false);
+        } else if (Entry* placeholder = m_entries.value(entry->uuid())) {
+            // the entry was referenced before, fill the placeholder instead
+            placeholder->copyDataFrom(entry);
+            placeholder->setUpdateTimeinfo(false);
+            delete entry;
+            entry = placeholder;
         } else {
-            Entry* tmpEntry = entry;
-
-            entry = getEntry(tmpEntry->uuid());
-            entry->copyDataFrom(tmpEntry);
-            entry->setUpdateTimeinfo(false);
-
-            delete tmpEntry;
+            m_entries.insert(entry->uuid(), entry);
         }
     } else if (!hasError()) {
         raiseError(tr("No entry uuid found"));
@@ -809,13 +828,12 @@ void KdbxXmlReader::parseEntryString(Entry* entry)
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
         if (m_xml.name() == "Key") {
-            key = readString();
+            key = internKey(readString());
             keySet = true;
             continue;
         }
 
         if (m_xml.name() == "Value") {
-            QXmlStreamAttributes attr = m_xml.attributes();
             bool isProtected;
             bool protectInMemory;
             value = readString(isProtected, protectInMemory);
@@ -853,7 +871,7 @@ QPair<QString, QString> KdbxXmlReader::parseEntryBinary(Entry* entry)
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
         if (m_xml.name() == "Key") {
-            key = readString();
+            key = internKey(readString());
             keySet = true;
             continue;
         }
@@ -938,6 +956,9 @@ QList<Entry*> KdbxXmlReader::parseEntryHistory()
     Q_ASSERT(m_xml.isStartElement() && m_xml.name() == "History");
 
     QList<Entry*> historyItems;
+    if (m_meta->historyMaxItems() > 0) {
+        historyItems.reserve(m_meta->historyMaxItems());
+    }
 
     while (!m_xml.hasError() && m_xml.readNextStartElement()) {
         if (m_xml.name() == "Entry") {
@@ -1028,11 +1049,17 @@ bool KdbxXmlReader::readBool()
 
 QDateTime KdbxXmlReader::readDateTime()
 {
+    static const QDateTime epoch(QDate(1, 1, 1), QTime(0, 0, 0, 0), Qt::UTC);
+
     QString str = readString();
-    if (Tools::isBase64(str.toLatin1())) {
-        QByteArray secsBytes = QByteArray::fromBase64(str.toUtf8()).leftJustified(8, '\0', true).left(8);
+    const QByteArray latin1 = str.toLatin1();
+    if (Tools::isBase64(latin1)) {
+        QByteArray secsBytes = QByteArray::fromBase64(latin1);
+        if (secsBytes.size() != 8) {
+            secsBytes = secsBytes.leftJustified(8, '\0', true);
+        }
         qint64 secs = Endian::bytesToSizedInt<quint64>(secsBytes, KeePass2::BYTEORDER);
-        return QDateTime(QDate(1, 1, 1), QTime(0, 0, 0, 0), Qt::UTC).addSecs(secs);
+        return epoch.addSecs(secs);
     }
 
     QDateTime dt = Clock::parse(str, Qt::ISODate);
@@ -1182,12 +1209,29 @@ Entry* KdbxXmlReader::getEntry(const QUuid& uuid)
 
     auto entry = new Entry();
     entry->setUpdateTimeinfo(false);
+    entry->setSignalsBlocked(true);
     entry->setUuid(uuid);
     entry->setGroup(m_tmpParent.data());
     m_entries.insert(uuid, entry);
     return entry;
 }
 
+/**
+ * Share a single copy of each attribute key, they repeat in every entry and history item.
+ *
+ * @param key key as read from the XML
+ * @return shared copy of the key
+ */
+QString KdbxXmlReader::internKey(const QString& key)
+{
+    const auto it = m_internedKeys.constFind(key);
+    if (it != m_internedKeys.constEnd()) {
+        return *it;
+    }
+    m_internedKeys.insert(key);
+    return key;
+}
+
 void KdbxXmlReader::skipCurrentElement()
 {
     qWarning("KdbxXmlReader::skipCurrentElement: skip element \"%s\"", qPrintable(m_xml.name().toString()));
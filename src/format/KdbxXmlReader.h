@@ -24,6 +24,7 @@
 
 #include <QCoreApplication>
 #include <QPair>
+#include <QSet>
 #include <QString>
 #include <QXmlStreamReader>
 
@@ -93,6 +94,7 @@ protected:
 
     virtual Group* getGroup(const QUuid& uuid);
     virtual Entry* getEntry(const QUuid& uuid);
+    virtual QString internKey(const QString& key);
 
     virtual bool isTrueValue(const QStringRef& value);
     virtual void raiseError(const QString& errorMessage);
@@ -109,6 +111,7 @@ protected:
     QScopedPointer<Group> m_tmpParent;
     QHash<QUuid, Group*> m_groups;
     QHash<QUuid, Entry*> m_entries;
+    QSet<QString> m_internedKeys;
 
     QHash<QString, QByteArray> m_binaryPool;
     QHash<QString, QPair<Entry*, QString>> m_binaryMap;
@@ -22,9 +22,34 @@
 
 #include "core/Endian.h"
 #include "core/Metadata.h"
+#include "core/Tracing.h"
 #include "format/KeePass2RandomStream.h"
 #include "streams/QtIOCompressor"
 
+namespace
+{
+    // The XML is collected in a buffer of this size before it is passed to the compression and cipher streams
+    const int WriteBufferSize = 1024 * 1024;
+
+    /**
+     * Whether the string may contain codepoints that are invalid in XML 1.0.
+     * The loop has no branches, so the compiler can vectorise the common case of valid text.
+     */
+    bool maybeInvalidXml10(const QString& str)
+    {
+        const ushort* data = str.utf16();
+        const int size = str.size();
+        int suspicious = 0;
+        for (int i = 0; i < size; ++i) {
+            const ushort uc = data[i];
+            suspicious |= (uc < 0x20) & (uc != 0x09) & (uc != 0x0A) & (uc != 0x0D);
+            suspicious |= static_cast<ushort>(uc - 0x7F) <= 0x20;
+            suspicious |= uc >= 0xD800;
+        }
+        return suspicious != 0;
+    }
+} // namespace
+
 /**
  * @param version KDBX version
  */
@@ -38,6 +63,7 @@ void KdbxXmlWriter::writeDatabase(QIODevice* device,
                                   KeePass2RandomStream* randomStream,
                                   const QByteArray& headerHash)
 {
+    TRACE_SPAN("KdbxXmlWriter::writeDatabase", "format,xml");
     m_db = db;
     m_meta = db->metadata();
     m_randomStream = randomStream;
@@ -49,7 +75,11 @@ void KdbxXmlWriter::writeDatabase(QIODevice* device,
 
     generateIdMap();
 
-    m_xml.setDevice(device);
+    m_device = device;
+    m_buffer.buffer().reserve(WriteBufferSize);
+    m_buffer.open(QIODevice::WriteOnly);
+
+    m_xml.setDevice(&m_buffer);
     m_xml.writeStartDocument("1.0", true);
     m_xml.writeStartElement("KeePassFile");
 
@@ -59,7 +89,12 @@ void KdbxXmlWriter::writeDatabase(QIODevice* device,
     m_xml.writeEndElement();
     m_xml.writeEndDocument();
 
-    if (m_xml.hasError()) {
+    flushBuffer(true);
+    m_xml.setDevice(nullptr);
+    m_buffer.close();
+    m_device = nullptr;
+
+    if (m_xml.hasError() && !m_error) {
         raiseError(device->errorString());
     }
 }
@@ -71,6 +106,26 @@ void KdbxXmlWriter::writeDatabase(const QString& filename, Database* db)
     writeDatabase(&file, db);
 }
 
+/**
+ * Pass the buffered XML on to the output device once the buffer is full.
+ *
+ * @param force write the buffer even if it is not full
+ */
+void KdbxXmlWriter::flushBuffer(bool force)
+{
+    QByteArray& data = m_buffer.buffer();
+    if (data.isEmpty() || (!force && data.size() < WriteBufferSize)) {
+        return;
+    }
+
+    if (!m_error && m_device->write(data) != data.size()) {
+        raiseError(m_device->errorString());
+    }
+    // keeps the reserved capacity
+    data.resize(0);
+    m_buffer.seek(0);
+}
+
 bool KdbxXmlWriter::hasError()
 {
     return m_error;
@@ -156,25 +211,18 @@ void KdbxXmlWriter::writeCustomIcons()
 
     const QList<QUuid> customIconsOrder = m_meta->customIconsOrder();
     for (const QUuid& uuid : customIconsOrder) {
-        writeIcon(uuid, m_meta->customIcon(uuid));
+        writeIcon(uuid, m_meta->customIconData(uuid));
     }
 
     m_xml.writeEndElement();
 }
 
-void KdbxXmlWriter::writeIcon(const QUuid& uuid, const QImage& icon)
+void KdbxXmlWriter::writeIcon(const QUuid& uuid, const QByteArray& iconData)
 {
     m_xml.writeStartElement("Icon");
 
     writeUuid("UUID", uuid);
-
-    QByteArray ba;
-    QBuffer buffer(&ba);
-    buffer.open(QIODevice::WriteOnly);
-    // TODO: check !icon.save()
-    icon.save(&buffer, "PNG");
-    buffer.close();
-    writeBinary("Data", ba);
+    writeBinary("Data", iconData);
 
     m_xml.writeEndElement();
 }
@@ -212,9 +260,10 @@ void KdbxXmlWriter::writeBinaries()
         }
 
         if (!data.isEmpty()) {
-            m_xml.writeCharacters(QString::fromLatin1(data.toBase64()));
+            m_xml.writeCharacters(encodeBase64(data));
         }
         m_xml.writeEndElement();
+        flushBuffer();
     }
 
     m_xml.writeEndElement();
@@ -288,6 +337,7 @@ void KdbxXmlWriter::writeGroup(const Group* group)
     const QList<Entry*>& entryList = group->entries();
     for (const Entry* entry : entryList) {
         writeEntry(entry);
+        flushBuffer();
     }
 
     const QList<Group*>& children = group->children();
@@ -368,27 +418,25 @@ void KdbxXmlWriter::writeEntry(const Entry* entry)
         writeString("Key", key);
 
         m_xml.writeStartElement("Value");
-        QString value;
-
-        if (protect) {
-            if (!m_innerStreamProtectionDisabled && m_randomStream) {
-                m_xml.writeAttribute("Protected", "True");
-                bool ok;
-                QByteArray rawData = m_randomStream->process(entry->attributes()->value(key).toUtf8(), &ok);
-                if (!ok) {
-                    raiseError(m_randomStream->errorString());
-                }
-                value = QString::fromLatin1(rawData.toBase64());
-            } else {
-                m_xml.writeAttribute("ProtectInMemory", "True");
-                value = entry->attributes()->value(key);
+        const QString value = entry->attributes()->value(key);
+
+        if (protect && !m_innerStreamProtectionDisabled && m_randomStream) {
+            m_xml.writeAttribute("Protected", "True");
+            QByteArray rawData = value.toUtf8();
+            if (!m_randomStream->processInPlace(rawData)) {
+                raiseError(m_randomStream->errorString());
+            }
+            // base64 never contains invalid XML characters
+            if (!rawData.isEmpty()) {
+                m_xml.writeCharacters(encodeBase64(rawData));
             }
         } else {
-            value = entry->attributes()->value(key);
-        }
-
-        if (!value.isEmpty()) {
-            m_xml.writeCharacters(stripInvalidXml10Chars(value));
+            if (protect) {
+                m_xml.writeAttribute("ProtectInMemory", "True");
+            }
+            if (!value.isEmpty()) {
+                m_xml.writeCharacters(stripInvalidXml10Chars(value));
+            }
         }
         m_xml.writeEndElement();
 
@@ -488,25 +536,24 @@ void KdbxXmlWriter::writeDateTime(const QString& qualifiedName, const QDateTime&
     Q_ASSERT(dateTime.isValid());
     Q_ASSERT(dateTime.timeSpec() == Qt::UTC);
 
-    QString dateTimeStr;
     if (m_kdbxVersion < KeePass2::FILE_VERSION_4) {
-        dateTimeStr = dateTime.toString(Qt::ISODate);
+        QString dateTimeStr = dateTime.toString(Qt::ISODate);
 
         // Qt < 4.8 doesn't append a 'Z' at the end
         if (!dateTimeStr.isEmpty() && dateTimeStr[dateTimeStr.size() - 1] != 'Z') {
             dateTimeStr.append('Z');
         }
+        writeString(qualifiedName, dateTimeStr);
     } else {
-        qint64 secs = QDateTime(QDate(1, 1, 1), QTime(0, 0, 0, 0), Qt::UTC).secsTo(dateTime);
-        QByteArray secsBytes = Endian::sizedIntToBytes(secs, KeePass2::BYTEORDER);
-        dateTimeStr = QString::fromLatin1(secsBytes.toBase64());
+        static const QDateTime epoch(QDate(1, 1, 1), QTime(0, 0, 0, 0), Qt::UTC);
+        qint64 secs = epoch.secsTo(dateTime);
+        writeBinary(qualifiedName, Endian::sizedIntToBytes(secs, KeePass2::BYTEORDER));
     }
-    writeString(qualifiedName, dateTimeStr);
 }
 
 void KdbxXmlWriter::writeUuid(const QString& qualifiedName, const QUuid& uuid)
 {
-    writeString(qualifiedName, uuid.toRfc4122().toBase64());
+    writeBinary(qualifiedName, uuid.toRfc4122());
 }
 
 void KdbxXmlWriter::writeUuid(const QString& qualifiedName, const Group* group)
@@ -529,7 +576,11 @@ void KdbxXmlWriter::writeUuid(const QString& qualifiedName, const Entry* entry)
 
 void KdbxXmlWriter::writeBinary(const QString& qualifiedName, const QByteArray& ba)
 {
-    writeString(qualifiedName, QString::fromLatin1(ba.toBase64()));
+    if (ba.isEmpty()) {
+        m_xml.writeEmptyElement(qualifiedName);
+    } else {
+        m_xml.writeTextElement(qualifiedName, encodeBase64(ba));
+    }
 }
 
 void KdbxXmlWriter::writeColor(const QString& qualifiedName, const QColor& color)
@@ -569,8 +620,44 @@ QString KdbxXmlWriter::colorPartToString(int value)
     return str;
 }
 
+/**
+ * Base64 encode into a reused buffer instead of allocating a new string per value.
+ * The result is only valid until the next call.
+ */
+const QString& KdbxXmlWriter::encodeBase64(const QByteArray& data)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    const auto* in = reinterpret_cast<const uchar*>(data.constData());
+    const int size = data.size();
+    m_base64.resize((size + 2) / 3 * 4);
+    QChar* out = m_base64.data();
+
+    int i = 0;
+    for (; i + 2 < size; i += 3) {
+        const uint triple = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+        *out++ = QLatin1Char(alphabet[(triple >> 18) & 0x3F]);
+        *out++ = QLatin1Char(alphabet[(triple >> 12) & 0x3F]);
+        *out++ = QLatin1Char(alphabet[(triple >> 6) & 0x3F]);
+        *out++ = QLatin1Char(alphabet[triple & 0x3F]);
+    }
+    if (i < size) {
+        const uint triple = (in[i] << 16) | (i + 1 < size ? in[i + 1] << 8 : 0);
+        *out++ = QLatin1Char(alphabet[(triple >> 18) & 0x3F]);
+        *out++ = QLatin1Char(alphabet[(triple >> 12) & 0x3F]);
+        *out++ = i + 1 < size ? QLatin1Char(alphabet[(triple >> 6) & 0x3F]) : QLatin1Char('=');
+        *out++ = QLatin1Char('=');
+    }
+
+    return m_base64;
+}
+
 QString KdbxXmlWriter::stripInvalidXml10Chars(QString str)
 {
+    if (!maybeInvalidXml10(str)) {
+        return str;
+    }
+
     for (int i = str.size() - 1; i >= 0; i--) {
         const QChar ch = str.at(i);
         const ushort uc = ch.unicode();
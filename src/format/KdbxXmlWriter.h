@@ -18,9 +18,9 @@
 #ifndef KEEPASSX_KDBXXMLWRITER_H
 #define KEEPASSX_KDBXXMLWRITER_H
 
+#include <QBuffer>
 #include <QColor>
 #include <QDateTime>
-#include <QImage>
 #include <QXmlStreamWriter>
 
 #include "core/Database.h"
@@ -48,11 +48,12 @@ public:
 
 private:
     void generateIdMap();
+    void flushBuffer(bool force = false);
 
     void writeMetadata();
     void writeMemoryProtection();
     void writeCustomIcons();
-    void writeIcon(const QUuid& uuid, const QImage& icon);
+    void writeIcon(const QUuid& uuid, const QByteArray& iconData);
     void writeBinaries();
     void writeCustomData(const CustomData* customData);
     void writeCustomDataItem(const QString& key, const QString& value);
@@ -77,6 +78,7 @@ private:
     void writeColor(const QString& qualifiedName, const QColor& color);
     void writeTriState(const QString& qualifiedName, Group::TriState triState);
     QString colorPartToString(int value);
+    const QString& encodeBase64(const QByteArray& data);
     QString stripInvalidXml10Chars(QString str);
 
     void raiseError(const QString& errorMessage);
@@ -86,6 +88,9 @@ private:
     bool m_innerStreamProtectionDisabled = false;
 
     QXmlStreamWriter m_xml;
+    QIODevice* m_device = nullptr;
+    QBuffer m_buffer;
+    QString m_base64;
     QPointer<const Database> m_db;
     QPointer<const Metadata> m_meta;
     KeePass2RandomStream* m_randomStream = nullptr;
@@ -17,9 +17,13 @@
 
 #include "KeePass1Reader.h"
 
+#include <QBuffer>
 #include <QFile>
 #include <QImage>
 #include <QTextCodec>
+#include <QtConcurrent>
+
+#include <functional>
 
 #include "core/Database.h"
 #include "core/Endian.h"
@@ -163,17 +167,34 @@ KeePass1Reader::readDatabase(QIODevice* device, const QString& password, QIODevi
     kdf->setSeed(m_transformSeed);
     db->setKdf(kdf);
 
-    qint64 contentPos = m_device->pos();
+    // The content is read once and shared by the key trials of all password encodings
+    const QByteArray content = m_device->readAll();
+    QFuture<KeyTrial> trials = startKeyTrials(password, keyfileData, content);
 
-    QScopedPointer<SymmetricCipherStream> cipherStream(testKeys(password, keyfileData, contentPos));
+    QByteArray plaintext;
+    if (!finishKeyTrials(trials, plaintext)) {
+        return {};
+    }
 
-    if (!cipherStream) {
+    // The master key of the imported database needs its own transformation, only pay for it with valid credentials
+    auto key = QSharedPointer<CompositeKey>::create();
+    if (!password.isEmpty()) {
+        key->addKey(QSharedPointer<PasswordKey>::create(password));
+    }
+    if (keyfileDevice) {
+        key->addKey(newFileKey);
+    }
+    if (!db->setKey(key)) {
+        raiseError(tr("Unable to calculate master key"));
         return {};
     }
 
+    QBuffer contentBuffer(&plaintext);
+    contentBuffer.open(QIODevice::ReadOnly);
+
     QList<Group*> groups;
     for (quint32 i = 0; i < numGroups; i++) {
-        Group* group = readGroup(cipherStream.data());
+        Group* group = readGroup(&contentBuffer);
         if (!group) {
             return {};
         }
@@ -182,7 +203,7 @@ KeePass1Reader::readDatabase(QIODevice* device, const QString& password, QIODevi
 
     QList<Entry*> entries;
     for (quint32 i = 0; i < numEntries; i++) {
-        Entry* entry = readEntry(cipherStream.data());
+        Entry* entry = readEntry(&contentBuffer);
         if (!entry) {
             return {};
         }
@@ -233,19 +254,6 @@ KeePass1Reader::readDatabase(QIODevice* device, const QString& password, QIODevi
         entry->setUpdateTimeinfo(true);
     }
 
-    auto key = QSharedPointer<CompositeKey>::create();
-    if (!password.isEmpty()) {
-        key->addKey(QSharedPointer<PasswordKey>::create(password));
-    }
-    if (keyfileDevice) {
-        key->addKey(newFileKey);
-    }
-
-    if (!db->setKey(key)) {
-        raiseError(tr("Unable to calculate master key"));
-        return {};
-    }
-
     return db;
 }
 
@@ -293,128 +301,146 @@ QString KeePass1Reader::errorString()
     return m_errorStr;
 }
 
-SymmetricCipherStream*
-KeePass1Reader::testKeys(const QString& password, const QByteArray& keyfileData, qint64 contentPos)
+/**
+ * Start deriving and verifying the keys of all candidate password encodings
+ * on the global thread pool.
+ *
+ * @param password user supplied password
+ * @param keyfileData contents of the key file
+ * @param content encrypted database content following the header
+ * @return trials in the order the encodings should be preferred
+ */
+QFuture<KeePass1Reader::KeyTrial>
+KeePass1Reader::startKeyTrials(const QString& password, const QByteArray& keyfileData, const QByteArray& content)
 {
     const QList<PasswordEncoding> encodings = {Windows1252, Latin1, UTF8};
 
-    QScopedPointer<SymmetricCipherStream> cipherStream;
-    QByteArray passwordData;
+    QList<QByteArray> candidates;
     QTextCodec* codec = QTextCodec::codecForName("Windows-1252");
     QByteArray passwordDataCorrect = codec->fromUnicode(password);
 
     for (PasswordEncoding encoding : encodings) {
         if (encoding == Windows1252) {
-            passwordData = passwordDataCorrect;
+            candidates.append(passwordDataCorrect);
         } else if (encoding == Latin1) {
             // KeePassX used Latin-1 encoding for passwords until version 0.3.1
             // but KeePass/Win32 uses Windows Codepage 1252.
-            passwordData = password.toLatin1();
+            QByteArray passwordData = password.toLatin1();
 
-            if (passwordData == passwordDataCorrect) {
-                continue;
-            } else {
+            if (passwordData != passwordDataCorrect) {
                 qWarning("Testing password encoded as Latin-1.");
+                candidates.append(passwordData);
             }
         } else if (encoding == UTF8) {
             // KeePassX used UTF-8 encoding for passwords until version 0.2.2
             // but KeePass/Win32 uses Windows Codepage 1252.
-            passwordData = password.toUtf8();
+            QByteArray passwordData = password.toUtf8();
 
-            if (passwordData == passwordDataCorrect) {
-                continue;
-            } else {
+            if (passwordData != passwordDataCorrect) {
                 qWarning("Testing password encoded as UTF-8.");
+                candidates.append(passwordData);
             }
         }
+    }
 
-        QByteArray finalKey = key(passwordData, keyfileData);
-        if (finalKey.isEmpty()) {
-            return nullptr;
-        }
-        if (m_encryptionFlags & KeePass1::Rijndael) {
-            cipherStream.reset(new SymmetricCipherStream(
-                m_device, SymmetricCipher::Aes256, SymmetricCipher::Cbc, SymmetricCipher::Decrypt));
-        } else {
-            cipherStream.reset(new SymmetricCipherStream(
-                m_device, SymmetricCipher::Twofish, SymmetricCipher::Cbc, SymmetricCipher::Decrypt));
-        }
-
-        if (!cipherStream->init(finalKey, m_encryptionIV)) {
-            raiseError(cipherStream->errorString());
-            return nullptr;
-        }
-        if (!cipherStream->open(QIODevice::ReadOnly)) {
-            raiseError(cipherStream->errorString());
-            return nullptr;
-        }
-
-        bool success = verifyKey(cipherStream.data());
+    const QSharedPointer<Kdf> kdf = m_db->kdf();
+    std::function<KeyTrial(const QByteArray&)> trial = [this, keyfileData, content, kdf](const QByteArray& data) {
+        return tryKey(data, keyfileData, content, kdf);
+    };
+    return QtConcurrent::mapped(candidates, trial);
+}
 
-        cipherStream->reset();
-        cipherStream->close();
-        if (!m_device->seek(contentPos)) {
-            QString msg = tr("unable to seek to content position");
-            if (!m_device->errorString().isEmpty()) {
-                msg.append("\n").append(m_device->errorString());
-            }
-            raiseError(msg);
+/**
+ * Wait for the key trials and pick the first verified one.
+ *
+ * @param trials trials returned by startKeyTrials()
+ * @param plaintext receives the decrypted content on success
+ * @return true if one of the keys was correct
+ */
+bool KeePass1Reader::finishKeyTrials(QFuture<KeyTrial>& trials, QByteArray& plaintext)
+{
+    trials.waitForFinished();
 
-            return nullptr;
+    const QList<KeyTrial> results = trials.results();
+    for (const KeyTrial& trial : results) {
+        if (!trial.errorString.isEmpty()) {
+            raiseError(trial.errorString);
+            return false;
         }
-        cipherStream->open(QIODevice::ReadOnly);
-
-        if (success) {
-            break;
-        } else {
-            cipherStream.reset();
+        if (trial.verified) {
+            plaintext = trial.plaintext;
+            return true;
         }
     }
 
-    if (!cipherStream) {
-        raiseError(tr("Invalid credentials were provided, please try again.\n"
-                      "If this reoccurs, then your database file may be corrupt."));
-    }
-
-    return cipherStream.take();
+    raiseError(tr("Invalid credentials were provided, please try again.\n"
+                  "If this reoccurs, then your database file may be corrupt."));
+    return false;
 }
 
-QByteArray KeePass1Reader::key(const QByteArray& password, const QByteArray& keyfileData)
+/**
+ * Derive the key for one password encoding and verify it against the content hash.
+ * Runs on a worker thread and must not modify the reader.
+ */
+KeePass1Reader::KeyTrial KeePass1Reader::tryKey(const QByteArray& password,
+                                                const QByteArray& keyfileData,
+                                                const QByteArray& content,
+                                                const QSharedPointer<Kdf>& kdf) const
 {
     Q_ASSERT(!m_masterSeed.isEmpty());
     Q_ASSERT(!m_transformSeed.isEmpty());
 
+    KeyTrial result;
+
     KeePass1Key key;
     key.setPassword(password);
     key.setKeyfileData(keyfileData);
 
     QByteArray transformedKey;
-    bool result = key.transform(*m_db->kdf(), transformedKey);
-
-    if (!result) {
-        raiseError(tr("Key transformation failed"));
-        return QByteArray();
+    if (!key.transform(*kdf, transformedKey)) {
+        result.errorString = tr("Key transformation failed");
+        return result;
     }
 
     CryptoHash hash(CryptoHash::Sha256);
     hash.addData(m_masterSeed);
     hash.addData(transformedKey);
-    return hash.result();
-}
+    const QByteArray finalKey = hash.result();
 
-bool KeePass1Reader::verifyKey(SymmetricCipherStream* cipherStream)
-{
-    CryptoHash contentHash(CryptoHash::Sha256);
-    QByteArray buffer;
+    QBuffer buffer;
+    buffer.setData(content);
+    buffer.open(QIODevice::ReadOnly);
+
+    QScopedPointer<SymmetricCipherStream> cipherStream;
+    if (m_encryptionFlags & KeePass1::Rijndael) {
+        cipherStream.reset(new SymmetricCipherStream(
+            &buffer, SymmetricCipher::Aes256, SymmetricCipher::Cbc, SymmetricCipher::Decrypt));
+    } else {
+        cipherStream.reset(new SymmetricCipherStream(
+            &buffer, SymmetricCipher::Twofish, SymmetricCipher::Cbc, SymmetricCipher::Decrypt));
+    }
+
+    if (!cipherStream->init(finalKey, m_encryptionIV) || !cipherStream->open(QIODevice::ReadOnly)) {
+        result.errorString = cipherStream->errorString();
+        return result;
+    }
 
+    CryptoHash contentHash(CryptoHash::Sha256);
+    QByteArray chunk;
     do {
-        if (!Tools::readFromDevice(cipherStream, buffer)) {
-            return false;
+        if (!Tools::readFromDevice(cipherStream.data(), chunk)) {
+            // Wrong keys usually fail on the padding
+            return result;
         }
-        contentHash.addData(buffer);
-    } while (!buffer.isEmpty());
+        contentHash.addData(chunk);
+        result.plaintext.append(chunk);
+    } while (!chunk.isEmpty());
 
-    return contentHash.result() == m_contentHashHeader;
+    result.verified = contentHash.result() == m_contentHashHeader;
+    if (!result.verified) {
+        result.plaintext.clear();
+    }
+    return result;
 }
 
 Group* KeePass1Reader::readGroup(QIODevice* cipherStream)
@@ -20,13 +20,14 @@
 
 #include <QCoreApplication>
 #include <QDateTime>
+#include <QFuture>
 #include <QHash>
 #include <QSharedPointer>
 
 class Database;
 class Entry;
 class Group;
-class SymmetricCipherStream;
+class Kdf;
 class QIODevice;
 
 class KeePass1Reader
@@ -49,9 +50,19 @@ private:
         UTF8
     };
 
-    SymmetricCipherStream* testKeys(const QString& password, const QByteArray& keyfileData, qint64 contentPos);
-    QByteArray key(const QByteArray& password, const QByteArray& keyfileData);
-    bool verifyKey(SymmetricCipherStream* cipherStream);
+    struct KeyTrial
+    {
+        QByteArray plaintext;
+        bool verified = false;
+        QString errorString;
+    };
+
+    QFuture<KeyTrial> startKeyTrials(const QString& password, const QByteArray& keyfileData, const QByteArray& content);
+    bool finishKeyTrials(QFuture<KeyTrial>& trials, QByteArray& plaintext);
+    KeyTrial tryKey(const QByteArray& password,
+                    const QByteArray& keyfileData,
+                    const QByteArray& content,
+                    const QSharedPointer<Kdf>& kdf) const;
     Group* readGroup(QIODevice* cipherStream);
     Entry* readEntry(QIODevice* cipherStream);
     void parseNotes(const QString& rawNotes, Entry* entry);
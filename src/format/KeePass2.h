@@ -46,6 +46,9 @@ namespace KeePass2
 
     const QSysInfo::Endian BYTEORDER = QSysInfo::LittleEndian;
 
+    // Read the compressed payload in large blocks to reduce the calls into the cipher stream
+    constexpr int INFLATE_BUFFER_SIZE = 1024 * 1024;
+
     extern const QUuid CIPHER_AES128;
     extern const QUuid CIPHER_AES256;
     extern const QUuid CIPHER_TWOFISH;
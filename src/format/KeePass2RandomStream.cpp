@@ -68,35 +68,36 @@ QByteArray KeePass2RandomStream::randomBytes(int size, bool* ok)
 
 QByteArray KeePass2RandomStream::process(const QByteArray& data, bool* ok)
 {
-    bool randomBytesOk;
-
-    QByteArray randomData = randomBytes(data.size(), &randomBytesOk);
-    if (!randomBytesOk) {
+    QByteArray result(data);
+    if (!processInPlace(result)) {
         *ok = false;
         return QByteArray();
     }
 
-    QByteArray result;
-    result.resize(data.size());
-
-    for (int i = 0; i < data.size(); i++) {
-        result[i] = data[i] ^ randomData[i];
-    }
-
     *ok = true;
     return result;
 }
 
 bool KeePass2RandomStream::processInPlace(QByteArray& data)
 {
-    bool ok;
-    QByteArray randomData = randomBytes(data.size(), &ok);
-    if (!ok) {
-        return false;
-    }
+    // XOR directly with the key stream block instead of copying the random bytes first
+    char* bytes = data.data();
+    int processed = 0;
 
-    for (int i = 0; i < data.size(); i++) {
-        data[i] = data[i] ^ randomData[i];
+    while (processed < data.size()) {
+        if (m_buffer.size() == m_offset) {
+            if (!loadBlock()) {
+                return false;
+            }
+        }
+
+        const int count = qMin(data.size() - processed, m_buffer.size() - m_offset);
+        const char* keyStream = m_buffer.constData() + m_offset;
+        for (int i = 0; i < count; ++i) {
+            bytes[processed + i] ^= keyStream[i];
+        }
+        m_offset += count;
+        processed += count;
     }
 
     return true;
@@ -105,6 +105,7 @@ bool KeePass2Writer::writeDatabase(QIODevice* device, Database* db)
         m_writer.reset(new Kdbx4Writer());
     }
 
+    m_writer->setReuseTransformedKey(m_reuseTransformedKey);
     return m_writer->writeDatabase(device, db);
 }
 
@@ -124,6 +125,14 @@ void KeePass2Writer::extractDatabase(Database* db, QByteArray& xmlOutput)
     m_writer->extractDatabase(xmlOutput, db);
 }
 
+/**
+ * Keep the KDF seed and transformed key of the database, see KdbxWriter::setReuseTransformedKey().
+ */
+void KeePass2Writer::setReuseTransformedKey(bool reuse)
+{
+    m_reuseTransformedKey = reuse;
+}
+
 bool KeePass2Writer::hasError() const
 {
     return m_error || (m_writer && m_writer->hasError());
@@ -34,6 +34,7 @@ public:
     bool writeDatabase(const QString& filename, Database* db);
     bool writeDatabase(QIODevice* device, Database* db);
     void extractDatabase(Database* db, QByteArray& xmlOutput);
+    void setReuseTransformedKey(bool reuse);
 
     QSharedPointer<KdbxWriter> writer() const;
     quint32 version() const;
@@ -47,6 +48,7 @@ private:
 
     bool m_error = false;
     QString m_errorStr = "";
+    bool m_reuseTransformedKey = false;
 
     QScopedPointer<KdbxWriter> m_writer;
     quint32 m_version = 0;
@@ -27,9 +27,13 @@
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QThread>
 #include <QUuid>
+#include <QtConcurrent>
 #include <gcrypt.h>
 
+#include <functional>
+
 OpVaultReader::OpVaultReader(QObject* parent)
     : QObject(parent)
     , m_error(false)
@@ -107,40 +111,46 @@ Database* OpVaultReader::readDatabase(QDir& opdataDir, const QString& password)
 
     const QString bandChars("0123456789ABCDEF");
     QString bandPattern("band_%1.js");
+    QStringList bandFiles;
     for (QChar ch : bandChars) {
-        QFile bandFile(defaultDir.filePath(bandPattern.arg(ch)));
-        if (!bandFile.exists()) {
-            qWarning() << "Skipping missing file \"" << bandFile.fileName() << "\"";
+        const QString bandFile = defaultDir.filePath(bandPattern.arg(ch));
+        if (!QFile::exists(bandFile)) {
+            qWarning() << "Skipping missing file \"" << bandFile << "\"";
             continue;
         }
-        // https://support.1password.com/opvault-design/#band-files
-        QJsonObject bandJs = readAndAssertJsonFile(bandFile, "ld(", ");");
-        const QStringList keys = bandJs.keys();
-        for (const QString& entryKey : keys) {
-            const QJsonObject bandEnt = bandJs[entryKey].toObject();
-            const QString uuid = bandEnt["uuid"].toString();
-            if (entryKey != uuid) {
-                qWarning() << QString("Mismatched Entry UUID, its JSON key <<%1>> and its UUID <<%2>>")
-                                  .arg(entryKey)
-                                  .arg(uuid);
-            }
-            QStringList requiredKeys({"d", "k", "hmac"});
-            bool ok = true;
-            for (const QString& requiredKey : asConst(requiredKeys)) {
-                if (!bandEnt.contains(requiredKey)) {
-                    qCritical() << "Skipping malformed Entry UUID " << uuid << " without key " << requiredKey;
-                    ok = false;
-                    break;
-                }
-            }
-            if (!ok) {
-                continue;
-            }
-            // https://support.1password.com/opvault-design/#items
-            Entry* entry = processBandEntry(bandEnt, defaultDir, rootGroup);
-            if (!entry) {
-                qWarning() << "Unable to process Band Entry " << uuid;
-            }
+        bandFiles << bandFile;
+    }
+
+    // Band files are parsed and their items decrypted on the global thread pool,
+    // only placing the resulting entries into groups happens on this thread
+    std::function<QList<QJsonObject>(const QString&)> readBand = [this](const QString& bandFile) {
+        return readBandFile(bandFile);
+    };
+    QList<QJsonObject> bandEntries;
+    for (const QList<QJsonObject>& band : QtConcurrent::mapped(bandFiles, readBand).results()) {
+        bandEntries.append(band);
+    }
+
+    QThread* targetThread = QThread::currentThread();
+    const QDir& attachmentDir = defaultDir;
+    std::function<BandItem(const QJsonObject&)> decryptItem = [=, &attachmentDir](const QJsonObject& bandEntry) {
+        BandItem item;
+        // https://support.1password.com/opvault-design/#items
+        item.entry = processBandEntry(bandEntry, attachmentDir, item.complete);
+        if (item.entry) {
+            item.entry->moveToThread(targetThread);
+        }
+        return item;
+    };
+    const QList<BandItem> items = QtConcurrent::mapped(bandEntries, decryptItem).results();
+
+    for (int i = 0; i < items.size(); ++i) {
+        const BandItem& item = items.at(i);
+        if (item.entry) {
+            placeBandEntry(item.entry, bandEntries.at(i), rootGroup);
+        }
+        if (!item.complete) {
+            qWarning() << "Unable to process Band Entry " << bandEntries.at(i)["uuid"].toString();
         }
     }
 
@@ -329,6 +339,36 @@ QJsonObject OpVaultReader::readAndAssertJsonFile(QFile& file, const QString& str
     return jDoc.object();
 }
 
+QList<QJsonObject> OpVaultReader::readBandFile(const QString& filePath)
+{
+    QList<QJsonObject> bandEntries;
+    QFile bandFile(filePath);
+    QJsonObject bandJs = readAndAssertJsonFile(bandFile, "ld(", ");");
+    const QStringList keys = bandJs.keys();
+    for (const QString& entryKey : keys) {
+        const QJsonObject bandEnt = bandJs[entryKey].toObject();
+        const QString uuid = bandEnt["uuid"].toString();
+        if (entryKey != uuid) {
+            qWarning() << QString("Mismatched Entry UUID, its JSON key <<%1>> and its UUID <<%2>>")
+                              .arg(entryKey)
+                              .arg(uuid);
+        }
+        QStringList requiredKeys({"d", "k", "hmac"});
+        bool ok = true;
+        for (const QString& requiredKey : asConst(requiredKeys)) {
+            if (!bandEnt.contains(requiredKey)) {
+                qCritical() << "Skipping malformed Entry UUID " << uuid << " without key " << requiredKey;
+                ok = false;
+                break;
+            }
+        }
+        if (ok) {
+            bandEntries << bandEnt;
+        }
+    }
+    return bandEntries;
+}
+
 /* Convenience method for calling decodeCompositeKeys when you have a base64 encrypted composite key. */
 OpVaultReader::DerivedKeyHMAC*
 OpVaultReader::decodeB64CompositeKeys(const QString& b64, const QByteArray& encKey, const QByteArray& hmacKey)
@@ -52,6 +52,21 @@ private:
         QString errorStr;
     };
 
+    /*! A decrypted item that is not yet part of the database. */
+    struct BandItem
+    {
+        Entry* entry = nullptr;
+        bool complete = false;
+    };
+
+    /*! A decrypted attachment of an item. */
+    struct Attachment
+    {
+        QString name;
+        QByteArray payload;
+        bool valid = false;
+    };
+
     QJsonObject readAndAssertJsonFile(QFile& file, const QString& stripLeading, const QString& stripTrailing);
 
     DerivedKeyHMAC* deriveKeysFromPassPhrase(QByteArray& salt, const QString& password, unsigned long iterations);
@@ -79,17 +94,30 @@ private:
      * @returns \c nullptr if unable to do the decryption, otherwise the interior object and its keys
      */
     bool decryptBandEntry(const QJsonObject& bandEntry, QJsonObject& data, QByteArray& key, QByteArray& hmacKey);
-    Entry* processBandEntry(const QJsonObject& bandEntry, const QDir& attachmentDir, Group* rootGroup);
+
+    /*!
+     * Reads a band file and returns its well-formed items.
+     * \sa https://support.1password.com/opvault-design/#band-files
+     */
+    QList<QJsonObject> readBandFile(const QString& filePath);
+
+    /*!
+     * Decrypts a band item into an entry that does not belong to any group yet.
+     * Only reads the keys of the reader, so items may be processed concurrently.
+     * @param complete set to \c false if only the overview of the item could be decrypted
+     * @return \c nullptr if the item could not be processed at all
+     */
+    Entry* processBandEntry(const QJsonObject& bandEntry, const QDir& attachmentDir, bool& complete);
+    void placeBandEntry(Entry* entry, const QJsonObject& bandEntry, Group* rootGroup);
 
     bool readAttachment(const QString& filePath,
                         const QByteArray& itemKey,
                         const QByteArray& itemHmacKey,
                         QJsonObject& metadata,
                         QByteArray& payload);
-    void fillAttachment(Entry* entry,
-                        const QFileInfo& attachmentFileInfo,
-                        const QByteArray& entryKey,
-                        const QByteArray& entryHmacKey);
+    Attachment decodeAttachment(const QFileInfo& attachmentFileInfo,
+                                const QByteArray& entryKey,
+                                const QByteArray& entryHmacKey);
     void fillAttachments(Entry* entry,
                          const QDir& attachmentDir,
                          const QByteArray& entryKey,
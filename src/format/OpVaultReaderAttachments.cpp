@@ -169,29 +169,32 @@ void OpVaultReader::fillAttachments(Entry* entry,
         return;
     }
 
-    for (const auto& info : attachInfoList) {
+    // Entries are already processed on the thread pool, decrypt their attachments on the same worker
+    for (const QFileInfo& info : attachInfoList) {
         if (!info.isReadable()) {
             qCritical() << QString("Attachment file \"%1\" is not readable").arg(info.absoluteFilePath());
             continue;
         }
-        fillAttachment(entry, info, entryKey, entryHmacKey);
+        const Attachment attachment = decodeAttachment(info, entryKey, entryHmacKey);
+        if (attachment.valid) {
+            entry->attachments()->set(attachment.name, attachment.payload);
+        }
     }
 }
 
-void OpVaultReader::fillAttachment(Entry* entry,
-                                   const QFileInfo& info,
-                                   const QByteArray& entryKey,
-                                   const QByteArray& entryHmacKey)
+OpVaultReader::Attachment
+OpVaultReader::decodeAttachment(const QFileInfo& info, const QByteArray& entryKey, const QByteArray& entryHmacKey)
 {
+    Attachment attachment;
     QJsonObject attachMetadata;
     QByteArray attachPayload;
     if (!readAttachment(info.absoluteFilePath(), entryKey, entryHmacKey, attachMetadata, attachPayload)) {
-        return;
+        return attachment;
     }
 
     if (!attachMetadata.contains("overview")) {
         qWarning() << "Expected \"overview\" in attachment metadata";
-        return;
+        return attachment;
     }
 
     const QString& overB64 = attachMetadata["overview"].toString();
@@ -246,5 +249,8 @@ void OpVaultReader::fillAttachment(Entry* entry,
         }
     }
 
-    entry->attachments()->set(attachKey, attachPayload);
+    attachment.name = attachKey;
+    attachment.payload = attachPayload;
+    attachment.valid = true;
+    return attachment;
 }
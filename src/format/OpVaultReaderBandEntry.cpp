@@ -104,8 +104,9 @@ bool OpVaultReader::decryptBandEntry(const QJsonObject& bandEntry,
     return true;
 }
 
-Entry* OpVaultReader::processBandEntry(const QJsonObject& bandEntry, const QDir& attachmentDir, Group* rootGroup)
+Entry* OpVaultReader::processBandEntry(const QJsonObject& bandEntry, const QDir& attachmentDir, bool& complete)
 {
+    complete = false;
     const QString uuid = bandEntry.value("uuid").toString();
     if (!(uuid.size() == 32 || uuid.size() == 36)) {
         qWarning() << QString("Skipping suspicious band UUID <<%1>> with length %2").arg(uuid).arg(uuid.size());
@@ -114,35 +115,6 @@ Entry* OpVaultReader::processBandEntry(const QJsonObject& bandEntry, const QDir&
 
     const auto entry = new Entry();
 
-    if (bandEntry.contains("category")) {
-        const QJsonValue& categoryValue = bandEntry["category"];
-        if (categoryValue.isString()) {
-            bool found = false;
-            const QString category = categoryValue.toString();
-            for (Group* group : rootGroup->children()) {
-                const QVariant& groupCode = group->property("code");
-                if (category == groupCode.toString()) {
-                    entry->setGroup(group);
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                qWarning() << QString("Unable to place Entry.Category \"%1\" so using the Root instead").arg(category);
-                entry->setGroup(rootGroup);
-            }
-        } else {
-            qWarning() << QString(R"(Skipping non-String Category type "%1" in UUID "%2")")
-                              .arg(categoryValue.type())
-                              .arg(uuid);
-            entry->setGroup(rootGroup);
-        }
-    } else {
-        qWarning() << "Using the root group because the entry is category-less: <<\n"
-                   << bandEntry << "\n>> in UUID " << uuid;
-        entry->setGroup(rootGroup);
-    }
-
     entry->setUpdateTimeinfo(false);
     TimeInfo ti;
     bool timeInfoOk = false;
@@ -172,7 +144,8 @@ Entry* OpVaultReader::processBandEntry(const QJsonObject& bandEntry, const QDir&
     QByteArray entryHmacKey;
 
     if (!decryptBandEntry(bandEntry, data, entryKey, entryHmacKey)) {
-        return nullptr;
+        // Keep the overview of the item even though its details are lost
+        return entry;
     }
 
     if (data.contains("notesPlain")) {
@@ -212,9 +185,44 @@ Entry* OpVaultReader::processBandEntry(const QJsonObject& bandEntry, const QDir&
     }
 
     fillAttachments(entry, attachmentDir, entryKey, entryHmacKey);
+    complete = true;
     return entry;
 }
 
+void OpVaultReader::placeBandEntry(Entry* entry, const QJsonObject& bandEntry, Group* rootGroup)
+{
+    const QString uuid = bandEntry.value("uuid").toString();
+
+    if (bandEntry.contains("category")) {
+        const QJsonValue& categoryValue = bandEntry["category"];
+        if (categoryValue.isString()) {
+            bool found = false;
+            const QString category = categoryValue.toString();
+            for (Group* group : rootGroup->children()) {
+                const QVariant& groupCode = group->property("code");
+                if (category == groupCode.toString()) {
+                    entry->setGroup(group);
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                qWarning() << QString("Unable to place Entry.Category \"%1\" so using the Root instead").arg(category);
+                entry->setGroup(rootGroup);
+            }
+        } else {
+            qWarning() << QString(R"(Skipping non-String Category type "%1" in UUID "%2")")
+                              .arg(categoryValue.type())
+                              .arg(uuid);
+            entry->setGroup(rootGroup);
+        }
+    } else {
+        qWarning() << "Using the root group because the entry is category-less: <<\n"
+                   << bandEntry << "\n>> in UUID " << uuid;
+        entry->setGroup(rootGroup);
+    }
+}
+
 bool OpVaultReader::fillAttributes(Entry* entry, const QJsonObject& bandEntry)
 {
     const QString overviewStr = bandEntry.value("o").toString();
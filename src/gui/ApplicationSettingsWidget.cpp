@@ -258,6 +258,7 @@ void ApplicationSettingsWidget::loadSettings()
     m_secUi->lockDatabaseOnScreenLockCheckBox->setChecked(config()->get("security/lockdatabasescreenlock").toBool());
     m_secUi->relockDatabaseAutoTypeCheckBox->setChecked(config()->get("security/relockautotype").toBool());
     m_secUi->fallbackToSearch->setChecked(config()->get("security/IconDownloadFallback").toBool());
+    m_secUi->iconDownloadCache->setChecked(config()->get("security/IconDownloadCache").toBool());
 
     m_secUi->passwordCleartextCheckBox->setChecked(config()->get("security/passwordscleartext").toBool());
     m_secUi->passwordShowDotsCheckBox->setChecked(config()->get("security/passwordemptynodots").toBool());
@@ -345,6 +346,7 @@ void ApplicationSettingsWidget::saveSettings()
     config()->set("security/lockdatabasescreenlock", m_secUi->lockDatabaseOnScreenLockCheckBox->isChecked());
     config()->set("security/relockautotype", m_secUi->relockDatabaseAutoTypeCheckBox->isChecked());
     config()->set("security/IconDownloadFallback", m_secUi->fallbackToSearch->isChecked());
+    config()->set("security/IconDownloadCache", m_secUi->iconDownloadCache->isChecked());
 
     config()->set("security/passwordscleartext", m_secUi->passwordCleartextCheckBox->isChecked());
     config()->set("security/passwordemptynodots", m_secUi->passwordShowDotsCheckBox->isChecked());
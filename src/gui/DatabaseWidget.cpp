@@ -399,6 +399,7 @@ void DatabaseWidget::replaceDatabase(QSharedPointer<Database> db)
     auto oldDb = m_db;
     m_db = std::move(db);
     connectDatabaseSignals();
+    m_db->metadata()->prefetchCustomIconsScaled();
     m_groupView->changeDatabase(m_db);
 
     // Restore the new parent group pointer, if not found default to the root group
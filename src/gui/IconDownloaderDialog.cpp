@@ -21,6 +21,7 @@
 #include "core/AsyncTask.h"
 #include "core/Config.h"
 #include "core/Entry.h"
+#include "core/FaviconCache.h"
 #include "core/Global.h"
 #include "core/Group.h"
 #include "core/IconDownloader.h"
@@ -33,10 +34,17 @@
 
 #include <QMutexLocker>
 
+namespace
+{
+    // downloads running at the same time, the others are queued
+    const int MaxConcurrentDownloads = 8;
+} // namespace
+
 IconDownloaderDialog::IconDownloaderDialog(QWidget* parent)
     : QDialog(parent)
     , m_ui(new Ui::IconDownloaderDialog())
     , m_dataModel(new QStandardItemModel(this))
+    , m_finishedUrls(0)
 {
     setWindowFlags(Qt::Window);
     setAttribute(Qt::WA_DeleteOnClose);
@@ -66,6 +74,8 @@ void IconDownloaderDialog::downloadFavicons(const QSharedPointer<Database>& data
     m_db = database;
     m_urlToEntries.clear();
     abortDownloads();
+    m_hostToUrls.clear();
+    m_finishedUrls = 0;
     for (const auto& e : entries) {
         // Only consider entries with a valid URL and without a custom icon
         auto webUrl = e->webUrl();
@@ -84,10 +94,27 @@ void IconDownloaderDialog::downloadFavicons(const QSharedPointer<Database>& data
         open();
         QApplication::processEvents();
 
+        // Websites of the same host share their icon, download it only once
         for (const auto& url : m_urlToEntries.uniqueKeys()) {
             m_dataModel->appendRow(QList<QStandardItem*>()
                                    << new QStandardItem(url) << new QStandardItem(tr("Downloading...")));
-            m_activeDownloaders.append(createDownloader(url));
+            m_hostToUrls[IconDownloader::hostOf(url)] << url;
+        }
+
+        if (config()->get("security/IconDownloadCache").toBool()) {
+            m_cache.reset(new FaviconCache());
+        } else {
+            m_cache.reset();
+        }
+
+        // Icons downloaded by a previous run are served from the cache
+        for (auto it = m_hostToUrls.cbegin(); it != m_hostToUrls.cend(); ++it) {
+            QByteArray data;
+            if (m_cache && m_cache->lookup(it.key(), data) == FaviconCache::Found) {
+                applyIcon(it.key(), data);
+            } else {
+                m_queuedHosts << it.key();
+            }
         }
 
         // Setup the dialog
@@ -96,9 +123,7 @@ void IconDownloaderDialog::downloadFavicons(const QSharedPointer<Database>& data
         QApplication::processEvents();
 
         // Start the downloads
-        for (auto downloader : m_activeDownloaders) {
-            downloader->download();
-        }
+        startDownloads();
     }
 }
 
@@ -114,48 +139,91 @@ IconDownloader* IconDownloaderDialog::createDownloader(const QString& url)
     return downloader;
 }
 
+/**
+ * Start queued downloads until the maximum number of concurrent downloads is reached.
+ */
+void IconDownloaderDialog::startDownloads()
+{
+    while (m_activeDownloaders.size() < MaxConcurrentDownloads && !m_queuedHosts.isEmpty()) {
+        const QString host = m_queuedHosts.takeFirst();
+        auto downloader = createDownloader(m_hostToUrls.value(host).first());
+        m_activeDownloaders.insert(downloader, host);
+        downloader->download();
+    }
+
+    if (isFinished() && m_cache) {
+        m_cache->save();
+    }
+}
+
 void IconDownloaderDialog::downloadFinished(const QString& url, const QImage& icon)
 {
+    Q_UNUSED(url);
+    Q_UNUSED(icon);
+
     // Prevent re-entrance from multiple calls finishing at the same time
     QMutexLocker locker(&m_mutex);
 
     // Cleanup the icon downloader that sent this signal
     auto downloader = qobject_cast<IconDownloader*>(sender());
-    if (downloader) {
-        downloader->deleteLater();
-        m_activeDownloaders.removeAll(downloader);
+    if (!downloader || !m_activeDownloaders.contains(downloader)) {
+        return;
+    }
+    downloader->deleteLater();
+    const QString host = m_activeDownloaders.take(downloader);
+    const QByteArray data = downloader->iconData();
+
+    // Only icons are cached, failures are retried on the next run
+    if (m_cache) {
+        m_cache->insert(host, data);
     }
+    applyIcon(host, data);
 
     updateProgressBar();
     updateCancelButton();
+    startDownloads();
+}
 
-    if (m_db && !icon.isNull()) {
-        // Don't add an icon larger than 128x128, but retain original size if smaller
-        auto scaledicon = icon;
-        if (icon.width() > 128 || icon.height() > 128) {
-            scaledicon = icon.scaled(128, 128);
-        }
+/**
+ * Set the icon of a host on the entries of all its websites.
+ *
+ * @param data PNG data of the icon, empty if the download failed
+ */
+void IconDownloaderDialog::applyIcon(const QString& host, const QByteArray& data)
+{
+    const QStringList urls = m_hostToUrls.value(host);
+    m_finishedUrls += urls.size();
 
-        QUuid uuid = m_db->metadata()->findCustomIcon(scaledicon);
-        if (uuid.isNull()) {
-            uuid = QUuid::createUuid();
-            m_db->metadata()->addCustomIcon(uuid, scaledicon);
-            updateTable(url, tr("Ok"));
-        } else {
-            updateTable(url, tr("Already Exists"));
+    if (!m_db || data.isEmpty()) {
+        showFallbackMessage(true);
+        for (const auto& url : urls) {
+            updateTable(url, tr("Download Failed"));
         }
+        return;
+    }
 
+    QUuid uuid = m_db->metadata()->findCustomIcon(data);
+    QString message = tr("Already Exists");
+    if (uuid.isNull()) {
+        uuid = QUuid::createUuid();
+        m_db->metadata()->addCustomIcon(uuid, data);
+        message = tr("Ok");
+    }
+
+    for (const auto& url : urls) {
+        updateTable(url, message);
         // Set the icon on all the entries associated with this url
         for (const auto entry : m_urlToEntries.values(url)) {
             entry->setIcon(uuid);
         }
-    } else {
-        showFallbackMessage(true);
-        updateTable(url, tr("Download Failed"));
-        return;
     }
 }
 
+bool IconDownloaderDialog::isFinished() const
+{
+    return m_activeDownloaders.isEmpty() && m_queuedHosts.isEmpty();
+}
+
 void IconDownloaderDialog::showFallbackMessage(bool state)
 {
     // Show fallback message if the option is not active
@@ -166,7 +234,7 @@ void IconDownloaderDialog::showFallbackMessage(bool state)
 void IconDownloaderDialog::updateProgressBar()
 {
     int total = m_urlToEntries.uniqueKeys().count();
-    int value = total - m_activeDownloaders.count();
+    int value = m_finishedUrls;
     m_ui->progressBar->setValue(value);
     m_ui->progressBar->setMaximum(total);
     m_ui->progressLabel->setText(
@@ -175,7 +243,7 @@ void IconDownloaderDialog::updateProgressBar()
 
 void IconDownloaderDialog::updateCancelButton()
 {
-    m_ui->cancelButton->setEnabled(!m_activeDownloaders.isEmpty());
+    m_ui->cancelButton->setEnabled(!isFinished());
 }
 
 void IconDownloaderDialog::updateTable(const QString& url, const QString& message)
@@ -189,10 +257,14 @@ void IconDownloaderDialog::updateTable(const QString& url, const QString& messag
 
 void IconDownloaderDialog::abortDownloads()
 {
-    for (auto* downloader : m_activeDownloaders) {
-        delete downloader;
-    }
+    const QList<IconDownloader*> downloaders = m_activeDownloaders.keys();
     m_activeDownloaders.clear();
+    m_queuedHosts.clear();
+    qDeleteAll(downloaders);
+    if (m_cache) {
+        // keep what was downloaded so far
+        m_cache->save();
+    }
     updateProgressBar();
     updateCancelButton();
 }
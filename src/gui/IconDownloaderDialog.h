@@ -19,6 +19,7 @@
 #define KEEPASSX_ICONDOWNLOADERDIALOG_H
 
 #include <QDialog>
+#include <QHash>
 #include <QMutex>
 #include <QStandardItemModel>
 
@@ -27,6 +28,7 @@
 class Database;
 class Entry;
 class CustomIconModel;
+class FaviconCache;
 class IconDownloader;
 
 namespace Ui
@@ -50,6 +52,9 @@ private slots:
 
 private:
     IconDownloader* createDownloader(const QString& url);
+    void startDownloads();
+    void applyIcon(const QString& host, const QByteArray& data);
+    bool isFinished() const;
 
     void showFallbackMessage(bool state);
     void updateTable(const QString& url, const QString& message);
@@ -60,7 +65,11 @@ private:
     QStandardItemModel* m_dataModel;
     QSharedPointer<Database> m_db;
     QMultiMap<QString, Entry*> m_urlToEntries;
-    QList<IconDownloader*> m_activeDownloaders;
+    QMap<QString, QStringList> m_hostToUrls;
+    QStringList m_queuedHosts;
+    QHash<IconDownloader*, QString> m_activeDownloaders;
+    QScopedPointer<FaviconCache> m_cache;
+    int m_finishedUrls;
     QMutex m_mutex;
 
     Q_DISABLE_COPY(IconDownloaderDialog)
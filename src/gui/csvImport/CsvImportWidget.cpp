@@ -239,6 +239,7 @@ QString CsvImportWidget::formatStatusText() const
 
 void CsvImportWidget::writeDatabase()
 {
+    m_db->beginUpdate();
     setRootGroup();
     for (int r = 0; r < m_parserModel->rowCount(); ++r) {
         // use validity of second column as a GO/NOGO for all others fields
@@ -269,6 +270,8 @@ void CsvImportWidget::writeDatabase()
         }
         entry->setTimeInfo(timeInfo);
     }
+    m_db->endUpdate();
+
     QBuffer buffer;
     buffer.open(QBuffer::ReadWrite);
 
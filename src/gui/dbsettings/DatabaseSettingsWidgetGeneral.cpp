@@ -22,7 +22,9 @@
 #include "core/Database.h"
 #include "core/Entry.h"
 #include "core/Group.h"
+#include "core/HistoryMaintenance.h"
 #include "core/Metadata.h"
+#include "core/Tools.h"
 #include "gui/MessageBox.h"
 
 DatabaseSettingsWidgetGeneral::DatabaseSettingsWidgetGeneral(QWidget* parent)
@@ -33,6 +35,7 @@ DatabaseSettingsWidgetGeneral::DatabaseSettingsWidgetGeneral(QWidget* parent)
 
     connect(m_ui->historyMaxItemsCheckBox, SIGNAL(toggled(bool)), m_ui->historyMaxItemsSpinBox, SLOT(setEnabled(bool)));
     connect(m_ui->historyMaxSizeCheckBox, SIGNAL(toggled(bool)), m_ui->historyMaxSizeSpinBox, SLOT(setEnabled(bool)));
+    connect(m_ui->historyMaintenanceButton, SIGNAL(clicked()), SLOT(cleanUpHistory()));
 }
 
 DatabaseSettingsWidgetGeneral::~DatabaseSettingsWidgetGeneral()
@@ -143,3 +146,45 @@ bool DatabaseSettingsWidgetGeneral::save()
 
     return true;
 }
+
+/**
+ * Remove the history exceeding the limits entered in the widget from all entries,
+ * after showing what would be removed.
+ */
+void DatabaseSettingsWidgetGeneral::cleanUpHistory()
+{
+    HistoryMaintenance maintenance(m_db.data());
+    if (m_ui->historyMaxItemsCheckBox->isChecked()) {
+        maintenance.setMaxItems(m_ui->historyMaxItemsSpinBox->value());
+    } else {
+        maintenance.setMaxItems(-1);
+    }
+    if (m_ui->historyMaxSizeCheckBox->isChecked()) {
+        maintenance.setMaxSize(m_ui->historyMaxSizeSpinBox->value() * 1048576);
+    } else {
+        maintenance.setMaxSize(-1);
+    }
+
+    const HistoryMaintenance::Report preview = maintenance.run(true);
+    if (preview.isEmpty()) {
+        MessageBox::information(
+            this, tr("Clean up history"), tr("The history of all entries is within the limits, nothing to remove."));
+        return;
+    }
+
+    auto answer = MessageBox::question(this,
+                                       tr("Clean up history"),
+                                       tr("%1 history items of %2 entries exceed the limits. Removing them drops "
+                                          "%3 attachments and reclaims %4.\n\nThe history is removed immediately, "
+                                          "even if the settings are not saved. This cannot be undone.\n\n"
+                                          "Do you want to remove them?")
+                                           .arg(preview.historyItems)
+                                           .arg(preview.entries)
+                                           .arg(preview.attachments)
+                                           .arg(Tools::humanReadableFileSize(preview.reclaimedBytes)),
+                                       MessageBox::Remove | MessageBox::Cancel,
+                                       MessageBox::Cancel);
+    if (answer == MessageBox::Remove) {
+        maintenance.run();
+    }
+}
@@ -48,6 +48,9 @@ public slots:
     void uninitialize() override;
     bool save() override;
 
+private slots:
+    void cleanUpHistory();
+
 protected:
     void showEvent(QShowEvent* event) override;
 
@@ -37,6 +37,9 @@
 EntryModel::EntryModel(QObject* parent)
     : QAbstractTableModel(parent)
     , m_group(nullptr)
+    , m_ignoreRemove(false)
+    , m_updatePending(false)
+    , m_rowsDirty(true)
     , m_hideUsernames(false)
     , m_hidePasswords(true)
     , HiddenContentDisplay(QString("\u25cf").repeated(6))
@@ -52,7 +55,7 @@ Entry* EntryModel::entryFromIndex(const QModelIndex& index) const
 
 QModelIndex EntryModel::indexFromEntry(Entry* entry) const
 {
-    int row = m_entries.indexOf(entry);
+    int row = rowOf(entry);
     Q_ASSERT(row != -1);
     return index(row, 1);
 }
@@ -69,32 +72,73 @@ void EntryModel::setGroup(Group* group)
 
     m_group = group;
     m_allGroups.clear();
+    m_databases.clear();
     m_entries = group->entries();
     m_orgEntries.clear();
+    m_rowsDirty = true;
+    clearRowCache();
 
     makeConnections(group);
+    for (Entry* entry : asConst(m_entries)) {
+        connectEntry(entry);
+    }
+    connectDatabase(group->database());
 
     endResetModel();
 }
 
+/**
+ * Display a flat list of entries, e.g. search results.
+ *
+ * If the model already shows a list of entries, only the difference to the
+ * new list is applied as row removals and insertions so that refining a
+ * search does not reset the view.
+ */
 void EntryModel::setEntries(const QList<Entry*>& entries)
 {
-    beginResetModel();
+    QSet<Database*> databases;
+    for (Entry* entry : entries) {
+        databases.insert(entry->group()->database());
+    }
 
-    severConnections();
+    m_orgEntries = entries.toSet();
 
-    m_group = nullptr;
-    m_allGroups.clear();
-    m_entries = entries;
-    m_orgEntries = entries;
+    if (m_group) {
+        beginResetModel();
 
-    QSet<Database*> databases;
+        severConnections();
 
-    for (Entry* entry : asConst(m_entries)) {
-        databases.insert(entry->group()->database());
+        m_group = nullptr;
+        m_entries = entries;
+        m_rowsDirty = true;
+        clearRowCache();
+
+        connectDatabases(databases);
+        for (Entry* entry : asConst(m_entries)) {
+            connectEntry(entry);
+        }
+
+        endResetModel();
+        return;
     }
 
-    for (Database* db : asConst(databases)) {
+    if (databases != m_databases) {
+        severConnections();
+        connectDatabases(databases);
+        for (Entry* entry : asConst(m_entries)) {
+            connectEntry(entry);
+        }
+    }
+
+    updateEntries(entries);
+}
+
+void EntryModel::connectDatabases(const QSet<Database*>& databases)
+{
+    m_allGroups.clear();
+    m_databases = databases;
+
+    for (Database* db : databases) {
         Q_ASSERT(db);
         const QList<Group*> groupList = db->rootGroup()->groupsRecursive(true);
         for (const Group* group : groupList) {
@@ -109,8 +153,154 @@ void EntryModel::setEntries(const QList<Entry*>& entries)
     for (const Group* group : asConst(m_allGroups)) {
         makeConnections(group);
     }
+    for (Database* db : databases) {
+        connectDatabase(db);
+    }
+}
 
-    endResetModel();
+void EntryModel::connectDatabase(Database* db)
+{
+    if (db) {
+        connect(db, SIGNAL(updateFinished(DatabaseChanges)), SLOT(databaseUpdated()), Qt::UniqueConnection);
+    }
+}
+
+/**
+ * Not all modifications (attachments, time info, custom attributes) emit entryDataChanged(),
+ * so every shown entry is connected directly. The connection is removed with its row.
+ */
+void EntryModel::connectEntry(Entry* entry)
+{
+    connect(entry, SIGNAL(entryModified()), SLOT(entryModified()), Qt::UniqueConnection);
+}
+
+void EntryModel::disconnectEntry(Entry* entry)
+{
+    disconnect(entry, SIGNAL(entryModified()), this, SLOT(entryModified()));
+}
+
+/**
+ * Defer data changes of entries in a database that is in the middle of a
+ * bulk update, all rows are refreshed at once in databaseUpdated().
+ */
+bool EntryModel::deferUpdate(const Group* group)
+{
+    if (group && group->database() && group->database()->isUpdating()) {
+        m_updatePending = true;
+        return true;
+    }
+    return false;
+}
+
+void EntryModel::updateEntries(const QList<Entry*>& entries)
+{
+    // Remove rows that are not part of the new list, back to front in contiguous ranges
+    int row = m_entries.size() - 1;
+    while (row >= 0) {
+        if (m_orgEntries.contains(m_entries.at(row))) {
+            --row;
+            continue;
+        }
+
+        const int last = row;
+        while (row > 0 && !m_orgEntries.contains(m_entries.at(row - 1))) {
+            --row;
+        }
+
+        beginRemoveRows(QModelIndex(), row, last);
+        for (int i = row; i <= last; ++i) {
+            invalidateRowCache(m_entries.at(i));
+            disconnectEntry(m_entries.at(i));
+        }
+        m_entries.erase(m_entries.begin() + row, m_entries.begin() + last + 1);
+        m_rowsDirty = true;
+        endRemoveRows();
+
+        --row;
+    }
+
+    QList<Entry*> newEntries;
+    QSet<const Entry*> seen;
+    for (Entry* entry : entries) {
+        if (!seen.contains(entry)) {
+            newEntries.append(entry);
+            seen.insert(entry);
+        }
+    }
+
+    // The remaining rows can only be kept if they are in the order of the new list
+    int kept = 0;
+    for (Entry* entry : asConst(newEntries)) {
+        if (kept < m_entries.size() && m_entries.at(kept) == entry) {
+            ++kept;
+        }
+    }
+
+    if (kept < m_entries.size()) {
+        beginResetModel();
+        for (Entry* entry : asConst(newEntries)) {
+            connectEntry(entry);
+        }
+        m_entries = newEntries;
+        m_rowsDirty = true;
+        endResetModel();
+        return;
+    }
+
+    // Insert the entries that are not shown yet at their position in contiguous ranges
+    const QSet<Entry*> shown = m_entries.toSet();
+    row = 0;
+    while (row < newEntries.size()) {
+        if (shown.contains(newEntries.at(row))) {
+            ++row;
+            continue;
+        }
+
+        int last = row;
+        while (last + 1 < newEntries.size() && !shown.contains(newEntries.at(last + 1))) {
+            ++last;
+        }
+
+        beginInsertRows(QModelIndex(), row, last);
+        for (int i = row; i <= last; ++i) {
+            m_entries.insert(i, newEntries.at(i));
+            connectEntry(newEntries.at(i));
+        }
+        m_rowsDirty = true;
+        endInsertRows();
+
+        row = last + 1;
+    }
+}
+
+/**
+ * Row of an entry in this model or -1 if the entry is not shown.
+ * The entry to row hash is rebuilt lazily after rows have been removed.
+ */
+int EntryModel::rowOf(const Entry* entry) const
+{
+    if (m_rowsDirty) {
+        m_rows.clear();
+        m_rows.reserve(m_entries.size());
+        for (int i = 0; i < m_entries.size(); ++i) {
+            m_rows.insert(m_entries.at(i), i);
+        }
+        m_rowsDirty = false;
+    }
+
+    return m_rows.value(entry, -1);
+}
+
+void EntryModel::invalidateRowCache(const Entry* entry)
+{
+    m_rowCache.remove(entry);
+    m_referencingEntries.remove(entry);
+}
+
+void EntryModel::clearRowCache()
+{
+    m_rowCache.clear();
+    m_referencingEntries.clear();
 }
 
 int EntryModel::rowCount(const QModelIndex& parent) const
@@ -139,11 +329,92 @@ QVariant EntryModel::data(const QModelIndex& index, int role) const
     }
 
     Entry* entry = entryFromIndex(index);
+
+    if (role == Qt::DisplayRole || role == Qt::UserRole) {
+        return cachedData(entry, index.column(), role);
+    } else if (role == Qt::DecorationRole) {
+        switch (index.column()) {
+        case ParentGroup:
+            if (entry->group()) {
+                return entry->group()->iconScaledPixmap();
+            }
+            break;
+        case Title:
+            if (entry->isExpired()) {
+                return databaseIcons()->iconPixmap(DatabaseIcons::ExpiredIconIndex);
+            }
+            return entry->iconScaledPixmap();
+        case Paperclip:
+            if (!entry->attachments()->isEmpty()) {
+                return m_paperClipPixmap;
+            }
+            break;
+        }
+    } else if (role == Qt::FontRole) {
+        QFont font;
+        if (entry->isExpired()) {
+            font.setStrikeOut(true);
+        }
+        return font;
+    } else if (role == Qt::ForegroundRole) {
+        if (entry->hasReferences()) {
+            QPalette p;
+#ifdef Q_OS_MACOS
+            if (macUtils()->isDarkMode()) {
+                return QVariant(p.color(QPalette::Inactive, QPalette::Dark));
+            }
+#endif
+            return QVariant(p.color(QPalette::Active, QPalette::Mid));
+        } else if (entry->foregroundColor().isValid()) {
+            return QVariant(entry->foregroundColor());
+        }
+    } else if (role == Qt::BackgroundRole) {
+        if (entry->backgroundColor().isValid()) {
+            return QVariant(entry->backgroundColor());
+        }
+    } else if (role == Qt::TextAlignmentRole) {
+        if (index.column() == Paperclip) {
+            return Qt::AlignCenter;
+        }
+    }
+
+    return QVariant();
+}
+
+/**
+ * Display and sort values are expensive to compute due to placeholder
+ * resolution, so they are computed on first access and kept until the
+ * entry changes.
+ */
+QVariant EntryModel::cachedData(Entry* entry, int column, int role) const
+{
+    // The first columnCount() slots hold the display role, followed by the sort role
+    const int slot = (role == Qt::DisplayRole) ? column : columnCount() + column;
+
+    auto it = m_rowCache.find(entry);
+    if (it == m_rowCache.end()) {
+        it = m_rowCache.insert(entry, QVector<QVariant>(columnCount() * 2));
+        if (entry->hasReferences()) {
+            m_referencingEntries.insert(entry);
+        }
+    }
+
+    if (it->at(slot).isValid()) {
+        return it->at(slot);
+    }
+
+    const QVariant value = computeData(entry, column, role);
+    m_rowCache[entry][slot] = value;
+    return value;
+}
+
+QVariant EntryModel::computeData(Entry* entry, int column, int role) const
+{
     EntryAttributes* attr = entry->attributes();
 
     if (role == Qt::DisplayRole) {
         QString result;
-        switch (index.column()) {
+        switch (column) {
         case ParentGroup:
             if (entry->group()) {
                 return entry->group()->name();
@@ -223,7 +494,7 @@ QVariant EntryModel::data(const QModelIndex& index, int role) const
             return result;
         }
     } else if (role == Qt::UserRole) { // Qt::UserRole is used as sort role, see EntryView::EntryView()
-        switch (index.column()) {
+        switch (column) {
         case Username:
             return entry->resolveMultiplePlaceholders(entry->username());
         case Password:
@@ -244,51 +515,7 @@ QVariant EntryModel::data(const QModelIndex& index, int role) const
         default:
             // For all other columns, simply use data provided by Qt::Display-
             // Role for sorting
-            return data(index, Qt::DisplayRole);
-        }
-    } else if (role == Qt::DecorationRole) {
-        switch (index.column()) {
-        case ParentGroup:
-            if (entry->group()) {
-                return entry->group()->iconScaledPixmap();
-            }
-            break;
-        case Title:
-            if (entry->isExpired()) {
-                return databaseIcons()->iconPixmap(DatabaseIcons::ExpiredIconIndex);
-            }
-            return entry->iconScaledPixmap();
-        case Paperclip:
-            if (!entry->attachments()->isEmpty()) {
-                return m_paperClipPixmap;
-            }
-            break;
-        }
-    } else if (role == Qt::FontRole) {
-        QFont font;
-        if (entry->isExpired()) {
-            font.setStrikeOut(true);
-        }
-        return font;
-    } else if (role == Qt::ForegroundRole) {
-        if (entry->hasReferences()) {
-            QPalette p;
-#ifdef Q_OS_MACOS
-            if (macUtils()->isDarkMode()) {
-                return QVariant(p.color(QPalette::Inactive, QPalette::Dark));
-            }
-#endif
-            return QVariant(p.color(QPalette::Active, QPalette::Mid));
-        } else if (entry->foregroundColor().isValid()) {
-            return QVariant(entry->foregroundColor());
-        }
-    } else if (role == Qt::BackgroundRole) {
-        if (entry->backgroundColor().isValid()) {
-            return QVariant(entry->backgroundColor());
-        }
-    } else if (role == Qt::TextAlignmentRole) {
-        if (index.column() == Paperclip) {
-            return Qt::AlignCenter;
+            return cachedData(entry, column, Qt::DisplayRole);
         }
     }
 
@@ -402,9 +629,13 @@ void EntryModel::entryAboutToAdd(Entry* entry)
         return;
     }
 
+    connectEntry(entry);
     beginInsertRows(QModelIndex(), m_entries.size(), m_entries.size());
     if (!m_group) {
         m_entries.append(entry);
+        if (!m_rowsDirty) {
+            m_rows.insert(entry, m_entries.size() - 1);
+        }
     }
 }
 
@@ -416,22 +647,39 @@ void EntryModel::entryAdded(Entry* entry)
 
     if (m_group) {
         m_entries = m_group->entries();
+        m_rowsDirty = true;
     }
     endInsertRows();
 }
 
 void EntryModel::entryAboutToRemove(Entry* entry)
 {
-    beginRemoveRows(QModelIndex(), m_entries.indexOf(entry), m_entries.indexOf(entry));
+    const int row = rowOf(entry);
+    if (row == -1) {
+        // Entry of a connected group that is not part of the shown entries
+        m_ignoreRemove = true;
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    invalidateRowCache(entry);
+    disconnectEntry(entry);
     if (!m_group) {
-        m_entries.removeAll(entry);
+        m_entries.removeAt(row);
+        m_rowsDirty = true;
     }
 }
 
 void EntryModel::entryRemoved()
 {
+    if (m_ignoreRemove) {
+        m_ignoreRemove = false;
+        return;
+    }
+
     if (m_group) {
         m_entries = m_group->entries();
+        m_rowsDirty = true;
     }
 
     endRemoveRows();
@@ -439,8 +687,65 @@ void EntryModel::entryRemoved()
 
 void EntryModel::entryDataChanged(Entry* entry)
 {
-    int row = m_entries.indexOf(entry);
-    emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+    if (deferUpdate(entry->group())) {
+        return;
+    }
+
+    // The row of the entry itself is refreshed in entryModified(), which is emitted first.
+    // Entries with references may display data of the changed entry.
+    const QSet<const Entry*> referencingEntries = m_referencingEntries;
+    for (const Entry* referencingEntry : referencingEntries) {
+        if (referencingEntry == entry) {
+            continue;
+        }
+        invalidateRowCache(referencingEntry);
+        const int row = rowOf(referencingEntry);
+        if (row != -1) {
+            emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+        }
+    }
+}
+
+void EntryModel::entryModified()
+{
+    auto entry = qobject_cast<Entry*>(sender());
+    if (!entry || deferUpdate(entry->group())) {
+        return;
+    }
+
+    invalidateRowCache(entry);
+    const int row = rowOf(entry);
+    if (row != -1) {
+        emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+    }
+}
+
+void EntryModel::groupDataChanged()
+{
+    if (m_group || m_entries.isEmpty() || deferUpdate(qobject_cast<Group*>(sender()))) {
+        return;
+    }
+
+    // Only the parent group column depends on group data
+    for (auto it = m_rowCache.begin(); it != m_rowCache.end(); ++it) {
+        (*it)[ParentGroup] = QVariant();
+        (*it)[columnCount() + ParentGroup] = QVariant();
+    }
+    emit dataChanged(index(0, ParentGroup), index(rowCount() - 1, ParentGroup));
+}
+
+void EntryModel::databaseUpdated()
+{
+    // connections to databases are kept, ignore those no longer shown
+    auto db = qobject_cast<Database*>(sender());
+    bool shown = m_group ? m_group->database() == db : m_databases.contains(db);
+    if (!m_updatePending || !shown || m_entries.isEmpty()) {
+        return;
+    }
+
+    m_updatePending = false;
+    clearRowCache();
+    emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
 }
 
 void EntryModel::severConnections()
@@ -452,6 +757,10 @@ void EntryModel::severConnections()
     for (const Group* group : asConst(m_allGroups)) {
         disconnect(group, nullptr, this, nullptr);
     }
+
+    for (Entry* entry : asConst(m_entries)) {
+        disconnectEntry(entry);
+    }
 }
 
 void EntryModel::makeConnections(const Group* group)
@@ -461,6 +770,7 @@ void EntryModel::makeConnections(const Group* group)
     connect(group, SIGNAL(entryAboutToRemove(Entry*)), SLOT(entryAboutToRemove(Entry*)));
     connect(group, SIGNAL(entryRemoved(Entry*)), SLOT(entryRemoved()));
     connect(group, SIGNAL(entryDataChanged(Entry*)), SLOT(entryDataChanged(Entry*)));
+    connect(group, SIGNAL(groupDataChanged(Group*)), SLOT(groupDataChanged()));
 }
 
 /**
@@ -477,6 +787,7 @@ bool EntryModel::isUsernamesHidden() const
 void EntryModel::setUsernamesHidden(bool hide)
 {
     m_hideUsernames = hide;
+    clearRowCache();
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
     emit usernamesHiddenChanged();
 }
@@ -495,6 +806,7 @@ bool EntryModel::isPasswordsHidden() const
 void EntryModel::setPasswordsHidden(bool hide)
 {
     m_hidePasswords = hide;
+    clearRowCache();
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
     emit passwordsHiddenChanged();
 }
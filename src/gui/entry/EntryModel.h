@@ -19,8 +19,12 @@
 #define KEEPASSX_ENTRYMODEL_H
 
 #include <QAbstractTableModel>
+#include <QHash>
 #include <QPixmap>
+#include <QSet>
+#include <QVector>
 
+class Database;
 class Entry;
 class Group;
 
@@ -80,15 +84,38 @@ private slots:
     void entryAboutToRemove(Entry* entry);
     void entryRemoved();
     void entryDataChanged(Entry* entry);
+    void entryModified();
+    void groupDataChanged();
+    void databaseUpdated();
 
 private:
     void severConnections();
     void makeConnections(const Group* group);
+    void connectDatabases(const QSet<Database*>& databases);
+    void connectDatabase(Database* db);
+    void connectEntry(Entry* entry);
+    void disconnectEntry(Entry* entry);
+    bool deferUpdate(const Group* group);
+    void updateEntries(const QList<Entry*>& entries);
+    int rowOf(const Entry* entry) const;
+    void invalidateRowCache(const Entry* entry);
+    void clearRowCache();
+    QVariant cachedData(Entry* entry, int column, int role) const;
+    QVariant computeData(Entry* entry, int column, int role) const;
 
     Group* m_group;
     QList<Entry*> m_entries;
-    QList<Entry*> m_orgEntries;
+    QSet<Entry*> m_orgEntries;
     QList<const Group*> m_allGroups;
+    QSet<Database*> m_databases;
+    bool m_ignoreRemove;
+    bool m_updatePending;
+
+    // Row lookup and lazily computed display/sort values, see rowOf() and cachedData()
+    mutable QHash<const Entry*, int> m_rows;
+    mutable bool m_rowsDirty;
+    mutable QHash<const Entry*, QVector<QVariant>> m_rowCache;
+    mutable QSet<const Entry*> m_referencingEntries;
 
     bool m_hideUsernames;
     bool m_hidePasswords;
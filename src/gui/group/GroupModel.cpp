@@ -30,6 +30,7 @@
 GroupModel::GroupModel(Database* db, QObject* parent)
     : QAbstractItemModel(parent)
     , m_db(nullptr)
+    , m_batchDepth(0)
 {
     changeDatabase(db);
 }
@@ -39,6 +40,8 @@ void GroupModel::changeDatabase(Database* newDb)
     beginResetModel();
 
     m_db = newDb;
+    m_fetched.clear();
+    m_entryCounts.clear();
 
     // clang-format off
     connect(m_db, SIGNAL(groupDataChanged(Group*)), SLOT(groupDataChanged(Group*)));
@@ -48,6 +51,9 @@ void GroupModel::changeDatabase(Database* newDb)
     connect(m_db, SIGNAL(groupRemoved()), SLOT(groupRemoved()));
     connect(m_db, SIGNAL(groupAboutToMove(Group*,Group*,int)), SLOT(groupAboutToMove(Group*,Group*,int)));
     connect(m_db, SIGNAL(groupMoved()), SLOT(groupMoved()));
+    connect(m_db, SIGNAL(databaseModified()), SLOT(clearEntryCounts()));
+    connect(m_db, SIGNAL(updateStarted()), SLOT(beginBatchUpdate()));
+    connect(m_db, SIGNAL(updateFinished(DatabaseChanges)), SLOT(endBatchUpdate()));
     // clang-format on
 
     endResetModel();
@@ -59,8 +65,9 @@ int GroupModel::rowCount(const QModelIndex& parent) const
         // we have exactly 1 root item
         return 1;
     } else {
+        // children are only reported once fetchMore() exposed them
         const Group* group = groupFromIndex(parent);
-        return group->children().size();
+        return isFetched(group) ? group->children().size() : 0;
     }
 }
 
@@ -71,6 +78,93 @@ int GroupModel::columnCount(const QModelIndex& parent) const
     return 1;
 }
 
+bool GroupModel::hasChildren(const QModelIndex& parent) const
+{
+    if (!parent.isValid()) {
+        return true;
+    }
+    return !groupFromIndex(parent)->children().isEmpty();
+}
+
+bool GroupModel::canFetchMore(const QModelIndex& parent) const
+{
+    if (!parent.isValid()) {
+        return false;
+    }
+    return !isFetched(groupFromIndex(parent));
+}
+
+void GroupModel::fetchMore(const QModelIndex& parent)
+{
+    if (!canFetchMore(parent)) {
+        return;
+    }
+
+    const Group* group = groupFromIndex(parent);
+    beginInsertRows(parent, 0, group->children().size() - 1);
+    m_fetched.insert(group);
+    endInsertRows();
+}
+
+/**
+ * Fetch all ancestors of a group so that it is exposed to views,
+ * e.g. to select a group deep inside a collapsed tree.
+ */
+void GroupModel::fetchParents(Group* group)
+{
+    QList<Group*> ancestors;
+    for (Group* parentGroup = group->parentGroup(); parentGroup; parentGroup = parentGroup->parentGroup()) {
+        ancestors.prepend(parentGroup);
+    }
+
+    for (Group* ancestor : asConst(ancestors)) {
+        fetchMore(groupIndex(ancestor));
+    }
+}
+
+/**
+ * Suppress row signals until the matching endBatchUpdate() call.
+ * Bulk operations such as merges then result in a single layout change
+ * instead of a row signal for every group touched. Calls may be nested,
+ * database updates (see Database::beginUpdate()) are batched automatically.
+ */
+void GroupModel::beginBatchUpdate()
+{
+    if (m_batchDepth++ > 0) {
+        return;
+    }
+
+    emit layoutAboutToBeChanged();
+
+    m_batchIndexes = persistentIndexList();
+    m_batchGroups.clear();
+    m_batchGroups.reserve(m_batchIndexes.size());
+    for (const QModelIndex& index : asConst(m_batchIndexes)) {
+        m_batchGroups.append(groupFromIndex(index));
+    }
+}
+
+void GroupModel::endBatchUpdate()
+{
+    // the model may have been attached to a database in the middle of an update
+    if (m_batchDepth == 0 || --m_batchDepth > 0) {
+        return;
+    }
+
+    QModelIndexList newIndexes;
+    newIndexes.reserve(m_batchGroups.size());
+    for (const QPointer<Group>& group : asConst(m_batchGroups)) {
+        newIndexes.append(group && isExposed(group) ? groupIndex(group) : QModelIndex());
+    }
+    changePersistentIndexList(m_batchIndexes, newIndexes);
+
+    m_batchIndexes.clear();
+    m_batchGroups.clear();
+    m_entryCounts.clear();
+
+    emit layoutChanged();
+}
+
 QModelIndex GroupModel::index(int row, int column, const QModelIndex& parent) const
 {
     if (!hasIndex(row, column, parent)) {
@@ -142,6 +236,8 @@ QVariant GroupModel::data(const QModelIndex& index, int role) const
             font.setStrikeOut(true);
         }
         return font;
+    } else if (role == Qt::ToolTipRole) {
+        return tr("%n entry(s)", "", entryCount(group));
     } else {
         return QVariant();
     }
@@ -156,7 +252,17 @@ QVariant GroupModel::headerData(int section, Qt::Orientation orientation, int ro
     return QVariant();
 }
 
-QModelIndex GroupModel::index(Group* group) const
+/**
+ * @return index of group, its ancestors are fetched first so that the
+ *         index is valid even if the group is not exposed to views yet
+ */
+QModelIndex GroupModel::index(Group* group)
+{
+    fetchParents(group);
+    return groupIndex(group);
+}
+
+QModelIndex GroupModel::groupIndex(Group* group) const
 {
     int row;
 
@@ -298,7 +404,7 @@ bool GroupModel::dropMimeData(const QMimeData* data,
             QUuid customIcon = entry->iconUuid();
 
             if (sourceDb != targetDb && !customIcon.isNull() && !targetDb->metadata()->containsCustomIcon(customIcon)) {
-                targetDb->metadata()->addCustomIcon(customIcon, sourceDb->metadata()->customIcon(customIcon));
+                targetDb->metadata()->addCustomIcon(customIcon, sourceDb->metadata()->customIconData(customIcon));
             }
 
             entry->setGroup(parentGroup);
@@ -353,7 +459,11 @@ QMimeData* GroupModel::mimeData(const QModelIndexList& indexes) const
 
 void GroupModel::groupDataChanged(Group* group)
 {
-    QModelIndex ix = index(group);
+    if (m_batchDepth > 0 || !isExposed(group)) {
+        return;
+    }
+
+    QModelIndex ix = groupIndex(group);
     emit dataChanged(ix, ix);
 }
 
@@ -361,6 +471,15 @@ void GroupModel::groupAboutToRemove(Group* group)
 {
     Q_ASSERT(group->parentGroup());
 
+    m_entryCounts.clear();
+    forgetFetched(group);
+
+    bool notify = m_batchDepth == 0 && isExposed(group);
+    m_pendingRemove.push(notify);
+    if (!notify) {
+        return;
+    }
+
     QModelIndex parentIndex = parent(group);
     Q_ASSERT(parentIndex.isValid());
     int pos = group->parentGroup()->children().indexOf(group);
@@ -371,13 +490,32 @@ void GroupModel::groupAboutToRemove(Group* group)
 
 void GroupModel::groupRemoved()
 {
-    endRemoveRows();
+    Q_ASSERT(!m_pendingRemove.isEmpty());
+    if (m_pendingRemove.pop()) {
+        endRemoveRows();
+    }
 }
 
 void GroupModel::groupAboutToAdd(Group* group, int index)
 {
     Q_ASSERT(group->parentGroup());
 
+    m_entryCounts.clear();
+
+    // group is not yet part of its parent's children, an empty parent
+    // therefore counts as fetched and becomes fetched with this insert
+    Group* parentGroup = group->parentGroup();
+    bool visible = isExposed(parentGroup) && isFetched(parentGroup);
+    if (visible) {
+        m_fetched.insert(parentGroup);
+    }
+
+    bool notify = visible && m_batchDepth == 0;
+    m_pendingAdd.push(notify);
+    if (!notify) {
+        return;
+    }
+
     QModelIndex parentIndex = parent(group);
 
     beginInsertRows(parentIndex, index, index);
@@ -385,30 +523,78 @@ void GroupModel::groupAboutToAdd(Group* group, int index)
 
 void GroupModel::groupAdded()
 {
-    endInsertRows();
+    Q_ASSERT(!m_pendingAdd.isEmpty());
+    if (m_pendingAdd.pop()) {
+        endInsertRows();
+    }
 }
 
 void GroupModel::groupAboutToMove(Group* group, Group* toGroup, int pos)
 {
     Q_ASSERT(group->parentGroup());
 
-    QModelIndex oldParentIndex = parent(group);
-    QModelIndex newParentIndex = index(toGroup);
-    int oldPos = group->parentGroup()->children().indexOf(group);
-    if (group->parentGroup() == toGroup && pos > oldPos) {
-        // beginMoveRows() has a bit different semantics than Group::setParent() and
-        // QList::move() when the new position is greater than the old
-        pos++;
+    m_entryCounts.clear();
+
+    Group* oldParent = group->parentGroup();
+    bool oldVisible = isExposed(group);
+    bool newVisible = isExposed(toGroup) && isFetched(toGroup);
+
+    if (newVisible) {
+        m_fetched.insert(toGroup);
+    } else {
+        // the subtree is no longer shown, collapse it lazily again
+        forgetFetched(group);
     }
 
-    bool moveResult = beginMoveRows(oldParentIndex, oldPos, oldPos, newParentIndex, pos);
-    Q_UNUSED(moveResult);
-    Q_ASSERT(moveResult);
+    if (m_batchDepth > 0) {
+        m_pendingMove.push(PendingMove::None);
+        return;
+    }
+
+    int oldPos = oldParent->children().indexOf(group);
+    if (oldVisible && newVisible) {
+        if (oldParent == toGroup && pos > oldPos) {
+            // beginMoveRows() has a bit different semantics than Group::setParent() and
+            // QList::move() when the new position is greater than the old
+            pos++;
+        }
+
+        bool moveResult = beginMoveRows(parent(group), oldPos, oldPos, groupIndex(toGroup), pos);
+        Q_UNUSED(moveResult);
+        Q_ASSERT(moveResult);
+        m_pendingMove.push(PendingMove::Move);
+    } else if (oldVisible) {
+        beginRemoveRows(parent(group), oldPos, oldPos);
+        m_pendingMove.push(PendingMove::Remove);
+    } else if (newVisible) {
+        beginInsertRows(groupIndex(toGroup), pos, pos);
+        m_pendingMove.push(PendingMove::Insert);
+    } else {
+        m_pendingMove.push(PendingMove::None);
+    }
 }
 
 void GroupModel::groupMoved()
 {
-    endMoveRows();
+    Q_ASSERT(!m_pendingMove.isEmpty());
+    switch (m_pendingMove.pop()) {
+    case PendingMove::Move:
+        endMoveRows();
+        break;
+    case PendingMove::Remove:
+        endRemoveRows();
+        break;
+    case PendingMove::Insert:
+        endInsertRows();
+        break;
+    case PendingMove::None:
+        break;
+    }
+}
+
+void GroupModel::clearEntryCounts()
+{
+    m_entryCounts.clear();
 }
 
 void GroupModel::sortChildren(Group* rootGroup, bool reverse)
@@ -433,7 +619,59 @@ void GroupModel::sortChildren(Group* rootGroup, bool reverse)
 void GroupModel::collectIndexesRecursively(QList<QModelIndex>& indexes, QList<Group*> groups)
 {
     for (auto group : groups) {
-        indexes.append(index(group));
-        collectIndexesRecursively(indexes, group->children());
+        indexes.append(groupIndex(group));
+        // unfetched children have no persistent indexes to update
+        if (m_fetched.contains(group)) {
+            collectIndexesRecursively(indexes, group->children());
+        }
+    }
+}
+
+bool GroupModel::isFetched(const Group* group) const
+{
+    return m_fetched.contains(group) || group->children().isEmpty();
+}
+
+/**
+ * @return true if the group is visible to views, i.e. all of its ancestors
+ *         in this model's database have been fetched
+ */
+bool GroupModel::isExposed(const Group* group) const
+{
+    const Group* top = group;
+    for (const Group* parentGroup = group->parentGroup(); parentGroup; parentGroup = parentGroup->parentGroup()) {
+        if (!m_fetched.contains(parentGroup)) {
+            return false;
+        }
+        top = parentGroup;
+    }
+    return m_db && top == m_db->rootGroup();
+}
+
+void GroupModel::forgetFetched(const Group* group)
+{
+    if (m_fetched.remove(group)) {
+        for (const Group* child : group->children()) {
+            forgetFetched(child);
+        }
+    }
+}
+
+/**
+ * @return number of entries in the group and all of its subgroups,
+ *         cached until the next structural change
+ */
+int GroupModel::entryCount(const Group* group) const
+{
+    auto it = m_entryCounts.constFind(group);
+    if (it != m_entryCounts.constEnd()) {
+        return it.value();
+    }
+
+    int count = group->entries().size();
+    for (const Group* child : group->children()) {
+        count += entryCount(child);
     }
+    m_entryCounts.insert(group, count);
+    return count;
 }
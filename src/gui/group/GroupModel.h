@@ -19,6 +19,10 @@
 #define KEEPASSX_GROUPMODEL_H
 
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QStack>
 
 class Database;
 class Group;
@@ -30,11 +34,14 @@ class GroupModel : public QAbstractItemModel
 public:
     explicit GroupModel(Database* db, QObject* parent = nullptr);
     void changeDatabase(Database* newDb);
-    QModelIndex index(Group* group) const;
+    QModelIndex index(Group* group);
     Group* groupFromIndex(const QModelIndex& index) const;
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
     QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
     QModelIndex parent(const QModelIndex& index) const override;
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
@@ -46,10 +53,28 @@ public:
     QStringList mimeTypes() const override;
     QMimeData* mimeData(const QModelIndexList& indexes) const override;
     void sortChildren(Group* rootGroup, bool reverse = false);
+    void fetchParents(Group* group);
+
+public slots:
+    void beginBatchUpdate();
+    void endBatchUpdate();
 
 private:
+    enum class PendingMove
+    {
+        None,
+        Move,
+        Remove,
+        Insert
+    };
+
+    QModelIndex groupIndex(Group* group) const;
     QModelIndex parent(Group* group) const;
     void collectIndexesRecursively(QList<QModelIndex>& indexes, QList<Group*> groups);
+    bool isFetched(const Group* group) const;
+    bool isExposed(const Group* group) const;
+    void forgetFetched(const Group* group);
+    int entryCount(const Group* group) const;
 
 private slots:
     void groupDataChanged(Group* group);
@@ -59,9 +84,22 @@ private slots:
     void groupAdded();
     void groupAboutToMove(Group* group, Group* toGroup, int pos);
     void groupMoved();
+    void clearEntryCounts();
 
 private:
     Database* m_db;
+
+    // Groups whose children have been exposed to views through fetchMore()
+    QSet<const Group*> m_fetched;
+    QStack<bool> m_pendingAdd;
+    QStack<bool> m_pendingRemove;
+    QStack<PendingMove> m_pendingMove;
+
+    int m_batchDepth;
+    QModelIndexList m_batchIndexes;
+    QList<QPointer<Group>> m_batchGroups;
+
+    mutable QHash<const Group*, int> m_entryCounts;
 };
 
 #endif // KEEPASSX_GROUPMODEL_H
@@ -39,6 +39,7 @@ GroupView::GroupView(Database* db, QWidget* parent)
     connect(this, SIGNAL(expanded(QModelIndex)), SLOT(expandedChanged(QModelIndex)));
     connect(this, SIGNAL(collapsed(QModelIndex)), SLOT(expandedChanged(QModelIndex)));
     connect(m_model, SIGNAL(rowsInserted(QModelIndex,int,int)), SLOT(syncExpandedState(QModelIndex,int,int)));
+    connect(m_model, SIGNAL(layoutChanged()), SLOT(syncExpandedState()));
     connect(m_model, SIGNAL(modelReset()), SLOT(modelReset()));
     connect(selectionModel(), SIGNAL(currentChanged(QModelIndex,QModelIndex)), SLOT(emitGroupChanged()));
     // clang-format on
@@ -110,19 +111,34 @@ void GroupView::expandedChanged(const QModelIndex& index)
 
 void GroupView::recInitExpanded(Group* group)
 {
-    m_updatingExpanded = true;
-    expandGroup(group, group->isExpanded());
-    m_updatingExpanded = false;
+    QModelIndex index = m_model->index(group);
+    bool expanded = group->isExpanded();
+    // Freshly fetched children are synced through syncExpandedState(),
+    // children of collapsed groups are not fetched until expanded
+    bool recurse = !m_model->canFetchMore(index);
 
-    const QList<Group*> children = group->children();
-    for (Group* child : children) {
-        recInitExpanded(child);
+    bool updatingExpanded = m_updatingExpanded;
+    m_updatingExpanded = true;
+    if (expanded) {
+        m_model->fetchMore(index);
+    }
+    setExpanded(index, expanded);
+    m_updatingExpanded = updatingExpanded;
+
+    if (recurse) {
+        const QList<Group*> children = group->children();
+        for (Group* child : children) {
+            recInitExpanded(child);
+        }
     }
 }
 
 void GroupView::expandGroup(Group* group, bool expand)
 {
     QModelIndex index = m_model->index(group);
+    if (expand) {
+        m_model->fetchMore(index);
+    }
     setExpanded(index, expand);
 }
 
@@ -153,12 +169,22 @@ void GroupView::syncExpandedState(const QModelIndex& parent, int start, int end)
     }
 }
 
+/**
+ * Batched database updates only report a layout change, groups added
+ * during the update are therefore synced with the whole fetched tree.
+ */
+void GroupView::syncExpandedState()
+{
+    syncExpandedState(QModelIndex(), 0, 0);
+}
+
 void GroupView::setCurrentGroup(Group* group)
 {
-    if (group == nullptr)
+    if (group == nullptr) {
         setCurrentIndex(QModelIndex());
-    else
+    } else {
         setCurrentIndex(m_model->index(group));
+    }
 }
 
 void GroupView::modelReset()
@@ -44,6 +44,7 @@ private slots:
     void expandedChanged(const QModelIndex& index);
     void emitGroupChanged();
     void syncExpandedState(const QModelIndex& parent, int start, int end);
+    void syncExpandedState();
     void modelReset();
     void contextMenuShortcutPressed();
 
@@ -22,6 +22,7 @@
 #include "core/DatabaseIcons.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
+#include "core/Tracing.h"
 #include "crypto/ssh/OpenSSHKey.h"
 #include "keeshare/ShareObserver.h"
 #include "keeshare/Signature.h"
@@ -97,13 +98,25 @@ bool KeeShare::isShared(const Group* group)
 }
 
 KeeShareSettings::Reference KeeShare::referenceOf(const Group* group)
+{
+    return decodeReference(encodedReferenceOf(group));
+}
+
+/**
+ * @return the reference as stored in the custom data of the group, cheap to compare
+ *         against a previous value before paying for decodeReference()
+ */
+QString KeeShare::encodedReferenceOf(const Group* group)
+{
+    return group->customData()->value(KeeShare_Reference);
+}
+
+KeeShareSettings::Reference KeeShare::decodeReference(const QString& encoded)
 {
     static const KeeShareSettings::Reference s_emptyReference;
-    const CustomData* customData = group->customData();
-    if (!customData->contains(KeeShare_Reference)) {
+    if (encoded.isEmpty()) {
         return s_emptyReference;
     }
-    const auto encoded = customData->value(KeeShare_Reference);
     const auto serialized = QString::fromUtf8(QByteArray::fromBase64(encoded.toLatin1()));
     KeeShareSettings::Reference reference = KeeShareSettings::Reference::deserialize(serialized);
     if (reference.isNull()) {
@@ -230,6 +243,7 @@ QString KeeShare::indicatorSuffix(const Group* group, const QString& text)
 
 void KeeShare::connectDatabase(QSharedPointer<Database> newDb, QSharedPointer<Database> oldDb)
 {
+    TRACE_SPAN("KeeShare::connectDatabase", "plugins,keeshare");
     if (oldDb && m_observersByDatabase.contains(oldDb->uuid())) {
         QPointer<ShareObserver> observer = m_observersByDatabase.take(oldDb->uuid());
         if (observer) {
@@ -54,6 +54,8 @@ public:
     static void setOwn(const KeeShareSettings::Own& own);
 
     static KeeShareSettings::Reference referenceOf(const Group* group);
+    static QString encodedReferenceOf(const Group* group);
+    static KeeShareSettings::Reference decodeReference(const QString& encoded);
     static void setReferenceTo(Group* group, const KeeShareSettings::Reference& reference);
     static QString referenceTypeLabel(const KeeShareSettings::Reference& reference);
 
@@ -18,11 +18,17 @@
 #include "config-keepassx.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
+#include "crypto/CryptoHash.h"
+#include "crypto/kdf/Kdf.h"
+#include "format/KdbxXmlWriter.h"
 #include "format/KeePass2Writer.h"
 #include "keeshare/KeeShare.h"
 #include "keeshare/Signature.h"
 #include "keys/PasswordKey.h"
 
+#include <QtConcurrent>
+#include <functional>
+
 #if defined(WITH_XC_KEESHARE_SECURE)
 #include <quazip.h>
 #include <quazipfile.h>
@@ -58,6 +64,8 @@ namespace
     {
         const auto* sourceDb = sourceRoot->database();
         auto* targetDb = new Database();
+        // the database is written on a worker thread, it must not start its modified timer
+        targetDb->setEmitModified(false);
         auto* targetMetadata = targetDb->metadata();
         targetMetadata->setRecycleBinEnabled(false);
         auto key = QSharedPointer<CompositeKey>::create();
@@ -78,11 +86,12 @@ namespace
             targetEntry->setUpdateTimeinfo(updateTimeinfo);
             const auto iconUuid = targetEntry->iconUuid();
             if (!iconUuid.isNull() && !targetMetadata->containsCustomIcon(iconUuid)) {
-                targetMetadata->addCustomIcon(iconUuid, sourceEntry->icon());
+                targetMetadata->addCustomIcon(iconUuid, sourceDb->metadata()->customIconData(iconUuid));
             }
         }
 
-        targetDb->setKey(key);
+        // the key is transformed when the database is written, unless it can be reused from the last export
+        targetDb->setKey(key, true, false, false);
         auto* obsoleteRoot = targetDb->rootGroup();
         targetDb->setRootGroup(targetRoot);
         delete obsoleteRoot;
@@ -104,12 +113,67 @@ namespace
         return targetDb;
     }
 
-    ShareObserver::Result
-    intoSignedContainer(const QString& resolvedPath, const KeeShareSettings::Reference& reference, Database* targetDb)
+    void addAttachments(CryptoHash& hash, const Entry* entry)
+    {
+        const auto* attachments = entry->attachments();
+        for (const QString& key : attachments->keys()) {
+            const QByteArray data = attachments->value(key);
+            // sizes keep the boundaries between key and data unambiguous
+            hash.addData(QByteArray::number(key.size()) + ':' + key.toUtf8());
+            hash.addData(QByteArray::number(data.size()) + ':' + data);
+        }
+    }
+
+    /**
+     * Digest of everything that ends up in the container. The metadata of the export database
+     * only holds the timestamps of the export itself, so only the custom icons are taken from it.
+     * The XML only refers to attachments by their index in the binary pool, so their content
+     * is added separately.
+     */
+    QByteArray contentDigest(Database* targetDb,
+                             const KeeShareSettings::Reference& reference,
+                             const KeeShareSettings::Own& own)
+    {
+        QByteArray xml;
+        {
+            QBuffer buffer(&xml);
+            buffer.open(QIODevice::WriteOnly);
+            KdbxXmlWriter writer(KeePass2::FILE_VERSION_4);
+            writer.disableInnerStreamProtection(true);
+            writer.writeDatabase(&buffer, targetDb);
+        }
+
+        CryptoHash hash(CryptoHash::Sha256);
+        hash.addData(xml.mid(qMax(0, xml.indexOf("</Meta>"))));
+        const auto entries = targetDb->rootGroup()->entriesRecursive(false);
+        for (const Entry* entry : entries) {
+            hash.addData(entry->uuid().toRfc4122());
+            addAttachments(hash, entry);
+            for (const Entry* historyItem : entry->historyItems()) {
+                addAttachments(hash, historyItem);
+            }
+        }
+        const auto* metadata = targetDb->metadata();
+        for (const QUuid& uuid : metadata->customIconsOrder()) {
+            hash.addData(uuid.toRfc4122());
+            hash.addData(metadata->customIconData(uuid));
+        }
+        hash.addData(KeeShareSettings::Reference::serialize(reference).toUtf8());
+        hash.addData(KeeShareSettings::Own::serialize(own).toUtf8());
+        return hash.result();
+    }
+
+    ShareObserver::Result intoSignedContainer(const QString& resolvedPath,
+                                              const KeeShareSettings::Reference& reference,
+                                              const KeeShareSettings::Own& own,
+                                              Database* targetDb,
+                                              bool reuseKey)
     {
 #if !defined(WITH_XC_KEESHARE_SECURE)
         Q_UNUSED(targetDb);
         Q_UNUSED(resolvedPath);
+        Q_UNUSED(own);
+        Q_UNUSED(reuseKey);
         return {reference.path,
                 ShareObserver::Result::Warning,
                 ShareExport::tr("Overwriting signed share container is not supported - export prevented")};
@@ -119,13 +183,13 @@ namespace
             QBuffer buffer(&bytes);
             buffer.open(QIODevice::WriteOnly);
             KeePass2Writer writer;
+            writer.setReuseTransformedKey(reuseKey);
             writer.writeDatabase(&buffer, targetDb);
             if (writer.hasError()) {
                 qWarning("Serializing export dabase failed: %s.", writer.errorString().toLatin1().data());
                 return {reference.path, ShareObserver::Result::Error, writer.errorString()};
             }
         }
-        const auto own = KeeShare::own();
         QuaZip zip(resolvedPath);
         zip.setFileNameCodec("UTF-8");
         const bool zipOpened = zip.open(QuaZip::mdCreate);
@@ -186,12 +250,15 @@ namespace
 #endif
     }
 
-    ShareObserver::Result
-    intoUnsignedContainer(const QString& resolvedPath, const KeeShareSettings::Reference& reference, Database* targetDb)
+    ShareObserver::Result intoUnsignedContainer(const QString& resolvedPath,
+                                                const KeeShareSettings::Reference& reference,
+                                                Database* targetDb,
+                                                bool reuseKey)
     {
 #if !defined(WITH_XC_KEESHARE_INSECURE)
         Q_UNUSED(targetDb);
         Q_UNUSED(resolvedPath);
+        Q_UNUSED(reuseKey);
         return {reference.path,
                 ShareObserver::Result::Warning,
                 ShareExport::tr("Overwriting unsigned share container is not supported - export prevented")};
@@ -203,6 +270,7 @@ namespace
             return {reference.path, ShareObserver::Result::Error, ShareExport::tr("Could not write export container")};
         }
         KeePass2Writer writer;
+        writer.setReuseTransformedKey(reuseKey);
         writer.writeDatabase(&file, targetDb);
         if (writer.hasError()) {
             qWarning("Exporting dabase failed: %s.", writer.errorString().toLatin1().data());
@@ -213,20 +281,101 @@ namespace
         return {reference.path};
     }
 
+    struct Job
+    {
+        ShareExport::Target target;
+        KeeShareSettings::Own own;
+        QSharedPointer<Database> targetDb;
+        ShareObserver::ExportState state;
+        ShareObserver::Result result;
+    };
+
+    /**
+     * Write a single container, runs on the global thread pool.
+     */
+    Job exportJob(const Job& input)
+    {
+        Job job = input;
+        const auto& reference = job.target.reference;
+        const QString& resolvedPath = job.target.resolvedPath;
+        Database* targetDb = job.targetDb.data();
+
+        // The KDF dominates the export, skip it if the password did not change since the last export
+        const bool reuseKey = job.state.kdf && job.state.password == reference.password;
+        if (reuseKey) {
+            targetDb->setTransformedKey(targetDb->key(), job.state.kdf->clone(), job.state.transformedMasterKey);
+        }
+
+        const QFileInfo info(resolvedPath);
+        if (KeeShare::isContainerType(info, KeeShare::signedContainerFileType())) {
+            job.result = intoSignedContainer(resolvedPath, reference, job.own, targetDb, reuseKey);
+        } else if (KeeShare::isContainerType(info, KeeShare::unsignedContainerFileType())) {
+            job.result = intoUnsignedContainer(resolvedPath, reference, targetDb, reuseKey);
+        } else {
+            Q_ASSERT(false);
+            job.result = {
+                reference.path, ShareObserver::Result::Error, ShareExport::tr("Unexpected export error occurred")};
+        }
+
+        if (job.result.isError() || job.result.isWarning()) {
+            // export again on the next save
+            job.state = ShareObserver::ExportState();
+            return job;
+        }
+
+        job.state.lastModified = QFileInfo(resolvedPath).lastModified();
+        job.state.password = reference.password;
+        job.state.kdf = targetDb->kdf()->clone();
+        job.state.transformedMasterKey = targetDb->transformedMasterKey();
+        return job;
+    }
 } // namespace
 
-ShareObserver::Result ShareExport::intoContainer(const QString& resolvedPath,
-                                                 const KeeShareSettings::Reference& reference,
-                                                 const Group* group)
+/**
+ * Export the given groups into their containers.
+ *
+ * The groups are extracted on the calling thread, the containers are written concurrently
+ * on the global thread pool. Targets whose content did not change since the last export
+ * recorded in states are skipped, the derived key of a share is reused while its password
+ * stays the same.
+ *
+ * @param targets groups to export
+ * @param states state of the last export per resolved path, updated on return
+ * @return one result per target
+ */
+QList<ShareObserver::Result> ShareExport::intoContainers(const QList<Target>& targets,
+                                                         QHash<QString, ShareObserver::ExportState>& states)
 {
-    QScopedPointer<Database> targetDb(extractIntoDatabase(reference, group));
-    const QFileInfo info(resolvedPath);
-    if (KeeShare::isContainerType(info, KeeShare::signedContainerFileType())) {
-        return intoSignedContainer(resolvedPath, reference, targetDb.data());
+    const auto own = KeeShare::own();
+
+    QList<ShareObserver::Result> results;
+    QList<Job> jobs;
+    for (const Target& target : targets) {
+        Job job;
+        job.target = target;
+        job.own = own;
+        job.targetDb.reset(extractIntoDatabase(target.reference, target.group));
+        job.state = states.value(target.resolvedPath);
+
+        const QByteArray digest = contentDigest(job.targetDb.data(), target.reference, own);
+        const QFileInfo info(target.resolvedPath);
+        if (digest == job.state.digest && info.exists() && info.lastModified() == job.state.lastModified) {
+            // the container is up to date
+            results << ShareObserver::Result{target.reference.path};
+            continue;
+        }
+        job.state.digest = digest;
+        jobs << job;
+    }
+
+    if (jobs.isEmpty()) {
+        return results;
     }
-    if (KeeShare::isContainerType(info, KeeShare::unsignedContainerFileType())) {
-        return intoUnsignedContainer(resolvedPath, reference, targetDb.data());
+
+    const QList<Job> finished = QtConcurrent::mapped(jobs, std::function<Job(const Job&)>(&exportJob)).results();
+    for (const Job& job : finished) {
+        states[job.target.resolvedPath] = job.state;
+        results << job.result;
     }
-    Q_ASSERT(false);
-    return {reference.path, ShareObserver::Result::Error, tr("Unexpected export error occurred")};
+    return results;
 }
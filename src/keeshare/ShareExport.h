@@ -17,6 +17,8 @@
 #ifndef KEEPASSXC_SHAREEXPORT_H
 #define KEEPASSXC_SHAREEXPORT_H
 
+#include <QHash>
+
 #include "keeshare/KeeShareSettings.h"
 #include "keeshare/ShareObserver.h"
 
@@ -26,8 +28,15 @@ class ShareExport
 {
     Q_DECLARE_TR_FUNCTIONS(ShareExport)
 public:
-    static ShareObserver::Result
-    intoContainer(const QString& resolvedPath, const KeeShareSettings::Reference& reference, const Group* group);
+    struct Target
+    {
+        QString resolvedPath;
+        KeeShareSettings::Reference reference;
+        const Group* group;
+    };
+
+    static QList<ShareObserver::Result> intoContainers(const QList<Target>& targets,
+                                                       QHash<QString, ShareObserver::ExportState>& states);
 
 private:
     ShareExport() = delete;
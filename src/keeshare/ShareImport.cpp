@@ -17,11 +17,14 @@
 #include "ShareImport.h"
 #include "config-keepassx.h"
 #include "core/Merger.h"
+#include "crypto/CryptoHash.h"
 #include "format/KeePass2Reader.h"
 #include "keeshare/KeeShare.h"
 #include "keeshare/Signature.h"
 #include "keys/PasswordKey.h"
 
+#include <QBuffer>
+#include <QCoreApplication>
 #include <QMessageBox>
 #include <QPushButton>
 
@@ -43,23 +46,15 @@ namespace
     };
 
     QPair<Trust, KeeShareSettings::Certificate>
-    check(QByteArray& data,
-          const KeeShareSettings::Reference& reference,
+    check(const KeeShareSettings::Reference& reference,
           const KeeShareSettings::Certificate& ownCertificate,
           const QList<KeeShareSettings::ScopedCertificate>& knownCertificates,
           const KeeShareSettings::Sign& sign)
     {
+        // the signature was already verified by ShareImport::load()
         KeeShareSettings::Certificate certificate;
         if (!sign.signature.isEmpty()) {
             certificate = sign.certificate;
-            auto key = sign.certificate.sshKey();
-            key.openKey(QString());
-            const auto signer = Signature();
-            if (!signer.verify(data, sign.signature, key)) {
-                qCritical("Invalid signature for shared container %s.", qPrintable(reference.path));
-                return {Invalid, KeeShareSettings::Certificate()};
-            }
-
             if (ownCertificate.key == sign.certificate.key) {
                 return {Own, ownCertificate};
             }
@@ -123,12 +118,107 @@ namespace
         return {UntrustedOnce, certificate};
     }
 
+    void rememberTrust(const KeeShareSettings::Reference& reference,
+                       const QPair<Trust, KeeShareSettings::Certificate>& trust)
+    {
+        auto foreign = KeeShare::foreign();
+        bool found = false;
+        const auto trusted =
+            trust.first == TrustedForever ? KeeShareSettings::Trust::Trusted : KeeShareSettings::Trust::Untrusted;
+        for (KeeShareSettings::ScopedCertificate& scopedCertificate : foreign.certificates) {
+            if (scopedCertificate.certificate.key == trust.second.key && scopedCertificate.path == reference.path) {
+                scopedCertificate.certificate.signer = trust.second.signer;
+                scopedCertificate.path = reference.path;
+                scopedCertificate.trust = trusted;
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            foreign.certificates << KeeShareSettings::ScopedCertificate{reference.path, trust.second, trusted};
+        }
+        // update foreign certificates with new settings
+        KeeShare::setForeign(foreign);
+    }
+
     ShareObserver::Result
-    signedContainerInto(const QString& resolvedPath, const KeeShareSettings::Reference& reference, Group* targetGroup)
+    synchronize(const ShareObserver::Container& container, Group* targetGroup, const QString& successMessage)
+    {
+        qDebug("Synchronize %s %s with %s",
+               qPrintable(container.reference.path),
+               qPrintable(targetGroup->name()),
+               qPrintable(container.database->rootGroup()->name()));
+        Merger merger(container.database->rootGroup(), targetGroup);
+        merger.setForcedMergeMode(Group::Synchronize);
+        const auto changelist = merger.merge();
+        if (changelist.isEmpty()) {
+            // Silent ignore of unchanging import
+            return {};
+        }
+        return {container.reference.path, ShareObserver::Result::Success, successMessage};
+    }
+
+    ShareObserver::Result signedContainerInto(const ShareObserver::Container& container, Group* targetGroup)
+    {
+        const auto own = KeeShare::own();
+        const auto foreign = KeeShare::foreign();
+        const auto trust = check(container.reference, own.certificate, foreign.certificates, container.sign);
+        switch (trust.first) {
+        case UntrustedForever:
+        case TrustedForever: {
+            rememberTrust(container.reference, trust);
+            if (trust.first == TrustedForever) {
+                return synchronize(container, targetGroup, ShareImport::tr("Successful signed import"));
+            }
+            // Silent ignore of untrusted import
+            return {};
+        }
+        case TrustedOnce:
+        case Own: {
+            return synchronize(container, targetGroup, ShareImport::tr("Successful signed import"));
+        }
+        default:
+            Q_ASSERT(false);
+            return {container.reference.path, ShareObserver::Result::Error, ShareImport::tr("Unexpected error")};
+        }
+    }
+
+    ShareObserver::Result unsignedContainerInto(const ShareObserver::Container& container, Group* targetGroup)
+    {
+        const auto own = KeeShare::own();
+        const auto sign = KeeShareSettings::Sign(); // invalid sign
+        const auto foreign = KeeShare::foreign();
+        const auto trust = check(container.reference, own.certificate, foreign.certificates, sign);
+        switch (trust.first) {
+        case UntrustedForever:
+        case TrustedForever: {
+            rememberTrust(container.reference, trust);
+            if (trust.first == TrustedForever) {
+                return synchronize(container, targetGroup, ShareImport::tr("Successful signed import"));
+            }
+            return {};
+        }
+
+        case TrustedOnce: {
+            return synchronize(container, targetGroup, ShareImport::tr("Successful unsigned import"));
+        }
+        default:
+            qWarning("Prevent untrusted import");
+            return {container.reference.path,
+                    ShareObserver::Result::Warning,
+                    ShareImport::tr("Untrusted import prevented")};
+        }
+    }
+
+    ShareObserver::Result readSignedContainer(const QString& resolvedPath,
+                                              const KeeShareSettings::Reference& reference,
+                                              QByteArray& payload,
+                                              KeeShareSettings::Sign& sign)
     {
 #if !defined(WITH_XC_KEESHARE_SECURE)
-        Q_UNUSED(targetGroup);
         Q_UNUSED(resolvedPath);
+        Q_UNUSED(payload);
+        Q_UNUSED(sign);
         return {reference.path,
                 ShareObserver::Result::Warning,
                 ShareImport::tr("Signed share container are not supported - import prevented")};
@@ -154,97 +244,25 @@ namespace
         signatureFile.open(QuaZipFile::ReadOnly);
         QTextStream stream(&signatureFile);
 
-        const auto sign = KeeShareSettings::Sign::deserialize(stream.readAll());
+        sign = KeeShareSettings::Sign::deserialize(stream.readAll());
         signatureFile.close();
 
         zip.setCurrentFile(KeeShare::containerFileName());
         QuaZipFile databaseFile(&zip);
         databaseFile.open(QuaZipFile::ReadOnly);
-        auto payload = databaseFile.readAll();
+        payload = databaseFile.readAll();
         databaseFile.close();
-        QBuffer buffer(&payload);
-        buffer.open(QIODevice::ReadOnly);
-
-        KeePass2Reader reader;
-        auto key = QSharedPointer<CompositeKey>::create();
-        key->addKey(QSharedPointer<PasswordKey>::create(reference.password));
-        auto sourceDb = QSharedPointer<Database>::create();
-        if (!reader.readDatabase(&buffer, key, sourceDb.data())) {
-            qCritical("Error while parsing the database: %s", qPrintable(reader.errorString()));
-            return {reference.path, ShareObserver::Result::Error, reader.errorString()};
-        }
-
-        auto foreign = KeeShare::foreign();
-        auto own = KeeShare::own();
-        auto trust = check(payload, reference, own.certificate, foreign.certificates, sign);
-        switch (trust.first) {
-        case Invalid:
-            qWarning("Prevent untrusted import");
-            return {reference.path, ShareObserver::Result::Error, ShareImport::tr("Untrusted import prevented")};
-
-        case UntrustedForever:
-        case TrustedForever: {
-            bool found = false;
-            const auto trusted =
-                trust.first == TrustedForever ? KeeShareSettings::Trust::Trusted : KeeShareSettings::Trust::Untrusted;
-            for (KeeShareSettings::ScopedCertificate& scopedCertificate : foreign.certificates) {
-                if (scopedCertificate.certificate.key == trust.second.key && scopedCertificate.path == reference.path) {
-                    scopedCertificate.certificate.signer = trust.second.signer;
-                    scopedCertificate.path = reference.path;
-                    scopedCertificate.trust = trusted;
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                foreign.certificates << KeeShareSettings::ScopedCertificate{reference.path, trust.second, trusted};
-            }
-            // update foreign certificates with new settings
-            KeeShare::setForeign(foreign);
-
-            if (trust.first == TrustedForever) {
-                qDebug("Synchronize %s %s with %s",
-                       qPrintable(reference.path),
-                       qPrintable(targetGroup->name()),
-                       qPrintable(sourceDb->rootGroup()->name()));
-                Merger merger(sourceDb->rootGroup(), targetGroup);
-                merger.setForcedMergeMode(Group::Synchronize);
-                auto changelist = merger.merge();
-                if (!changelist.isEmpty()) {
-                    return {
-                        reference.path, ShareObserver::Result::Success, ShareImport::tr("Successful signed import")};
-                }
-            }
-            // Silent ignore of untrusted import or unchanging import
-            return {};
-        }
-        case TrustedOnce:
-        case Own: {
-            qDebug("Synchronize %s %s with %s",
-                   qPrintable(reference.path),
-                   qPrintable(targetGroup->name()),
-                   qPrintable(sourceDb->rootGroup()->name()));
-            Merger merger(sourceDb->rootGroup(), targetGroup);
-            merger.setForcedMergeMode(Group::Synchronize);
-            auto changelist = merger.merge();
-            if (!changelist.isEmpty()) {
-                return {reference.path, ShareObserver::Result::Success, ShareImport::tr("Successful signed import")};
-            }
-            return {};
-        }
-        default:
-            Q_ASSERT(false);
-            return {reference.path, ShareObserver::Result::Error, ShareImport::tr("Unexpected error")};
-        }
+        return {};
 #endif
     }
 
-    ShareObserver::Result
-    unsignedContainerInto(const QString& resolvedPath, const KeeShareSettings::Reference& reference, Group* targetGroup)
+    ShareObserver::Result readUnsignedContainer(const QString& resolvedPath,
+                                                const KeeShareSettings::Reference& reference,
+                                                QByteArray& payload)
     {
 #if !defined(WITH_XC_KEESHARE_INSECURE)
-        Q_UNUSED(targetGroup);
         Q_UNUSED(resolvedPath);
+        Q_UNUSED(payload);
         return {reference.path,
                 ShareObserver::Result::Warning,
                 ShareImport::tr("Unsigned share container are not supported - import prevented")};
@@ -254,98 +272,136 @@ namespace
             qCritical("Unable to open file %s.", qPrintable(reference.path));
             return {reference.path, ShareObserver::Result::Error, ShareImport::tr("File is not readable")};
         }
-        auto payload = file.readAll();
+        payload = file.readAll();
         file.close();
-        QBuffer buffer(&payload);
-        buffer.open(QIODevice::ReadOnly);
-
-        KeePass2Reader reader;
-        auto key = QSharedPointer<CompositeKey>::create();
-        key->addKey(QSharedPointer<PasswordKey>::create(reference.password));
-        auto sourceDb = QSharedPointer<Database>::create();
-        if (!reader.readDatabase(&buffer, key, sourceDb.data())) {
-            qCritical("Error while parsing the database: %s", qPrintable(reader.errorString()));
-            return {reference.path, ShareObserver::Result::Error, reader.errorString()};
-        }
-
-        auto foreign = KeeShare::foreign();
-        const auto own = KeeShare::own();
-        const auto sign = KeeShareSettings::Sign(); // invalid sign
-        auto trust = check(payload, reference, own.certificate, foreign.certificates, sign);
-        switch (trust.first) {
-        case UntrustedForever:
-        case TrustedForever: {
-            bool found = false;
-            const auto trusted =
-                trust.first == TrustedForever ? KeeShareSettings::Trust::Trusted : KeeShareSettings::Trust::Untrusted;
-            for (KeeShareSettings::ScopedCertificate& scopedCertificate : foreign.certificates) {
-                if (scopedCertificate.certificate.key == trust.second.key && scopedCertificate.path == reference.path) {
-                    scopedCertificate.certificate.signer = trust.second.signer;
-                    scopedCertificate.path = reference.path;
-                    scopedCertificate.trust = trusted;
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                foreign.certificates << KeeShareSettings::ScopedCertificate{reference.path, trust.second, trusted};
-            }
-            // update foreign certificates with new settings
-            KeeShare::setForeign(foreign);
+        return {};
+#endif
+    }
 
-            if (trust.first == TrustedForever) {
-                qDebug("Synchronize %s %s with %s",
-                       qPrintable(reference.path),
-                       qPrintable(targetGroup->name()),
-                       qPrintable(sourceDb->rootGroup()->name()));
-                Merger merger(sourceDb->rootGroup(), targetGroup);
-                merger.setForcedMergeMode(Group::Synchronize);
-                auto changelist = merger.merge();
-                if (!changelist.isEmpty()) {
-                    return {
-                        reference.path, ShareObserver::Result::Success, ShareImport::tr("Successful signed import")};
-                }
+    /**
+     * @return true if the user decided to never trust the source of a container
+     */
+    bool isUntrusted(const KeeShareSettings::Reference& reference,
+                     const QList<KeeShareSettings::ScopedCertificate>& knownCertificates,
+                     const KeeShareSettings::Sign& sign)
+    {
+        const auto certificate = sign.signature.isEmpty() ? KeeShareSettings::Certificate() : sign.certificate;
+        for (const auto& scopedCertificate : knownCertificates) {
+            if (scopedCertificate.certificate.key == certificate.key && scopedCertificate.path == reference.path) {
+                return scopedCertificate.trust == KeeShareSettings::Trust::Untrusted;
             }
-            return {};
         }
+        return false;
+    }
 
-        case TrustedOnce: {
-            qDebug("Synchronize %s %s with %s",
-                   qPrintable(reference.path),
-                   qPrintable(targetGroup->name()),
-                   qPrintable(sourceDb->rootGroup()->name()));
-            Merger merger(sourceDb->rootGroup(), targetGroup);
-            merger.setForcedMergeMode(Group::Synchronize);
-            auto changelist = merger.merge();
-            if (!changelist.isEmpty()) {
-                return {reference.path, ShareObserver::Result::Success, ShareImport::tr("Successful unsigned import")};
-            }
-            return {};
-        }
-        default:
-            qWarning("Prevent untrusted import");
-            return {reference.path, ShareObserver::Result::Warning, ShareImport::tr("Untrusted import prevented")};
+    bool verifySignature(const QByteArray& payload, const KeeShareSettings::Sign& sign)
+    {
+        if (sign.signature.isEmpty()) {
+            return true;
         }
-#endif
+        auto key = sign.certificate.sshKey();
+        key.openKey(QString());
+        return Signature::verify(payload, sign.signature, key);
     }
 
 } // namespace
 
-ShareObserver::Result ShareImport::containerInto(const QString& resolvedPath,
-                                                 const KeeShareSettings::Reference& reference,
-                                                 Group* targetGroup)
+/**
+ * Read, verify and decrypt a share container. Safe to call on a worker thread,
+ * nothing is merged and no settings are touched.
+ *
+ * @param resolvedPath absolute path of the container
+ * @param reference reference of the importing group
+ * @param foreign trust settings of foreign certificates, untrusted sources are never decrypted
+ * @param knownDigest digest of the container imported last time, the container is not
+ *                    decrypted again if it is unchanged
+ * @return the container, without a database if it is unchanged, untrusted or could not be read
+ */
+ShareObserver::Container ShareImport::load(const QString& resolvedPath,
+                                           const KeeShareSettings::Reference& reference,
+                                           const KeeShareSettings::Foreign& foreign,
+                                           const QByteArray& knownDigest)
 {
+    ShareObserver::Container container;
+    container.resolvedPath = resolvedPath;
+    container.reference = reference;
+
     const QFileInfo info(resolvedPath);
     if (!info.exists()) {
         qCritical("File %s does not exist.", qPrintable(info.absoluteFilePath()));
-        return {reference.path, ShareObserver::Result::Warning, tr("File does not exist")};
+        container.result = {reference.path, ShareObserver::Result::Warning, tr("File does not exist")};
+        return container;
     }
 
+    QByteArray payload;
     if (KeeShare::isContainerType(info, KeeShare::signedContainerFileType())) {
-        return signedContainerInto(resolvedPath, reference, targetGroup);
+        container.result = readSignedContainer(resolvedPath, reference, payload, container.sign);
+    } else if (KeeShare::isContainerType(info, KeeShare::unsignedContainerFileType())) {
+        container.result = readUnsignedContainer(resolvedPath, reference, payload);
+    } else {
+        container.result = {reference.path, ShareObserver::Result::Error, tr("Unknown share container type")};
+    }
+    if (container.result.isValid()) {
+        return container;
+    }
+
+    CryptoHash hash(CryptoHash::Sha256);
+    hash.addData(payload);
+    hash.addData(container.sign.signature.toUtf8());
+    container.digest = hash.result();
+    if (container.digest == knownDigest) {
+        // nothing changed since the last import
+        return container;
     }
-    if (KeeShare::isContainerType(info, KeeShare::unsignedContainerFileType())) {
-        return unsignedContainerInto(resolvedPath, reference, targetGroup);
+
+    if (isUntrusted(reference, foreign.certificates, container.sign)) {
+        // Silent ignore of untrusted import, the digest is dropped so that
+        // the container is imported once the user trusts it
+        qWarning("Prevent untrusted import");
+        container.digest.clear();
+        return container;
+    }
+
+    if (!verifySignature(payload, container.sign)) {
+        qCritical("Invalid signature for shared container %s.", qPrintable(reference.path));
+        qWarning("Prevent untrusted import");
+        container.result = {reference.path, ShareObserver::Result::Error, tr("Untrusted import prevented")};
+        return container;
+    }
+
+    QBuffer buffer(&payload);
+    buffer.open(QIODevice::ReadOnly);
+
+    KeePass2Reader reader;
+    auto key = QSharedPointer<CompositeKey>::create();
+    key->addKey(QSharedPointer<PasswordKey>::create(reference.password));
+    auto sourceDb = QSharedPointer<Database>::create();
+    if (!reader.readDatabase(&buffer, key, sourceDb.data())) {
+        qCritical("Error while parsing the database: %s", qPrintable(reader.errorString()));
+        container.result = {reference.path, ShareObserver::Result::Error, reader.errorString()};
+        return container;
+    }
+
+    // hand the database over to the thread that merges it
+    sourceDb->moveToThread(QCoreApplication::instance()->thread());
+    container.database = sourceDb;
+    return container;
+}
+
+/**
+ * Merge a container returned by load() into targetGroup. Asks the user whether
+ * to trust the container if necessary, must be called on the thread owning targetGroup.
+ *
+ * @return the result of load() if it failed, otherwise the result of the merge
+ */
+ShareObserver::Result ShareImport::apply(const ShareObserver::Container& container, Group* targetGroup)
+{
+    if (container.result.isValid() || !container.database) {
+        return container.result;
+    }
+
+    if (KeeShare::isContainerType(QFileInfo(container.resolvedPath), KeeShare::signedContainerFileType())) {
+        return signedContainerInto(container, targetGroup);
     }
-    return {reference.path, ShareObserver::Result::Error, tr("Unknown share container type")};
+    return unsignedContainerInto(container, targetGroup);
 }
@@ -23,8 +23,11 @@ class ShareImport
 {
     Q_DECLARE_TR_FUNCTIONS(ShareImport)
 public:
-    static ShareObserver::Result
-    containerInto(const QString& resolvedPath, const KeeShareSettings::Reference& reference, Group* targetGroup);
+    static ShareObserver::Container load(const QString& resolvedPath,
+                                         const KeeShareSettings::Reference& reference,
+                                         const KeeShareSettings::Foreign& foreign,
+                                         const QByteArray& knownDigest = QByteArray());
+    static ShareObserver::Result apply(const ShareObserver::Container& container, Group* targetGroup);
 
 public:
     ShareImport() = delete;
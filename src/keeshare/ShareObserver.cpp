@@ -17,6 +17,7 @@
 
 #include "ShareObserver.h"
 #include "core/Config.h"
+#include "core/CustomData.h"
 #include "core/Database.h"
 #include "core/FileWatcher.h"
 #include "core/Global.h"
@@ -25,6 +26,9 @@
 #include "keeshare/ShareExport.h"
 #include "keeshare/ShareImport.h"
 
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
 namespace
 {
     QString resolvePath(const QString& path, QSharedPointer<Database> database)
@@ -38,25 +42,33 @@ ShareObserver::ShareObserver(QSharedPointer<Database> db, QObject* parent)
     : QObject(parent)
     , m_db(std::move(db))
     , m_fileWatcher(new BulkFileWatcher(this))
+    , m_active(false)
+    , m_reinitializing(false)
 {
-    connect(KeeShare::instance(), SIGNAL(activeChanged()), SLOT(handleDatabaseChanged()));
+    connect(KeeShare::instance(), SIGNAL(activeChanged()), SLOT(handleActiveChanged()));
 
-    connect(m_db.data(), SIGNAL(groupDataChanged(Group*)), SLOT(handleDatabaseChanged()));
+    // References live in the custom data of the groups, changes of any other group data are irrelevant
+    connect(m_db.data(), SIGNAL(groupAboutToAdd(Group*,int)), SLOT(handleGroupAboutToAdd(Group*)));
     connect(m_db.data(), SIGNAL(groupAdded()), SLOT(handleDatabaseChanged()));
-    connect(m_db.data(), SIGNAL(groupRemoved()), SLOT(handleDatabaseChanged()));
+    connect(m_db.data(), SIGNAL(groupAboutToRemove(Group*)), SLOT(handleGroupAboutToRemove(Group*)));
+    connect(m_db.data(), SIGNAL(updateFinished(DatabaseChanges)), SLOT(handleDatabaseChanged()));
 
-    connect(m_db.data(), SIGNAL(databaseModified()), SLOT(handleDatabaseChanged()));
+    connect(m_db.data(), SIGNAL(databaseModified()), SLOT(handleDatabaseModified()));
     connect(m_db.data(), SIGNAL(databaseSaved()), SLOT(handleDatabaseSaved()));
 
     connect(m_fileWatcher, SIGNAL(fileCreated(QString)), SLOT(handleFileCreated(QString)));
     connect(m_fileWatcher, SIGNAL(fileChanged(QString)), SLOT(handleFileUpdated(QString)));
     connect(m_fileWatcher, SIGNAL(fileRemoved(QString)), SLOT(handleFileDeleted(QString)));
 
-    handleDatabaseChanged();
+    handleActiveChanged();
 }
 
 ShareObserver::~ShareObserver()
 {
+    // the databases of running imports have to be released on this thread
+    for (const Import& import : asConst(m_imports)) {
+        import.watcher->waitForFinished();
+    }
 }
 
 void ShareObserver::deinitialize()
@@ -64,6 +76,77 @@ void ShareObserver::deinitialize()
     m_fileWatcher->clear();
     m_groupToReference.clear();
     m_referenceToGroup.clear();
+    m_shareToGroup.clear();
+    m_references.clear();
+    m_pending.clear();
+    m_importDigests.clear();
+}
+
+/**
+ * Queue all groups of the database, used when sharing is activated
+ * or the root group of the database was replaced.
+ */
+void ShareObserver::rescan()
+{
+    m_rootGroup = m_db->rootGroup();
+    observe(m_rootGroup);
+    handleDatabaseChanged();
+}
+
+/**
+ * Watch the custom data of group and its children and queue
+ * all groups which carry a reference.
+ */
+void ShareObserver::observe(Group* group)
+{
+    const QList<Group*> groups = group->groupsRecursive(true);
+    for (Group* child : groups) {
+        connect(child->customData(),
+                SIGNAL(customDataModified()),
+                SLOT(handleGroupCustomDataChanged()),
+                Qt::UniqueConnection);
+        if (!KeeShare::encodedReferenceOf(child).isEmpty() || m_groupToReference.contains(child)) {
+            m_pending << child;
+        }
+    }
+}
+
+/**
+ * Stop sharing group and its children, used when they leave the database.
+ */
+void ShareObserver::forget(const Group* group)
+{
+    const QList<const Group*> groups = group->groupsRecursive(true);
+    for (const Group* child : groups) {
+        child->customData()->disconnect(this);
+        m_references.remove(child);
+
+        const auto it = m_groupToReference.find(const_cast<Group*>(child));
+        if (it == m_groupToReference.end()) {
+            continue;
+        }
+        const auto resolvedPath = resolvePath(it.value().path, m_db);
+        m_referenceToGroup.remove(it.value());
+        m_shareToGroup.remove(resolvedPath);
+        m_importDigests.remove(resolvedPath);
+        m_fileWatcher->removePath(resolvedPath);
+        m_groupToReference.erase(it);
+    }
+}
+
+/**
+ * @return the decoded reference of group, only decoded again if its custom data changed
+ */
+KeeShareSettings::Reference ShareObserver::referenceOf(const Group* group)
+{
+    const QString encoded = KeeShare::encodedReferenceOf(group);
+    auto it = m_references.find(group);
+    if (it == m_references.end()) {
+        it = m_references.insert(group, {encoded, KeeShare::decodeReference(encoded)});
+    } else if (it->encoded != encoded) {
+        *it = {encoded, KeeShare::decodeReference(encoded)};
+    }
+    return it->reference;
 }
 
 void ShareObserver::reinitialize()
@@ -75,10 +158,16 @@ void ShareObserver::reinitialize()
         KeeShareSettings::Reference newReference;
     };
 
+    QList<QPointer<Group>> pending;
+    pending.swap(m_pending);
+
     QList<Update> updated;
-    const QList<Group*> groups = m_db->rootGroup()->groupsRecursive(true);
-    for (Group* group : groups) {
-        const Update couple{group, m_groupToReference.value(group), KeeShare::referenceOf(group)};
+    for (Group* group : asConst(pending)) {
+        if (!group || group->database() != m_db.data()) {
+            // deleted or moved to another database in the meantime
+            continue;
+        }
+        const Update couple{group, m_groupToReference.value(group), referenceOf(group)};
         if (couple.oldReference == couple.newReference) {
             continue;
         }
@@ -87,16 +176,18 @@ void ShareObserver::reinitialize()
         m_referenceToGroup.remove(couple.oldReference);
         const auto oldResolvedPath = resolvePath(couple.oldReference.path, m_db);
         m_shareToGroup.remove(oldResolvedPath);
+        m_importDigests.remove(oldResolvedPath);
         if (couple.newReference.isValid()) {
             m_groupToReference[couple.group] = couple.newReference;
             m_referenceToGroup[couple.newReference] = couple.group;
             const auto newResolvedPath = resolvePath(couple.newReference.path, m_db);
             m_shareToGroup[newResolvedPath] = couple.group;
+            // the password may have changed, import even an unchanged container again
+            m_importDigests.remove(newResolvedPath);
         }
         updated << couple;
     }
 
-    QStringList success;
     QStringList warning;
     QStringList error;
     QMap<QString, QStringList> imported;
@@ -118,22 +209,8 @@ void ShareObserver::reinitialize()
 
         if (update.newReference.isImporting()) {
             imported[update.newReference.path] << update.group->name();
-            // import has to occur immediately
-            const auto result = this->importShare(update.newReference.path);
-            if (!result.isValid()) {
-                // tolerable result - blocked import or missing source
-                continue;
-            }
-
-            if (result.isError()) {
-                error << tr("Import from %1 failed (%2)").arg(result.path).arg(result.message);
-            } else if (result.isWarning()) {
-                warning << tr("Import from %1 failed (%2)").arg(result.path).arg(result.message);
-            } else if (result.isInfo()) {
-                success << tr("Import from %1 successful (%2)").arg(result.path).arg(result.message);
-            } else {
-                success << tr("Imported from %1").arg(result.path);
-            }
+            // import has to occur immediately, the result is reported once it is merged
+            importShare(update.newReference.path);
         }
     }
     for (auto it = imported.cbegin(); it != imported.cend(); ++it) {
@@ -147,7 +224,7 @@ void ShareObserver::reinitialize()
         }
     }
 
-    notifyAbout(success, warning, error);
+    notifyAbout(QStringList(), warning, error);
 }
 
 void ShareObserver::notifyAbout(const QStringList& success, const QStringList& warning, const QStringList& error)
@@ -170,18 +247,80 @@ void ShareObserver::notifyAbout(const QStringList& success, const QStringList& w
     }
 }
 
-void ShareObserver::handleDatabaseChanged()
+void ShareObserver::handleActiveChanged()
 {
     if (!m_db) {
         Q_ASSERT(m_db);
         return;
     }
     const auto active = KeeShare::active();
-    if (!active.out && !active.in) {
+    m_active = active.in || active.out;
+    if (!m_active) {
         deinitialize();
     } else {
+        rescan();
+    }
+}
+
+void ShareObserver::handleDatabaseChanged()
+{
+    if (!m_db) {
+        Q_ASSERT(m_db);
+        return;
+    }
+    if (!m_active || m_reinitializing || m_db->isUpdating()) {
+        // shares are reinitialized once the bulk update or the running import finished
+        return;
+    }
+
+    m_reinitializing = true;
+    // imports may add groups with references of their own
+    while (!m_pending.isEmpty()) {
         reinitialize();
     }
+    m_reinitializing = false;
+}
+
+void ShareObserver::handleDatabaseModified()
+{
+    if (m_active && m_db && m_db->rootGroup() != m_rootGroup) {
+        // the root group was replaced without any group signals
+        deinitialize();
+        rescan();
+    }
+}
+
+void ShareObserver::handleGroupAboutToAdd(Group* group)
+{
+    if (m_active) {
+        // processed once the group is part of the tree
+        observe(group);
+    }
+}
+
+void ShareObserver::handleGroupAboutToRemove(Group* group)
+{
+    if (m_active) {
+        forget(group);
+    }
+}
+
+void ShareObserver::handleGroupCustomDataChanged()
+{
+    auto* customData = qobject_cast<CustomData*>(sender());
+    auto* group = customData ? qobject_cast<Group*>(customData->parent()) : nullptr;
+    if (!m_active || !group) {
+        return;
+    }
+
+    const auto cached = m_references.constFind(group);
+    const QString encoded = KeeShare::encodedReferenceOf(group);
+    if (cached == m_references.constEnd() ? encoded.isEmpty() : cached->encoded == encoded) {
+        return;
+    }
+
+    m_pending << group;
+    handleDatabaseChanged();
 }
 
 void ShareObserver::handleFileCreated(const QString& path)
@@ -198,8 +337,13 @@ void ShareObserver::handleFileDeleted(const QString& path)
 
 void ShareObserver::handleFileUpdated(const QString& path)
 {
-    const Result result = this->importShare(path);
+    importShare(path);
+}
+
+void ShareObserver::notifyAboutImport(const Result& result)
+{
     if (!result.isValid()) {
+        // tolerable result - blocked import, missing source or nothing changed
         return;
     }
     QStringList success;
@@ -217,31 +361,76 @@ void ShareObserver::handleFileUpdated(const QString& path)
     notifyAbout(success, warning, error);
 }
 
-ShareObserver::Result ShareObserver::importShare(const QString& path)
+/**
+ * Read and decrypt the container at path on the global thread pool, it is merged
+ * by handleImportFinished(). If the container is still being read, it is read
+ * once more afterwards and only the latest version is merged.
+ */
+void ShareObserver::importShare(const QString& path)
 {
     if (!KeeShare::active().in) {
-        return {};
+        return;
     }
     const auto changePath = resolvePath(path, m_db);
     auto shareGroup = m_shareToGroup.value(changePath);
     if (!shareGroup) {
         qWarning("Group for %s does not exist", qPrintable(path));
-        return {};
+        return;
     }
-    const auto reference = KeeShare::referenceOf(shareGroup);
+    const auto reference = referenceOf(shareGroup);
     if (reference.type == KeeShareSettings::Inactive) {
         // changes of inactive references are ignored
-        return {};
+        return;
     }
     if (reference.type == KeeShareSettings::ExportTo) {
         // changes of export only references are ignored
-        return {};
+        return;
     }
 
     Q_ASSERT(shareGroup->database() == m_db);
     Q_ASSERT(shareGroup == m_db->rootGroup()->findGroupByUuid(shareGroup->uuid()));
     const auto resolvedPath = resolvePath(reference.path, m_db);
-    return ShareImport::containerInto(resolvedPath, reference, shareGroup);
+    auto running = m_imports.find(resolvedPath);
+    if (running != m_imports.end()) {
+        running->outdated = true;
+        return;
+    }
+
+    auto* watcher = new QFutureWatcher<Container>(this);
+    connect(watcher, SIGNAL(finished()), SLOT(handleImportFinished()));
+    m_imports.insert(resolvedPath, {watcher, false});
+    // the trust settings are read here, the worker thread must not access the config
+    watcher->setFuture(QtConcurrent::run(
+        &ShareImport::load, resolvedPath, reference, KeeShare::foreign(), m_importDigests.value(resolvedPath)));
+}
+
+void ShareObserver::handleImportFinished()
+{
+    auto* watcher = static_cast<QFutureWatcher<Container>*>(sender());
+    const Container container = watcher->result();
+    const Import import = m_imports.take(container.resolvedPath);
+    watcher->deleteLater();
+
+    if (import.outdated) {
+        // the container changed while it was read
+        importShare(container.resolvedPath);
+        return;
+    }
+
+    Group* shareGroup = m_shareToGroup.value(container.resolvedPath);
+    if (!KeeShare::active().in || !shareGroup || !(referenceOf(shareGroup) == container.reference)) {
+        // the share was changed or removed in the meantime
+        return;
+    }
+
+    const Result result = ShareImport::apply(container, shareGroup);
+    if (!container.digest.isEmpty() && !result.isError() && !result.isWarning()) {
+        m_importDigests.insert(container.resolvedPath, container.digest);
+    }
+    notifyAboutImport(result);
+
+    // merged groups may carry references of their own
+    handleDatabaseChanged();
 }
 
 QSharedPointer<Database> ShareObserver::database()
@@ -258,10 +447,15 @@ QList<ShareObserver::Result> ShareObserver::exportShares()
         const Group* group;
     };
 
+    // all groups with a reference are known, no need to look at the other groups
+    handleDatabaseChanged();
     QMap<QString, QList<Reference>> references;
-    const auto groups = m_db->rootGroup()->groupsRecursive(true);
-    for (const auto* group : groups) {
-        const auto reference = KeeShare::referenceOf(group);
+    for (auto it = m_groupToReference.cbegin(); it != m_groupToReference.cend(); ++it) {
+        const Group* group = it.key();
+        if (!group) {
+            continue;
+        }
+        const auto reference = referenceOf(group);
         if (!reference.isExporting()) {
             continue;
         }
@@ -284,13 +478,15 @@ QList<ShareObserver::Result> ShareObserver::exportShares()
         return results;
     }
 
+    QList<ShareExport::Target> targets;
     for (auto it = references.cbegin(); it != references.cend(); ++it) {
         const auto& reference = it.value().first();
         const QString resolvedPath = resolvePath(reference.config.path, m_db);
         m_fileWatcher->ignoreFileChanges(resolvedPath);
-        results << ShareExport::intoContainer(resolvedPath, reference.config, reference.group);
-        m_fileWatcher->observeFileChanges(true);
+        targets << ShareExport::Target{resolvedPath, reference.config, reference.group};
     }
+    results << ShareExport::intoContainers(targets, m_exportStates);
+    m_fileWatcher->observeFileChanges(true);
     return results;
 }
 
@@ -18,8 +18,12 @@
 #ifndef KEEPASSXC_SHAREOBSERVER_H
 #define KEEPASSXC_SHAREOBSERVER_H
 
+#include <QDateTime>
+#include <QHash>
 #include <QMap>
 #include <QObject>
+#include <QPointer>
+#include <QSharedPointer>
 #include <QStringList>
 
 #include "gui/MessageWidget.h"
@@ -28,7 +32,19 @@
 class BulkFileWatcher;
 class Group;
 class Database;
+class Kdf;
+template <typename T> class QFutureWatcher;
 
+/**
+ * Watches the shares referenced by the groups of a database.
+ *
+ * Only groups whose KeeShare reference actually changed are looked at again,
+ * references are decoded once and cached per group. Edits that do not touch
+ * a reference cost a single string comparison.
+ *
+ * Containers are read and decrypted in the background, only the merge runs
+ * on the thread of the database.
+ */
 class ShareObserver : public QObject
 {
     Q_OBJECT
@@ -61,23 +77,61 @@ public:
         bool isInfo() const;
     };
 
+    /**
+     * What is remembered about a container between exports: the digest of its content
+     * and the key derived from the share password.
+     */
+    struct ExportState
+    {
+        QByteArray digest;
+        QDateTime lastModified;
+        QString password;
+        QSharedPointer<Kdf> kdf;
+        QByteArray transformedMasterKey;
+    };
+
+    /**
+     * A container read and decrypted by ShareImport::load(), waiting to be merged.
+     * The database is missing if the container could not be read or did not change.
+     */
+    struct Container
+    {
+        QString resolvedPath;
+        KeeShareSettings::Reference reference;
+        KeeShareSettings::Sign sign;
+        QByteArray digest;
+        QSharedPointer<Database> database;
+        Result result;
+    };
+
 signals:
     void sharingMessage(QString, MessageWidget::MessageType);
 
 private slots:
+    void handleActiveChanged();
     void handleDatabaseChanged();
+    void handleDatabaseModified();
     void handleDatabaseSaved();
+    void handleGroupAboutToAdd(Group* group);
+    void handleGroupAboutToRemove(Group* group);
+    void handleGroupCustomDataChanged();
     void handleFileCreated(const QString& path);
     void handleFileUpdated(const QString& path);
     void handleFileDeleted(const QString& path);
+    void handleImportFinished();
 
 private:
-    Result importShare(const QString& path);
+    void importShare(const QString& path);
     QList<Result> exportShares();
 
     void deinitialize();
     void reinitialize();
+    void rescan();
+    void observe(Group* group);
+    void forget(const Group* group);
+    KeeShareSettings::Reference referenceOf(const Group* group);
     void notifyAbout(const QStringList& success, const QStringList& warning, const QStringList& error);
+    void notifyAboutImport(const Result& result);
 
 private:
     QSharedPointer<Database> m_db;
@@ -85,6 +139,26 @@ private:
     QMap<QPointer<Group>, KeeShareSettings::Reference> m_groupToReference;
     QMap<QString, QPointer<Group>> m_shareToGroup;
 
+    struct CachedReference
+    {
+        QString encoded;
+        KeeShareSettings::Reference reference;
+    };
+    QHash<const Group*, CachedReference> m_references;
+    QList<QPointer<Group>> m_pending;
+    QPointer<Group> m_rootGroup;
+    QHash<QString, ExportState> m_exportStates;
+
+    struct Import
+    {
+        QFutureWatcher<Container>* watcher;
+        bool outdated;
+    };
+    QHash<QString, Import> m_imports;
+    QHash<QString, QByteArray> m_importDigests;
+    bool m_active;
+    bool m_reinitializing;
+
     BulkFileWatcher* m_fileWatcher;
 };
 
@@ -22,6 +22,7 @@
 #include <format/KeePass2.h>
 
 #include "core/Global.h"
+#include "core/Tracing.h"
 #include "crypto/CryptoHash.h"
 #include "crypto/kdf/AesKdf.h"
 
@@ -112,6 +113,7 @@ QByteArray CompositeKey::rawKey(const QByteArray* transformSeed, bool* ok) const
  */
 bool CompositeKey::transform(const Kdf& kdf, QByteArray& result) const
 {
+    TRACE_SPAN("CompositeKey::transform", "kdf");
     if (kdf.uuid() == KeePass2::KDF_AES_KDBX3) {
         // legacy KDBX3 AES-KDF, challenge response is added later to the hash
         return kdf.transform(rawKey(), result);
@@ -125,6 +127,7 @@ bool CompositeKey::transform(const Kdf& kdf, QByteArray& result) const
 
 bool CompositeKey::challenge(const QByteArray& seed, QByteArray& result) const
 {
+    TRACE_SPAN("CompositeKey::challenge", "kdf");
     // if no challenge response was requested, return nothing to
     // maintain backwards compatibility with regular databases.
     if (m_challengeResponseKeys.length() == 0) {
@@ -25,6 +25,7 @@
 #include "core/Bootstrap.h"
 #include "core/Config.h"
 #include "core/Tools.h"
+#include "core/Tracing.h"
 #include "crypto/Crypto.h"
 #include "gui/Application.h"
 #include "gui/MainWindow.h"
@@ -88,6 +89,10 @@ int main(int argc, char** argv)
     parser.addOption(pwstdinOption);
     parser.addOption(parentWindowOption);
     parser.addOption(debugInfoOption);
+#ifdef WITH_XC_TRACING
+    QCommandLineOption traceOption("trace", QObject::tr("write a performance trace to the given file"), "file");
+    parser.addOption(traceOption);
+#endif
 
     parser.process(app);
 
@@ -129,6 +134,12 @@ int main(int argc, char** argv)
         Config::createConfigFromFile(parser.value(configOption));
     }
 
+#ifdef WITH_XC_TRACING
+    if (parser.isSet(traceOption)) {
+        Tracing::start(parser.value(traceOption));
+    }
+#endif
+
     MainWindow mainWindow;
     QObject::connect(&app, SIGNAL(anotherInstanceStarted()), &mainWindow, SLOT(bringToFront()));
     QObject::connect(&app, SIGNAL(applicationActivated()), &mainWindow, SLOT(bringToFront()));
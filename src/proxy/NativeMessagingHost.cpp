@@ -22,8 +22,15 @@
 #include <winsock2.h>
 #endif
 
+namespace
+{
+    // Answer of KeePassXC versions without framing support to the unparsable probe
+    const QByteArray LegacyProbeReply("{}");
+} // namespace
+
 NativeMessagingHost::NativeMessagingHost()
     : NativeMessagingBase(true)
+    , m_framed(false)
 {
     m_localSocket = new QLocalSocket();
     m_localSocket->connectToServer(getLocalServerPath());
@@ -34,9 +41,11 @@ NativeMessagingHost::NativeMessagingHost()
         int max = NATIVE_MSG_MAX_LENGTH;
         setsockopt(socketDesc, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<char*>(&max), sizeof(max));
     }
+    negotiateFraming();
 #ifdef Q_OS_WIN
     m_running.store(1);
-    m_future = QtConcurrent::run(this, &NativeMessagingHost::readNativeMessages);
+    m_future =
+        QtConcurrent::run(this, static_cast<void (NativeMessagingHost::*)()>(&NativeMessagingHost::readNativeMessages));
 #endif
     connect(m_localSocket, SIGNAL(readyRead()), this, SLOT(newLocalMessage()));
     connect(m_localSocket, SIGNAL(disconnected()), this, SLOT(deleteSocket()));
@@ -52,56 +61,68 @@ NativeMessagingHost::~NativeMessagingHost()
 #endif
 }
 
-void NativeMessagingHost::readNativeMessages()
+/**
+ * Ask KeePassXC whether it understands length prefixed messages.
+ *
+ * An empty frame is sent before any request. KeePassXC acknowledges it with
+ * an empty frame, older versions answer the unparsable request with "{}".
+ * Those versions get every request as plain JSON and their replies are
+ * framed here, just like older versions of the proxy did.
+ *
+ * Both answer every request, so there is no timeout: requests sent before
+ * the answer would be misinterpreted by one of them.
+ */
+void NativeMessagingHost::negotiateFraming()
 {
-#ifdef Q_OS_WIN
-    quint32 length = 0;
-    while (m_running.load() == 1 && !std::cin.eof()) {
-        length = 0;
-        std::cin.read(reinterpret_cast<char*>(&length), 4);
-        if (!readStdIn(length)) {
-            QCoreApplication::quit();
+    if (!m_localSocket->waitForConnected()) {
+        return;
+    }
+
+    const QByteArray probe = NativeMessageBuffer::frame(QByteArray());
+    m_localSocket->write(probe);
+    m_localSocket->flush();
+
+    QByteArray reply;
+    while (reply.size() < probe.size() && m_localSocket->waitForReadyRead(-1)) {
+        reply.append(m_localSocket->readAll());
+        if (!reply.startsWith('\0')) {
+            break;
         }
-        QThread::msleep(1);
     }
-#endif
-}
 
-void NativeMessagingHost::readLength()
-{
-    quint32 length = 0;
-    std::cin.read(reinterpret_cast<char*>(&length), 4);
-    if (!std::cin.eof() && length > 0) {
-        readStdIn(length);
-    } else {
-        QCoreApplication::quit();
+    m_framed = reply.startsWith(probe);
+    if (m_framed) {
+        reply.remove(0, probe.size());
+    } else if (reply.startsWith(LegacyProbeReply)) {
+        reply.remove(0, LegacyProbeReply.size());
     }
+    relayReply(reply);
 }
 
-bool NativeMessagingHost::readStdIn(const quint32 length)
+void NativeMessagingHost::processStdIn()
 {
-    if (length <= 0) {
-        return false;
+    if (!m_localSocket || m_localSocket->state() != QLocalSocket::ConnectedState) {
+        m_stdinBuffer.clear();
+        return;
     }
 
-    QByteArray arr;
-    arr.reserve(length);
-
-    for (quint32 i = 0; i < length; ++i) {
-        int c = std::getchar();
-        if (c == EOF) {
-            // message ended prematurely, ignore it and return
-            return false;
-        }
-        arr.append(static_cast<char>(c));
+    if (m_framed) {
+        // KeePassXC expects the same framing as the browser, relay the data as is
+        m_localSocket->write(m_stdinBuffer.takeAll());
+        m_localSocket->flush();
+        return;
     }
 
-    if (arr.length() > 0 && m_localSocket && m_localSocket->state() == QLocalSocket::ConnectedState) {
-        m_localSocket->write(arr.constData(), arr.length());
+    QByteArray message;
+    while (m_stdinBuffer.takeMessage(message)) {
+        m_localSocket->write(message);
         m_localSocket->flush();
     }
+}
 
-    return true;
+void NativeMessagingHost::stdInClosed()
+{
+    QCoreApplication::quit();
 }
 
 void NativeMessagingHost::newLocalMessage()
@@ -110,10 +131,20 @@ void NativeMessagingHost::newLocalMessage()
         return;
     }
 
-    QByteArray arr = m_localSocket->readAll();
-    if (!arr.isEmpty()) {
-        sendReply(arr);
+    relayReply(m_localSocket->readAll());
+}
+
+/**
+ * Relay a reply of KeePassXC to the browser, framing it if necessary.
+ */
+void NativeMessagingHost::relayReply(const QByteArray& reply)
+{
+    if (reply.isEmpty()) {
+        return;
     }
+
+    // Older KeePassXC versions write each reply as plain JSON with a single write
+    writeStdOut(m_framed ? reply : NativeMessageBuffer::frame(reply));
 }
 
 void NativeMessagingHost::deleteSocket()
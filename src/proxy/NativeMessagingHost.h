@@ -33,12 +33,15 @@ public slots:
     void socketStateChanged(QLocalSocket::LocalSocketState socketState);
 
 private:
-    void readNativeMessages() override;
-    void readLength() override;
-    bool readStdIn(const quint32 length) override;
+    void negotiateFraming();
+    void relayReply(const QByteArray& reply);
+    void processStdIn() override;
+    void stdInClosed() override;
 
 private:
     QLocalSocket* m_localSocket;
+    // KeePassXC understands length prefixed requests
+    bool m_framed;
 
     Q_DISABLE_COPY(NativeMessagingHost)
 };
@@ -19,6 +19,7 @@
 #include "SSHAgent.h"
 
 #include "core/Config.h"
+#include "core/Tracing.h"
 #include "crypto/ssh/BinaryStream.h"
 #include "crypto/ssh/OpenSSHKey.h"
 #include "sshagent/KeeAgentSettings.h"
@@ -283,6 +284,7 @@ void SSHAgent::setAutoRemoveOnLock(const OpenSSHKey& key, bool autoRemove)
 
 void SSHAgent::databaseModeChanged()
 {
+    TRACE_SPAN("SSHAgent::databaseModeChanged", "plugins,sshagent");
     auto* widget = qobject_cast<DatabaseWidget*>(sender());
     if (!widget) {
         return;
@@ -20,6 +20,7 @@
 #include <utility>
 
 #include "core/Endian.h"
+#include "core/Tracing.h"
 #include "crypto/CryptoHash.h"
 
 const QSysInfo::Endian HmacBlockStream::ByteOrder = QSysInfo::LittleEndian;
@@ -125,6 +126,7 @@ qint64 HmacBlockStream::readData(char* data, qint64 maxSize)
 
 bool HmacBlockStream::readHashedBlock()
 {
+    TRACE_SPAN("HmacBlockStream::readHashedBlock", "hmac,io");
     if (m_eof) {
         return false;
     }
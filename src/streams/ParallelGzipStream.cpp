@@ -0,0 +1,241 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ParallelGzipStream.h"
+
+#include <QThread>
+#include <QtConcurrent>
+#include <cstring>
+#include <functional>
+#include <zlib.h>
+
+#include "core/Endian.h"
+
+namespace
+{
+    // deflate looks back at most 32 KiB
+    const int DictionarySize = 32 * 1024;
+
+    ParallelGzipStream::Chunk deflateChunk(const ParallelGzipStream::Chunk& job)
+    {
+        ParallelGzipStream::Chunk chunk;
+
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        if (deflateInit2(&stream, job.level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return chunk;
+        }
+        if (!job.dictionary.isEmpty()) {
+            deflateSetDictionary(&stream,
+                                 reinterpret_cast<const Bytef*>(job.dictionary.constData()),
+                                 static_cast<uInt>(job.dictionary.size()));
+        }
+
+        // deflateBound() does not include the empty block of the sync flush
+        chunk.output.resize(static_cast<int>(deflateBound(&stream, static_cast<uLong>(job.input.size()))) + 16);
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(job.input.constData()));
+        stream.avail_in = static_cast<uInt>(job.input.size());
+        stream.next_out = reinterpret_cast<Bytef*>(chunk.output.data());
+        stream.avail_out = static_cast<uInt>(chunk.output.size());
+
+        // A sync flush ends the chunk on a byte boundary without marking the last block,
+        // so the next chunk can be appended as is
+        const int status = deflate(&stream, job.last ? Z_FINISH : Z_SYNC_FLUSH);
+        chunk.ok = job.last ? status == Z_STREAM_END : (status == Z_OK && stream.avail_out > 0);
+        chunk.output.resize(static_cast<int>(stream.total_out));
+
+        deflateEnd(&stream);
+        return chunk;
+    }
+} // namespace
+
+ParallelGzipStream::ParallelGzipStream(QIODevice* baseDevice, int compressionLevel, int chunkSize)
+    : LayeredStream(baseDevice)
+    , m_compressionLevel(compressionLevel)
+    , m_chunkSize(qMax(chunkSize, DictionarySize))
+    , m_batchSize(qMax(1, QThread::idealThreadCount()))
+{
+    init();
+}
+
+ParallelGzipStream::~ParallelGzipStream()
+{
+    close();
+}
+
+void ParallelGzipStream::init()
+{
+    m_input.clear();
+    m_dictionary.clear();
+    m_crc = static_cast<quint32>(crc32(0L, nullptr, 0));
+    m_size = 0;
+    m_started = false;
+    m_error = false;
+}
+
+bool ParallelGzipStream::open(QIODevice::OpenMode mode)
+{
+    if (mode & QIODevice::ReadOnly) {
+        qWarning("ParallelGzipStream::open: Only writing is supported.");
+        return false;
+    }
+
+    init();
+    return LayeredStream::open(mode);
+}
+
+bool ParallelGzipStream::reset()
+{
+    // Finish the gzip member only if we have written anything
+    bool ok = true;
+    if (isWritable() && m_started) {
+        ok = finish();
+    }
+
+    init();
+    return ok;
+}
+
+void ParallelGzipStream::close()
+{
+    if (isWritable() && m_started) {
+        finish();
+    }
+    init();
+
+    LayeredStream::close();
+}
+
+qint64 ParallelGzipStream::readData(char* data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+qint64 ParallelGzipStream::writeData(const char* data, qint64 maxSize)
+{
+    if (m_error) {
+        return -1;
+    }
+
+    if (!m_started) {
+        // magic, deflate, no flags, no modification time, no extra flags, unknown OS
+        const char header[] = {'\x1f', '\x8b', '\x08', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\xff'};
+        if (!writeToBase(QByteArray::fromRawData(header, sizeof(header)))) {
+            return -1;
+        }
+        m_started = true;
+    }
+
+    m_input.append(data, static_cast<int>(maxSize));
+    if (m_input.size() >= m_chunkSize * m_batchSize) {
+        // Wait for the previous batch, at most two batches are held in memory
+        if (!writeBatch()) {
+            return -1;
+        }
+        startBatch(false);
+    }
+
+    return maxSize;
+}
+
+/**
+ * Split the buffered input into chunks and compress them in the background.
+ *
+ * @param last compress all input and end the deflate stream,
+ *             otherwise a partial chunk is kept for the next batch
+ */
+void ParallelGzipStream::startBatch(bool last)
+{
+    QList<Chunk> chunks;
+    int offset = 0;
+    while (m_input.size() - offset >= m_chunkSize || (last && (offset < m_input.size() || chunks.isEmpty()))) {
+        Chunk chunk;
+        chunk.input = m_input.mid(offset, m_chunkSize);
+        chunk.dictionary = m_dictionary;
+        chunk.level = m_compressionLevel;
+
+        const auto* bytes = reinterpret_cast<const Bytef*>(chunk.input.constData());
+        m_crc = static_cast<quint32>(crc32(m_crc, bytes, static_cast<uInt>(chunk.input.size())));
+        m_size += static_cast<quint32>(chunk.input.size());
+        m_dictionary = chunk.input.right(DictionarySize);
+
+        offset += chunk.input.size();
+        chunks.append(chunk);
+    }
+
+    if (last) {
+        chunks.last().last = true;
+    }
+    m_input.remove(0, offset);
+
+    m_batch = QtConcurrent::mapped(chunks, std::function<Chunk(const Chunk&)>(&deflateChunk));
+}
+
+/**
+ * Wait for the running batch and write its output in order.
+ */
+bool ParallelGzipStream::writeBatch()
+{
+    const QList<Chunk> chunks = m_batch.results();
+    m_batch = QFuture<Chunk>();
+
+    for (const Chunk& chunk : chunks) {
+        if (!chunk.ok) {
+            m_error = true;
+            setErrorString("Internal zlib error when compressing.");
+            return false;
+        }
+        if (!writeToBase(chunk.output)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ParallelGzipStream::finish()
+{
+    if (m_error) {
+        m_batch.waitForFinished();
+        return false;
+    }
+
+    if (!writeBatch()) {
+        return false;
+    }
+    startBatch(true);
+    if (!writeBatch()) {
+        return false;
+    }
+
+    // CRC-32 and size of the uncompressed data modulo 2^32
+    QByteArray trailer = Endian::sizedIntToBytes<quint32>(m_crc, QSysInfo::LittleEndian);
+    trailer.append(Endian::sizedIntToBytes<quint32>(m_size, QSysInfo::LittleEndian));
+    return writeToBase(trailer);
+}
+
+bool ParallelGzipStream::writeToBase(const QByteArray& data)
+{
+    if (m_baseDevice->write(data) != data.size()) {
+        m_error = true;
+        setErrorString(m_baseDevice->errorString());
+        return false;
+    }
+    return true;
+}
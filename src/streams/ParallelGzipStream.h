@@ -0,0 +1,81 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSX_PARALLELGZIPSTREAM_H
+#define KEEPASSX_PARALLELGZIPSTREAM_H
+
+#include <QFuture>
+
+#include "streams/LayeredStream.h"
+
+/**
+ * Write-only gzip stream that deflates independent chunks on all cores.
+ *
+ * Like pigz, every chunk is a raw deflate stream that ends with a sync flush and is
+ * primed with the last 32 KiB of the preceding data. The concatenated chunks form a
+ * single standard gzip member that any inflater can read.
+ *
+ * While one batch of chunks is compressed in the background, the next one is filled.
+ * Call reset() or close() to write the final block and the gzip trailer.
+ */
+class ParallelGzipStream : public LayeredStream
+{
+    Q_OBJECT
+
+public:
+    explicit ParallelGzipStream(QIODevice* baseDevice, int compressionLevel = 6, int chunkSize = 256 * 1024);
+    ~ParallelGzipStream() override;
+
+    bool open(QIODevice::OpenMode mode) override;
+    bool reset() override;
+    void close() override;
+
+    struct Chunk
+    {
+        QByteArray input;
+        QByteArray dictionary;
+        QByteArray output;
+        int level = 6;
+        bool last = false;
+        bool ok = false;
+    };
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    void init();
+    bool finish();
+    void startBatch(bool last);
+    bool writeBatch();
+    bool writeToBase(const QByteArray& data);
+
+    const int m_compressionLevel;
+    const int m_chunkSize;
+    const int m_batchSize;
+
+    QByteArray m_input;
+    QByteArray m_dictionary;
+    QFuture<Chunk> m_batch;
+    quint32 m_crc;
+    quint32 m_size;
+    bool m_started;
+    bool m_error;
+};
+
+#endif // KEEPASSX_PARALLELGZIPSTREAM_H
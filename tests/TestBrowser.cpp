@@ -18,6 +18,8 @@
 #include "TestBrowser.h"
 #include "TestGlobal.h"
 #include "browser/BrowserSettings.h"
+#include "browser/NativeMessageBuffer.h"
+#include "core/Metadata.h"
 #include "crypto/Crypto.h"
 #include "sodium/crypto_box.h"
 #include <QString>
@@ -458,3 +460,93 @@ void TestBrowser::testGetDatabaseGroups()
     auto lastChild = lastChildren.at(0);
     QCOMPARE(lastChild.toObject()["name"].toString(), QString("group2_1_1"));
 }
+
+void TestBrowser::testSearchSnapshot()
+{
+    auto db = QSharedPointer<Database>::create();
+    auto* root = db->rootGroup();
+    db->metadata()->customData()->set(BrowserService::ASSOCIATE_KEY_PREFIX + "client", PUBLICKEY);
+
+    auto* entry = new Entry();
+    entry->setGroup(root);
+    entry->setUrl("https://github.com/login");
+
+    auto* recycled = new Entry();
+    recycled->setGroup(root);
+    recycled->setUrl("https://github.com/recycled");
+    db->recycleEntry(recycled);
+
+    BrowserService::Snapshot snapshot;
+    snapshot.searchDatabases << QSharedPointer<const BrowserDatabaseView>(new BrowserDatabaseView(db));
+
+    QCOMPARE(snapshot.searchDatabases.first()->key("client"), PUBLICKEY);
+    QCOMPARE(snapshot.searchDatabases.first()->rootGroupUuid(), root->uuidToHex());
+
+    // Only databases connected with one of the keys are searched
+    StringPairList keyList;
+    keyList << qMakePair(QString("client"), SECRETKEY);
+    QVERIFY(m_browserService->searchEntries(snapshot, "https://github.com", keyList).isEmpty());
+
+    keyList << qMakePair(QString("client"), PUBLICKEY);
+    auto result = m_browserService->searchEntries(snapshot, "https://github.com", keyList);
+    QCOMPARE(result.size(), 1);
+    QCOMPARE(result.first().data(), entry);
+
+    // Changes to the database are not visible in an existing snapshot
+    auto* added = new Entry();
+    added->setGroup(root);
+    added->setUrl("https://github.com");
+    result = m_browserService->searchEntries(snapshot, "https://github.com", keyList);
+    QCOMPARE(result.size(), 1);
+
+    // Deleted entries are reported as null pointers
+    delete entry;
+    result = m_browserService->searchEntries(snapshot, "https://github.com", keyList);
+    QCOMPARE(result.size(), 1);
+    QVERIFY(result.first().isNull());
+}
+
+void TestBrowser::testMessageFraming()
+{
+    const QByteArray first = R"({"action":"get-logins"})";
+    const QByteArray second = R"({"action":"get-databasehash"})";
+
+    QByteArray frame = NativeMessageBuffer::frame(first);
+    QCOMPARE(frame.size(), first.size() + 4);
+    QCOMPARE(frame.at(0), static_cast<char>(first.size()));
+    QCOMPARE(frame.mid(4), first);
+
+    // Two messages in one read, the second one split over two reads
+    const QByteArray stream = frame + NativeMessageBuffer::frame(second);
+    NativeMessageBuffer buffer;
+    buffer.append(stream.left(stream.size() - 5));
+    QVERIFY(!buffer.isUnframed());
+
+    QByteArray message;
+    QVERIFY(buffer.takeMessage(message));
+    QCOMPARE(message, first);
+    QVERIFY(!buffer.takeMessage(message));
+    QVERIFY(!buffer.isEmpty());
+
+    buffer.append(stream.right(5));
+    QVERIFY(buffer.takeMessage(message));
+    QCOMPARE(message, second);
+    QVERIFY(buffer.isEmpty());
+
+    // Relaying keeps the framing intact
+    buffer.append(stream);
+    QCOMPARE(buffer.takeAll(), stream);
+    QVERIFY(buffer.isEmpty());
+
+    // Plain JSON of older proxies
+    buffer.append(first);
+    QVERIFY(buffer.isUnframed());
+    buffer.clear();
+
+    // Oversized messages cannot be handled
+    QByteArray oversized(4, '\0');
+    oversized[2] = 0x20;
+    buffer.append(oversized);
+    QVERIFY(!buffer.takeMessage(message));
+    QVERIFY(buffer.hasError());
+}
@@ -47,6 +47,8 @@ private slots:
     void testSubdomainsAndPaths();
     void testSortEntries();
     void testGetDatabaseGroups();
+    void testSearchSnapshot();
+    void testMessageFraming();
 
 private:
     QScopedPointer<BrowserAction> m_browserAction;
@@ -0,0 +1,158 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestBulkFileWatcher.h"
+#include "TestGlobal.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include "core/FileWatcher.h"
+
+QTEST_GUILESS_MAIN(TestBulkFileWatcher)
+
+namespace
+{
+    bool writeFile(const QString& path, const QByteArray& content)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        return file.write(content) == content.size();
+    }
+} // namespace
+
+void TestBulkFileWatcher::testCreateChangeRemove()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("share.kdbx");
+
+    BulkFileWatcher watcher;
+    QSignalSpy spyCreated(&watcher, SIGNAL(fileCreated(QString)));
+    QSignalSpy spyChanged(&watcher, SIGNAL(fileChanged(QString)));
+    QSignalSpy spyRemoved(&watcher, SIGNAL(fileRemoved(QString)));
+    watcher.addPath(path);
+
+    QVERIFY(writeFile(path, "created"));
+    QTRY_COMPARE(spyCreated.count(), 1);
+    QCOMPARE(spyCreated.first().first().toString(), path);
+
+    // make sure the modification time differs for the fallback implementation
+    QTest::qWait(1100);
+    QVERIFY(writeFile(path, "changed"));
+    QTRY_COMPARE(spyChanged.count(), 1);
+    QCOMPARE(spyChanged.first().first().toString(), path);
+
+    QVERIFY(QFile::remove(path));
+    QTRY_COMPARE(spyRemoved.count(), 1);
+    QCOMPARE(spyRemoved.first().first().toString(), path);
+    QCOMPARE(spyCreated.count(), 1);
+    QCOMPARE(spyChanged.count(), 1);
+}
+
+void TestBulkFileWatcher::testIgnoreFileChanges()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("share.kdbx");
+    QVERIFY(writeFile(path, "initial"));
+
+    BulkFileWatcher watcher;
+    QSignalSpy spyChanged(&watcher, SIGNAL(fileChanged(QString)));
+    watcher.addPath(path);
+
+    QTest::qWait(1100);
+    watcher.ignoreFileChanges(path);
+    QVERIFY(writeFile(path, "own write"));
+    watcher.observeFileChanges(true);
+    QTest::qWait(500);
+    QCOMPARE(spyChanged.count(), 0);
+}
+
+void TestBulkFileWatcher::testUnwatchedFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("share.kdbx");
+    const QString otherPath = dir.filePath("other.kdbx");
+
+    BulkFileWatcher watcher;
+    QSignalSpy spyCreated(&watcher, SIGNAL(fileCreated(QString)));
+    watcher.addPath(path);
+
+    QVERIFY(writeFile(otherPath, "other"));
+    QVERIFY(writeFile(path, "created"));
+    QTRY_COMPARE(spyCreated.count(), 1);
+    QCOMPARE(spyCreated.first().first().toString(), path);
+
+    watcher.removePath(path);
+    QVERIFY(QFile::remove(path));
+    QVERIFY(writeFile(path, "created again"));
+    QTest::qWait(500);
+    QCOMPARE(spyCreated.count(), 1);
+}
+
+void TestBulkFileWatcher::testCoalesceChanges()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("share.kdbx");
+    QVERIFY(writeFile(path, "initial"));
+
+    BulkFileWatcher watcher;
+    QSignalSpy spyChanged(&watcher, SIGNAL(fileChanged(QString)));
+    watcher.addPath(path);
+
+    QTest::qWait(1100);
+    for (int i = 0; i < 10; ++i) {
+        QVERIFY(writeFile(path, QByteArray::number(i)));
+    }
+    QTRY_VERIFY(spyChanged.count() > 0);
+    QTest::qWait(500);
+    QCOMPARE(spyChanged.count(), 1);
+}
+
+void TestBulkFileWatcher::testDirectoryReplaced()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("Directory watches are only kept across replacements with inotify.");
+#endif
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString directoryPath = dir.filePath("shares");
+    QVERIFY(QDir().mkpath(directoryPath));
+    const QString path = QDir(directoryPath).filePath("share.kdbx");
+    QVERIFY(writeFile(path, "initial"));
+
+    BulkFileWatcher watcher;
+    QSignalSpy spyCreated(&watcher, SIGNAL(fileCreated(QString)));
+    QSignalSpy spyRemoved(&watcher, SIGNAL(fileRemoved(QString)));
+    watcher.addPath(path);
+
+    // the directory is replaced before the watcher notices that its watch is gone
+    QVERIFY(QDir(directoryPath).removeRecursively());
+    QVERIFY(QDir().mkpath(directoryPath));
+    QTRY_COMPARE(spyRemoved.count(), 1);
+
+    QVERIFY(writeFile(path, "created"));
+    QTRY_COMPARE(spyCreated.count(), 1);
+    QCOMPARE(spyCreated.first().first().toString(), path);
+}
@@ -49,6 +49,7 @@
 #include "cli/Merge.h"
 #include "cli/Move.h"
 #include "cli/Open.h"
+#include "cli/Prune.h"
 #include "cli/Remove.h"
 #include "cli/RemoveGroup.h"
 #include "cli/Show.h"
@@ -206,11 +207,12 @@ void TestCli::testBatchCommands()
     QVERIFY(Commands::getCommand("mkdir"));
     QVERIFY(Commands::getCommand("mv"));
     QVERIFY(Commands::getCommand("open"));
+    QVERIFY(Commands::getCommand("prune"));
     QVERIFY(Commands::getCommand("rm"));
     QVERIFY(Commands::getCommand("rmdir"));
     QVERIFY(Commands::getCommand("show"));
     QVERIFY(!Commands::getCommand("doesnotexist"));
-    QCOMPARE(Commands::getCommands().size(), 21);
+    QCOMPARE(Commands::getCommands().size(), 22);
 }
 
 void TestCli::testInteractiveCommands()
@@ -233,12 +235,13 @@ void TestCli::testInteractiveCommands()
     QVERIFY(Commands::getCommand("mkdir"));
     QVERIFY(Commands::getCommand("mv"));
     QVERIFY(Commands::getCommand("open"));
+    QVERIFY(Commands::getCommand("prune"));
     QVERIFY(Commands::getCommand("quit"));
     QVERIFY(Commands::getCommand("rm"));
     QVERIFY(Commands::getCommand("rmdir"));
     QVERIFY(Commands::getCommand("show"));
     QVERIFY(!Commands::getCommand("doesnotexist"));
-    QCOMPARE(Commands::getCommands().size(), 21);
+    QCOMPARE(Commands::getCommands().size(), 22);
 }
 
 void TestCli::testAdd()
@@ -1479,6 +1482,94 @@ void TestCli::testMove()
     QVERIFY(entry);
 }
 
+void TestCli::testPrune()
+{
+    Prune pruneCmd;
+    QVERIFY(!pruneCmd.name.isEmpty());
+    QVERIFY(pruneCmd.getDescriptionLine().contains(pruneCmd.name));
+
+    auto db = readTestDatabase();
+    QVERIFY(db);
+    const QList<Entry*> entries = db->rootGroup()->entriesRecursive(false);
+    for (Entry* entry : entries) {
+        entry->removeHistoryItems(entry->historyItems());
+    }
+
+    // The attachment is only kept by the second history item
+    db->metadata()->setHistoryMaxItems(-1);
+    auto* entry = db->rootGroup()->findEntryByPath("/Sample Entry");
+    QVERIFY(entry);
+    entry->beginUpdate();
+    entry->attachments()->set("history.txt", QByteArray(1000, 'h'));
+    entry->endUpdate();
+    entry->beginUpdate();
+    entry->attachments()->remove("history.txt");
+    entry->setTitle("Second Title");
+    entry->endUpdate();
+    entry->beginUpdate();
+    entry->setTitle("Sample Entry");
+    entry->endUpdate();
+    QCOMPARE(entry->historyItems().size(), 3);
+    db->metadata()->setHistoryMaxItems(1);
+
+    TemporaryFile dbFile;
+    dbFile.open();
+    Kdbx4Writer writer;
+    writer.writeDatabase(&dbFile, db.data());
+    dbFile.close();
+
+    auto readDatabase = [&]() {
+        Kdbx4Reader reader;
+        QFile readBack(dbFile.fileName());
+        readBack.open(QIODevice::ReadOnly);
+        auto prunedDb = QSharedPointer<Database>::create();
+        reader.readDatabase(&readBack, db->key(), prunedDb.data());
+        return prunedDb;
+    };
+
+    qint64 pos = m_stdoutFile->pos();
+    Utils::Test::setNextPassword("a");
+    pruneCmd.execute({"prune", "--dry-run", dbFile.fileName()});
+    m_stdoutFile->seek(pos);
+    m_stdoutFile->readLine(); // skip password prompt
+    QList<QByteArray> lines = m_stdoutFile->readAll().split('\n');
+    QCOMPARE(lines.at(0), QByteArray("Entries with removed history: 1"));
+    QCOMPARE(lines.at(1), QByteArray("Removed history items: 2"));
+    QCOMPARE(lines.at(2), QByteArray("Dropped attachments: 1"));
+    QVERIFY(lines.at(3).startsWith("Reclaimed space: "));
+    QCOMPARE(lines.at(4), QByteArray("Database was not modified by the dry run."));
+
+    auto prunedDb = readDatabase();
+    entry = prunedDb->rootGroup()->findEntryByPath("/Sample Entry");
+    QVERIFY(entry);
+    QCOMPARE(entry->historyItems().size(), 3);
+
+    pos = m_stdoutFile->pos();
+    Utils::Test::setNextPassword("a");
+    pruneCmd.execute({"prune", dbFile.fileName()});
+    m_stdoutFile->seek(pos);
+    m_stdoutFile->readLine(); // skip password prompt
+    lines = m_stdoutFile->readAll().split('\n');
+    QCOMPARE(lines.at(1), QByteArray("Removed history items: 2"));
+    QCOMPARE(lines.at(4), QString("Successfully pruned the history of %1.").arg(dbFile.fileName()).toUtf8());
+
+    prunedDb = readDatabase();
+    entry = prunedDb->rootGroup()->findEntryByPath("/Sample Entry");
+    QVERIFY(entry);
+    QCOMPARE(entry->historyItems().size(), 1);
+    QCOMPARE(entry->historyItems().first()->title(), QString("Second Title"));
+
+    // Nothing left to remove
+    pos = m_stdoutFile->pos();
+    Utils::Test::setNextPassword("a");
+    pruneCmd.execute({"prune", dbFile.fileName()});
+    m_stdoutFile->seek(pos);
+    m_stdoutFile->readLine(); // skip password prompt
+    lines = m_stdoutFile->readAll().split('\n');
+    QCOMPARE(lines.at(1), QByteArray("Removed history items: 0"));
+    QCOMPARE(lines.at(4), QByteArray("Database was not modified, the history is within the limits."));
+}
+
 void TestCli::testRemove()
 {
     Remove removeCmd;
@@ -68,6 +68,7 @@ private slots:
     void testMerge();
     void testMove();
     void testOpen();
+    void testPrune();
     void testRemove();
     void testRemoveGroup();
     void testRemoveQuiet();
@@ -131,6 +131,65 @@ void TestDatabase::testSignals()
     QCOMPARE(spyDiscarded.count(), 1);
 }
 
+void TestDatabase::testBulkUpdate()
+{
+    Database db;
+    auto* group1 = new Group();
+    group1->setUuid(QUuid::createUuid());
+    group1->setParent(db.rootGroup());
+    auto* entry1 = new Entry();
+    entry1->setUuid(QUuid::createUuid());
+    entry1->setGroup(db.rootGroup());
+
+    int finished = 0;
+    DatabaseChanges changes;
+    connect(&db, &Database::updateFinished, this, [&](const DatabaseChanges& c) {
+        ++finished;
+        changes = c;
+    });
+    QSignalSpy spyStarted(&db, SIGNAL(updateStarted()));
+    QSignalSpy spyModified(&db, SIGNAL(databaseModified()));
+
+    db.beginUpdate();
+    db.beginUpdate();
+    QVERIFY(db.isUpdating());
+    QCOMPARE(spyStarted.count(), 1);
+
+    auto* entry2 = new Entry();
+    entry2->setUuid(QUuid::createUuid());
+    entry2->setGroup(group1);
+    entry2->setTitle("added");
+
+    auto* entry3 = new Entry();
+    entry3->setUuid(QUuid::createUuid());
+    entry3->setGroup(group1);
+    delete entry3;
+
+    entry1->setTitle("modified");
+    entry1->setGroup(group1);
+
+    auto* group2 = new Group();
+    group2->setUuid(QUuid::createUuid());
+    group2->setParent(db.rootGroup());
+
+    db.endUpdate();
+    QCOMPARE(finished, 0);
+    db.endUpdate();
+    QVERIFY(!db.isUpdating());
+    QCOMPARE(finished, 1);
+
+    QCOMPARE(changes.addedEntries, QSet<QUuid>() << entry2->uuid());
+    QCOMPARE(changes.modifiedEntries, QSet<QUuid>() << entry1->uuid());
+    QVERIFY(changes.removedEntries.isEmpty());
+    QCOMPARE(changes.addedGroups, QSet<QUuid>() << group2->uuid());
+    QVERIFY(changes.modifiedGroups.contains(group1->uuid()));
+    QVERIFY(changes.removedGroups.isEmpty());
+
+    // the modified timer is only started once the update finished
+    QCOMPARE(spyModified.count(), 0);
+    QTRY_COMPARE(spyModified.count(), 1);
+}
+
 void TestDatabase::testEmptyRecycleBinOnDisabled()
 {
     QString filename = QString(KEEPASSX_TEST_DATA_DIR).append("/RecycleBinDisabled.kdbx");
@@ -30,6 +30,7 @@ private slots:
     void testOpen();
     void testSave();
     void testSignals();
+    void testBulkUpdate();
     void testEmptyRecycleBinOnDisabled();
     void testEmptyRecycleBinOnNotCreated();
     void testEmptyRecycleBinOnEmpty();
@@ -169,6 +169,93 @@ void TestEntry::testClone()
     QCOMPARE(entryClonePassRef->attributes()->referenceUuid(EntryAttributes::PasswordKey), entryOrgClone->uuid());
 }
 
+void TestEntry::testShareHistoryData()
+{
+    const QByteArray attachment(1024, 'a');
+
+    Entry entry;
+    entry.setUuid(QUuid::createUuid());
+    entry.setUsername("user");
+    entry.attachments()->set("a.txt", attachment);
+
+    // History items read from a file carry their own copies of equal values
+    auto* olderItem = new Entry();
+    olderItem->setUuid(entry.uuid());
+    olderItem->setTitle(QString("Old ") + QString("Title"));
+    entry.addHistoryItem(olderItem);
+
+    auto* historyItem = new Entry();
+    historyItem->setUuid(entry.uuid());
+    historyItem->setTitle("Old Title");
+    historyItem->setUsername(QString("us") + QString("er"));
+    historyItem->attachments()->set("a.txt", QByteArray(1024, 'a'));
+    QVERIFY(historyItem->username().constData() != entry.username().constData());
+    entry.addHistoryItem(historyItem);
+
+    QCOMPARE(historyItem->title(), QString("Old Title"));
+    QCOMPARE(historyItem->username(), QString("user"));
+    QCOMPARE(historyItem->username().constData(), entry.username().constData());
+    QCOMPARE(historyItem->attachments()->value("a.txt"), attachment);
+    QCOMPARE(historyItem->attachments()->value("a.txt").constData(),
+             entry.attachments()->value("a.txt").constData());
+
+    // Older items share with the next newer item
+    QVERIFY(olderItem->title().constData() != historyItem->title().constData());
+    entry.shareHistoryData();
+    QCOMPARE(olderItem->title(), QString("Old Title"));
+    QCOMPARE(olderItem->title().constData(), historyItem->title().constData());
+
+    // Changing a value does not change the history
+    entry.setUsername("other");
+    entry.attachments()->set("a.txt", "b");
+    QCOMPARE(historyItem->username(), QString("user"));
+    QCOMPARE(historyItem->attachments()->value("a.txt"), attachment);
+}
+
+void TestEntry::testHistorySize()
+{
+    Database db;
+    db.metadata()->setHistoryMaxItems(-1);
+    db.metadata()->setHistoryMaxSize(-1);
+
+    auto* entry = new Entry();
+    entry->setGroup(db.rootGroup());
+    const int emptySize = entry->dataSize();
+    QCOMPARE(entry->historySize(), 0);
+
+    entry->beginUpdate();
+    entry->setTags("a;bc");
+    entry->attachments()->set("key", QByteArray(100, 'x'));
+    entry->endUpdate();
+    QCOMPARE(entry->dataSize(), emptySize + 3 + 103);
+    QCOMPARE(entry->historySize(), emptySize);
+
+    entry->beginUpdate();
+    entry->setNotes("notes");
+    entry->endUpdate();
+    QCOMPARE(entry->historySize(), emptySize * 2 + 3 + 103);
+
+    // Changes of history items are accounted for
+    Entry* historyItem = entry->historyItems().first();
+    historyItem->attachments()->set("other", QByteArray(10, 'y'));
+    QCOMPARE(historyItem->dataSize(), emptySize + 15);
+    QCOMPARE(entry->historySize(), emptySize * 2 + 3 + 103 + 15);
+
+    entry->removeHistoryItems({historyItem});
+    QCOMPARE(entry->historySize(), emptySize + 3 + 103);
+
+    // Only the newest items that fit are kept, room for two items with a one character title
+    db.metadata()->setHistoryMaxSize(2 * (entry->dataSize() + 1));
+    for (int i = 0; i < 3; ++i) {
+        entry->beginUpdate();
+        entry->setTitle(QString::number(i));
+        entry->endUpdate();
+    }
+    QCOMPARE(entry->historyItems().size(), 2);
+    QCOMPARE(entry->historyItems().last()->title(), QString("1"));
+    QVERIFY(entry->historySize() <= db.metadata()->historyMaxSize());
+}
+
 void TestEntry::testResolveUrl()
 {
     QScopedPointer<Entry> entry(new Entry());
@@ -612,3 +699,66 @@ void TestEntry::testIsRecycled()
     db.recycleGroup(group1);
     QVERIFY(entry1->isRecycled());
 }
+
+void TestEntry::testReferenceIndex()
+{
+    Database db;
+    Group* root = db.rootGroup();
+
+    auto* target = new Entry();
+    target->setUuid(QUuid::createUuid());
+    target->setGroup(root);
+
+    Group* group1 = new Group();
+    group1->setParent(root);
+
+    auto* ref1 = new Entry();
+    ref1->setUuid(QUuid::createUuid());
+    ref1->setPassword(Entry::buildReference(target->uuid(), EntryAttributes::PasswordKey));
+    ref1->setGroup(group1);
+
+    QCOMPARE(ref1->referencedUuids(), QSet<QUuid>() << target->uuid());
+    QCOMPARE(db.referencingEntries(target->uuid()), QList<Entry*>() << ref1);
+    QCOMPARE(root->referencesRecursive(target), QList<Entry*>() << ref1);
+
+    // the index follows additions, modifications and removals
+    auto* ref2 = new Entry();
+    ref2->setUuid(QUuid::createUuid());
+    ref2->setGroup(root);
+    ref2->setUsername(Entry::buildReference(target->uuid(), EntryAttributes::UserNameKey));
+    QCOMPARE(db.referencingEntries(target->uuid()).size(), 2);
+    QCOMPARE(group1->referencesRecursive(target), QList<Entry*>() << ref1);
+
+    ref1->replaceReferencesWithValues(target);
+    QCOMPARE(db.referencingEntries(target->uuid()), QList<Entry*>() << ref2);
+
+    delete ref2;
+    QVERIFY(db.referencingEntries(target->uuid()).isEmpty());
+
+    ref1->setNotes(Entry::buildReference(target->uuid(), EntryAttributes::TitleKey));
+    QCOMPARE(db.referencingEntries(target->uuid()), QList<Entry*>() << ref1);
+
+    // moving a group to another database takes its entries out of the index
+    Database other;
+    group1->setParent(other.rootGroup());
+    QVERIFY(db.referencingEntries(target->uuid()).isEmpty());
+    QCOMPARE(other.referencingEntries(target->uuid()), QList<Entry*>() << ref1);
+
+    // the index agrees with hasReferencesTo() for mixed-case references and other search fields
+    const QString hex = target->uuidToHex();
+    auto* ref3 = new Entry();
+    ref3->setUuid(QUuid::createUuid());
+    ref3->setGroup(root);
+    ref3->setPassword(QString("{ref:p@I:%1%2}").arg(hex.left(16).toUpper(), hex.mid(16)));
+    QVERIFY(ref3->hasReferencesTo(target->uuid()));
+    QCOMPARE(ref3->referencedUuids(), QSet<QUuid>() << target->uuid());
+    QCOMPARE(db.referencingEntries(target->uuid()), QList<Entry*>() << ref3);
+
+    ref3->setPassword(QString("{REF:P@T:%1}").arg(hex.toUpper()));
+    QVERIFY(ref3->hasReferencesTo(target->uuid()));
+    QCOMPARE(db.referencingEntries(target->uuid()), QList<Entry*>() << ref3);
+
+    ref3->setPassword(hex);
+    QVERIFY(!ref3->hasReferencesTo(target->uuid()));
+    QVERIFY(db.referencingEntries(target->uuid()).isEmpty());
+}
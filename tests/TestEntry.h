@@ -31,6 +31,8 @@ private slots:
     void testHistoryItemDeletion();
     void testCopyDataFrom();
     void testClone();
+    void testShareHistoryData();
+    void testHistorySize();
     void testResolveUrl();
     void testResolveUrlPlaceholders();
     void testResolveRecursivePlaceholders();
@@ -38,6 +40,7 @@ private slots:
     void testResolveNonIdPlaceholdersToUuid();
     void testResolveClonedEntry();
     void testIsRecycled();
+    void testReferenceIndex();
 };
 
 #endif // KEEPASSX_TESTENTRY_H
@@ -360,3 +360,73 @@ void TestEntryModel::testDatabaseDelete()
     delete modelTest;
     delete model;
 }
+
+void TestEntryModel::testIncrementalSearchUpdate()
+{
+    EntryModel* model = new EntryModel(this);
+    ModelTest* modelTest = new ModelTest(model, this);
+
+    Database* db = new Database();
+    QList<Entry*> entries;
+    for (int i = 0; i < 5; ++i) {
+        Entry* entry = new Entry();
+        entry->setTitle(QString("entry%1").arg(i));
+        entry->setGroup(db->rootGroup());
+        entries.append(entry);
+    }
+
+    model->setEntries(entries);
+    QCOMPARE(model->rowCount(), 5);
+
+    QSignalSpy spyReset(model, SIGNAL(modelReset()));
+    QSignalSpy spyRemoved(model, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+    QSignalSpy spyAdded(model, SIGNAL(rowsInserted(QModelIndex, int, int)));
+
+    // Refining the search only removes rows
+    model->setEntries(QList<Entry*>() << entries[0] << entries[3] << entries[4]);
+    QCOMPARE(model->rowCount(), 3);
+    QCOMPARE(spyReset.count(), 0);
+    QCOMPARE(spyRemoved.count(), 1);
+    QCOMPARE(spyAdded.count(), 0);
+    QCOMPARE(model->indexFromEntry(entries[3]).row(), 1);
+    QCOMPARE(model->data(model->indexFromEntry(entries[4])).toString(), QString("entry4"));
+
+    // Widening the search inserts the new rows in one go at their position
+    model->setEntries(entries);
+    QCOMPARE(model->rowCount(), 5);
+    QCOMPARE(spyReset.count(), 0);
+    QCOMPARE(spyAdded.count(), 1);
+    for (int row = 0; row < entries.size(); ++row) {
+        QCOMPARE(model->indexFromEntry(entries[row]).row(), row);
+        QCOMPARE(model->entryFromIndex(model->index(row, 1)), entries[row]);
+    }
+
+    // Rows that change their order are reset
+    model->setEntries(QList<Entry*>() << entries[4] << entries[0]);
+    QCOMPARE(spyReset.count(), 1);
+    QCOMPARE(model->rowCount(), 2);
+    QCOMPARE(model->indexFromEntry(entries[4]).row(), 0);
+    QCOMPARE(model->indexFromEntry(entries[0]).row(), 1);
+    model->setEntries(entries);
+
+    // Cached display data follows entry changes, each change refreshes the row once
+    QSignalSpy spyDataChanged(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)));
+    entries[1]->setTitle("changed");
+    QCOMPARE(spyDataChanged.count(), 1);
+    QCOMPARE(model->data(model->indexFromEntry(entries[1])).toString(), QString("changed"));
+
+    // Rows are refreshed even if their data was never shown
+    entries[2]->attachments()->set("file", QByteArray("data"));
+    QCOMPARE(spyDataChanged.count(), 2);
+    QCOMPARE(spyDataChanged.last().at(0).value<QModelIndex>().row(), 2);
+
+    // Entries that are no longer shown are disconnected
+    model->setEntries(QList<Entry*>() << entries[0]);
+    spyDataChanged.clear();
+    entries[3]->setTitle("hidden");
+    QCOMPARE(spyDataChanged.count(), 0);
+
+    delete modelTest;
+    delete model;
+    delete db;
+}
@@ -0,0 +1,159 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestFaviconCache.h"
+
+#include "core/FaviconCache.h"
+#include "mock/MockClock.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+QTEST_GUILESS_MAIN(TestFaviconCache)
+
+namespace
+{
+    MockClock* m_clock = nullptr;
+} // namespace
+
+void TestFaviconCache::init()
+{
+    Q_ASSERT(m_clock == nullptr);
+    m_clock = new MockClock(2020, 2, 1, 12, 0, 0);
+    MockClock::setup(m_clock);
+}
+
+void TestFaviconCache::cleanup()
+{
+    MockClock::teardown();
+    m_clock = nullptr;
+}
+
+void TestFaviconCache::testInsertLookup()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FaviconCache cache(dir.path());
+
+    QByteArray data;
+    QCOMPARE(cache.lookup("example.com", data), FaviconCache::Missing);
+    QVERIFY(data.isEmpty());
+
+    cache.insert("example.com", "icon");
+    QCOMPARE(cache.lookup("example.com", data), FaviconCache::Found);
+    QCOMPARE(data, QByteArray("icon"));
+
+    // Host names are case insensitive
+    data.clear();
+    QCOMPARE(cache.lookup("EXAMPLE.com", data), FaviconCache::Found);
+    QCOMPARE(data, QByteArray("icon"));
+    QCOMPARE(cache.lookup("example.com:8080", data), FaviconCache::Missing);
+}
+
+void TestFaviconCache::testFailure()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FaviconCache cache(dir.path());
+
+    // Failed downloads are not cached, they are retried on the next run
+    QByteArray data;
+    cache.insert("example.com", QByteArray());
+    QCOMPARE(cache.lookup("example.com", data), FaviconCache::Missing);
+    QVERIFY(data.isEmpty());
+    QVERIFY(cache.save());
+    QCOMPARE(FaviconCache(dir.path()).lookup("example.com", data), FaviconCache::Missing);
+
+    // A failure does not replace a cached icon
+    cache.insert("example.com", "icon");
+    cache.insert("example.com", QByteArray());
+    QCOMPARE(cache.lookup("example.com", data), FaviconCache::Found);
+    QCOMPARE(data, QByteArray("icon"));
+}
+
+void TestFaviconCache::testExpiry()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    {
+        FaviconCache cache(dir.path());
+        cache.insert("example.com", "icon");
+        QVERIFY(cache.save());
+    }
+
+    QByteArray data;
+    m_clock->advanceDay(29);
+    QCOMPARE(FaviconCache(dir.path()).lookup("example.com", data), FaviconCache::Found);
+
+    m_clock->advanceDay(1);
+    FaviconCache cache(dir.path());
+    QCOMPARE(cache.lookup("example.com", data), FaviconCache::Missing);
+
+    // Expired icons are deleted on the next save
+    QVERIFY(cache.save());
+    QVERIFY(QDir(dir.path()).entryList({"*.png"}, QDir::Files).isEmpty());
+}
+
+void TestFaviconCache::testPersistence()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    {
+        FaviconCache cache(dir.path());
+        cache.insert("example.com", "icon");
+        cache.insert("example.org", QByteArray());
+        QVERIFY(cache.save());
+    }
+
+    QByteArray data;
+    FaviconCache cache(dir.path());
+    QCOMPARE(cache.lookup("example.com", data), FaviconCache::Found);
+    QCOMPARE(data, QByteArray("icon"));
+    QCOMPARE(cache.lookup("example.org", data), FaviconCache::Missing);
+
+    // The index must not reveal the websites
+    QFile index(QDir(dir.path()).absoluteFilePath("index.json"));
+    QVERIFY(index.open(QIODevice::ReadOnly));
+    const QByteArray content = index.readAll();
+    QVERIFY(!content.isEmpty());
+    QVERIFY(!content.contains("example"));
+}
+
+void TestFaviconCache::testSharedIcons()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FaviconCache cache(dir.path());
+
+    cache.insert("example.com", "icon");
+    cache.insert("www.example.com", "icon");
+    cache.insert("example.org", "other");
+    QCOMPARE(QDir(dir.path()).entryList({"*.png"}, QDir::Files).size(), 2);
+
+    // Replaced icons are deleted once no host refers to them
+    cache.insert("example.org", "icon");
+    QVERIFY(cache.save());
+    QCOMPARE(QDir(dir.path()).entryList({"*.png"}, QDir::Files).size(), 1);
+
+    QByteArray data;
+    QCOMPARE(cache.lookup("example.org", data), FaviconCache::Found);
+    QCOMPARE(data, QByteArray("icon"));
+}
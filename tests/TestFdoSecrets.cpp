@@ -19,19 +19,25 @@
 
 #include "TestGlobal.h"
 
+#include "core/Config.h"
+#include "core/Database.h"
 #include "core/EntrySearcher.h"
+#include "core/Group.h"
+#include "fdosecrets/FdoSecretsSettings.h"
 #include "fdosecrets/GcryptMPI.h"
 #include "fdosecrets/objects/SessionCipher.h"
 #include "fdosecrets/objects/Collection.h"
 #include "fdosecrets/objects/Item.h"
+#include "fdosecrets/widgets/DatabaseSettingsWidgetFdoSecrets.h"
 
 #include "crypto/Crypto.h"
 
-QTEST_GUILESS_MAIN(TestFdoSecrets)
+QTEST_MAIN(TestFdoSecrets)
 
 void TestFdoSecrets::initTestCase()
 {
     QVERIFY(Crypto::init());
+    Config::createTempFileInstance();
 }
 
 void TestFdoSecrets::cleanupTestCase()
@@ -112,3 +118,24 @@ void TestFdoSecrets::testCrazyAttributeKey()
     const auto res = EntrySearcher().search({term}, root.data());
     QCOMPARE(res.count(), 1);
 }
+
+void TestFdoSecrets::testSettingsNestedExposedGroup()
+{
+    auto db = QSharedPointer<Database>::create();
+    auto* group1 = new Group();
+    group1->setParent(db->rootGroup());
+    auto* group11 = new Group();
+    group11->setParent(group1);
+    auto* group111 = new Group();
+    group111->setParent(group11);
+
+    FdoSecrets::settings()->setEnabled(true);
+    FdoSecrets::settings()->setExposedGroup(db, group111->uuid());
+
+    // the exposed group is nested in a collapsed tree, it must still be
+    // selected and stored again instead of falling back to the root group
+    DatabaseSettingsWidgetFdoSecrets widget;
+    widget.loadSettings(db);
+    widget.saveSettings();
+    QCOMPARE(FdoSecrets::settings()->exposedGroup(db), group111->uuid());
+}
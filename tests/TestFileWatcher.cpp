@@ -0,0 +1,187 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestFileWatcher.h"
+#include "TestGlobal.h"
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include "core/FileWatcher.h"
+
+QTEST_GUILESS_MAIN(TestFileWatcher)
+
+namespace
+{
+    // larger than the head and the tail block of both check modes
+    const int FileSize = 256 * 1024;
+
+    bool writeFile(const QString& path, const QByteArray& content)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        return file.write(content) == content.size();
+    }
+
+    QByteArray fileContent()
+    {
+        QByteArray content(FileSize, 'a');
+        for (int i = 0; i < content.size(); i += 251) {
+            content[i] = static_cast<char>(i % 256);
+        }
+        return content;
+    }
+} // namespace
+
+/**
+ * Every check runs with hashed head and tail blocks and with a hash of the whole file.
+ */
+void TestFileWatcher::addModes()
+{
+    QTest::addColumn<int>("checksumSize");
+    QTest::newRow("Blocks") << 1;
+    QTest::newRow("Whole file") << -1;
+}
+
+void TestFileWatcher::testTouch_data()
+{
+    addModes();
+}
+
+void TestFileWatcher::testTouch()
+{
+    QFETCH(int, checksumSize);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("database.kdbx");
+    QVERIFY(writeFile(path, fileContent()));
+
+    FileWatcher watcher;
+    watcher.start(path, 0, checksumSize);
+    QVERIFY(watcher.hasSameFileChecksum());
+
+    // the metadata changes, the content does not
+    QTest::qWait(50);
+    QVERIFY(writeFile(path, fileContent()));
+    QVERIFY(watcher.hasSameFileChecksum());
+    QVERIFY(watcher.hasSameFileChecksum());
+}
+
+void TestFileWatcher::testHeadChange_data()
+{
+    addModes();
+}
+
+void TestFileWatcher::testHeadChange()
+{
+    QFETCH(int, checksumSize);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("database.kdbx");
+    QVERIFY(writeFile(path, fileContent()));
+
+    FileWatcher watcher;
+    watcher.start(path, 0, checksumSize);
+
+    QByteArray content = fileContent();
+    content[1] = 'b';
+    QVERIFY(writeFile(path, content));
+    QVERIFY(!watcher.hasSameFileChecksum());
+}
+
+void TestFileWatcher::testSizeChange_data()
+{
+    addModes();
+}
+
+void TestFileWatcher::testSizeChange()
+{
+    QFETCH(int, checksumSize);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("database.kdbx");
+    QVERIFY(writeFile(path, fileContent()));
+
+    FileWatcher watcher;
+    watcher.start(path, 0, checksumSize);
+
+    QVERIFY(writeFile(path, fileContent() + "appended"));
+    QVERIFY(!watcher.hasSameFileChecksum());
+}
+
+void TestFileWatcher::testMiddleChange_data()
+{
+    QTest::addColumn<int>("checksumSize");
+    QTest::addColumn<bool>("detected");
+    // a change between the head and the tail block is only found by a hash of the whole file
+    QTest::newRow("Blocks") << 1 << false;
+    QTest::newRow("Whole file") << -1 << true;
+}
+
+void TestFileWatcher::testMiddleChange()
+{
+    QFETCH(int, checksumSize);
+    QFETCH(bool, detected);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("database.kdbx");
+    QVERIFY(writeFile(path, fileContent()));
+
+    FileWatcher watcher;
+    watcher.start(path, 0, checksumSize);
+
+    QByteArray content = fileContent();
+    content[FileSize / 2] = 'b';
+    QVERIFY(writeFile(path, content));
+    QCOMPARE(watcher.hasSameFileChecksum(), !detected);
+}
+
+void TestFileWatcher::testBackoffReset()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("database.kdbx");
+    QVERIFY(writeFile(path, fileContent()));
+
+    FileWatcher watcher;
+    QSignalSpy spyChanged(&watcher, SIGNAL(fileChanged()));
+    watcher.start(path, 1, 1);
+    QCOMPARE(watcher.checksumInterval(), 1000);
+
+    // the file is polled less often while nothing changes
+    QTRY_COMPARE_WITH_TIMEOUT(watcher.checksumInterval(), 2000, 3000);
+    QTRY_COMPARE_WITH_TIMEOUT(watcher.checksumInterval(), 4000, 4000);
+
+    // a touch resets the interval
+    QVERIFY(writeFile(path, fileContent()));
+    QTRY_COMPARE_WITH_TIMEOUT(watcher.checksumInterval(), 1000, 6000);
+    QTRY_COMPARE_WITH_TIMEOUT(watcher.checksumInterval(), 2000, 3000);
+
+    // a real change resets the interval and is reported
+    spyChanged.clear();
+    QByteArray content = fileContent();
+    content[1] = 'b';
+    QVERIFY(writeFile(path, content));
+    QTRY_VERIFY_WITH_TIMEOUT(spyChanged.count() > 0, 4000);
+    QCOMPARE(watcher.checksumInterval(), 1000);
+
+    watcher.stop();
+    QCOMPARE(watcher.checksumInterval(), 0);
+}
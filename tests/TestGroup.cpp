@@ -20,6 +20,7 @@
 #include "TestGlobal.h"
 #include "mock/MockClock.h"
 
+#include <QBuffer>
 #include <QSignalSpy>
 
 #include "core/Metadata.h"
@@ -317,10 +318,15 @@ void TestGroup::testCopyCustomIcon()
     groupIcon.setPixel(0, 0, qRgb(255, 0, 0));
     dbSource->metadata()->addCustomIcon(groupIconUuid, groupIcon);
 
+    // stored in a format other than PNG, the data must be copied as is
     QUuid entryIconUuid = QUuid::createUuid();
     QImage entryIcon(16, 16, QImage::Format_RGB32);
     entryIcon.setPixel(0, 0, qRgb(255, 0, 0));
-    dbSource->metadata()->addCustomIcon(entryIconUuid, entryIcon);
+    QByteArray entryIconData;
+    QBuffer buffer(&entryIconData);
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QVERIFY(entryIcon.save(&buffer, "BMP"));
+    dbSource->metadata()->addCustomIcon(entryIconUuid, entryIconData);
 
     Group* group = new Group();
     group->setParent(dbSource->rootGroup());
@@ -336,11 +342,14 @@ void TestGroup::testCopyCustomIcon()
 
     group->setParent(dbTarget->rootGroup());
     QVERIFY(dbTarget->metadata()->containsCustomIcon(groupIconUuid));
+    QCOMPARE(dbTarget->metadata()->customIconData(groupIconUuid),
+             dbSource->metadata()->customIconData(groupIconUuid));
     QCOMPARE(dbTarget->metadata()->customIcon(groupIconUuid), groupIcon);
     QCOMPARE(group->icon(), groupIcon);
 
     entry->setGroup(dbTarget->rootGroup());
     QVERIFY(dbTarget->metadata()->containsCustomIcon(entryIconUuid));
+    QCOMPARE(dbTarget->metadata()->customIconData(entryIconUuid), entryIconData);
     QCOMPARE(dbTarget->metadata()->customIcon(entryIconUuid), entryIcon);
     QCOMPARE(entry->icon(), entryIcon);
 }
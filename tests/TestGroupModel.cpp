@@ -148,3 +148,112 @@ void TestGroupModel::test()
     delete modelTest;
     delete model;
 }
+
+void TestGroupModel::testLazyFetch()
+{
+    Database* db = new Database();
+    Group* groupRoot = db->rootGroup();
+
+    Group* group1 = new Group();
+    group1->setName("group1");
+    group1->setParent(groupRoot);
+
+    Group* group11 = new Group();
+    group11->setName("group11");
+    group11->setParent(group1);
+
+    Entry* entry = new Entry();
+    entry->setGroup(group11);
+
+    GroupModel* model = new GroupModel(db, this);
+
+    QModelIndex indexRoot = model->index(0, 0);
+    QVERIFY(model->hasChildren(indexRoot));
+    QVERIFY(model->canFetchMore(indexRoot));
+    QCOMPARE(model->rowCount(indexRoot), 0);
+    QCOMPARE(model->data(indexRoot, Qt::ToolTipRole).toString(), QString("1 entry(s)"));
+
+    QSignalSpy spyAdded(model, SIGNAL(rowsInserted(QModelIndex, int, int)));
+    QSignalSpy spyChanged(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)));
+
+    // changes below unfetched groups are not reported
+    Group* group12 = new Group();
+    group12->setParent(group1);
+    group11->setName("test");
+    QCOMPARE(spyAdded.count(), 0);
+    QCOMPARE(spyChanged.count(), 0);
+
+    model->fetchMore(indexRoot);
+    QCOMPARE(spyAdded.count(), 1);
+    QCOMPARE(model->rowCount(indexRoot), 1);
+    QVERIFY(!model->canFetchMore(indexRoot));
+
+    QModelIndex index1 = model->index(0, 0, indexRoot);
+    QCOMPARE(model->rowCount(index1), 0);
+
+    model->fetchParents(group11);
+    QCOMPARE(spyAdded.count(), 2);
+    QCOMPARE(model->rowCount(index1), 2);
+    QCOMPARE(model->index(group11), model->index(0, 0, index1));
+    QCOMPARE(model->data(model->index(group11)).toString(), QString("test"));
+
+    // empty groups are fetched implicitly
+    QModelIndex index12 = model->index(group12);
+    QVERIFY(!model->hasChildren(index12));
+    QVERIFY(!model->canFetchMore(index12));
+    Group* group121 = new Group();
+    group121->setParent(group12);
+    QCOMPARE(spyAdded.count(), 3);
+    QCOMPARE(model->rowCount(index12), 1);
+
+    delete model;
+    delete db;
+}
+
+void TestGroupModel::testBatchUpdate()
+{
+    Database* db = new Database();
+    Group* groupRoot = db->rootGroup();
+
+    Group* group1 = new Group();
+    group1->setName("group1");
+    group1->setParent(groupRoot);
+
+    Group* group2 = new Group();
+    group2->setName("group2");
+    group2->setParent(groupRoot);
+
+    GroupModel* model = new GroupModel(db, this);
+    ModelTest* modelTest = new ModelTest(model, this);
+
+    QPersistentModelIndex index2 = model->index(group2);
+    QSignalSpy spyAdded(model, SIGNAL(rowsInserted(QModelIndex, int, int)));
+    QSignalSpy spyRemoved(model, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+    QSignalSpy spyMoved(model, SIGNAL(rowsMoved(QModelIndex, int, int, QModelIndex, int)));
+    QSignalSpy spyLayout(model, SIGNAL(layoutChanged()));
+
+    model->beginBatchUpdate();
+    model->beginBatchUpdate();
+    for (int i = 0; i < 10; ++i) {
+        Group* group = new Group();
+        group->setParent(group1);
+    }
+    group2->setParent(group1, 0);
+    delete group1->children().last();
+    model->endBatchUpdate();
+    QCOMPARE(spyLayout.count(), 0);
+    model->endBatchUpdate();
+
+    QCOMPARE(spyAdded.count(), 0);
+    QCOMPARE(spyRemoved.count(), 0);
+    QCOMPARE(spyMoved.count(), 0);
+    QCOMPARE(spyLayout.count(), 1);
+    QVERIFY(index2.isValid());
+    QCOMPARE(index2.parent(), model->index(group1));
+    QCOMPARE(index2.row(), 0);
+    QCOMPARE(model->rowCount(model->index(group1)), 10);
+
+    delete modelTest;
+    delete model;
+    delete db;
+}
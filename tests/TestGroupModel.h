@@ -27,6 +27,8 @@ class TestGroupModel : public QObject
 private slots:
     void initTestCase();
     void test();
+    void testLazyFetch();
+    void testBatchUpdate();
 };
 
 #endif // KEEPASSX_TESTGROUPMODEL_H
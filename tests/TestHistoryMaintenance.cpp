@@ -0,0 +1,193 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestHistoryMaintenance.h"
+
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "core/HistoryMaintenance.h"
+#include "core/Metadata.h"
+#include "crypto/Crypto.h"
+#include "mock/MockClock.h"
+
+#include <QTest>
+
+QTEST_GUILESS_MAIN(TestHistoryMaintenance)
+
+namespace
+{
+    MockClock* m_clock = nullptr;
+
+    Entry* createEntry(Database* db, int historyItems)
+    {
+        auto* entry = new Entry();
+        entry->setUuid(QUuid::createUuid());
+        entry->setGroup(db->rootGroup());
+        for (int i = 0; i < historyItems; ++i) {
+            m_clock->advanceDay(1);
+            entry->beginUpdate();
+            entry->setTitle(QString::number(i));
+            entry->endUpdate();
+        }
+        return entry;
+    }
+} // namespace
+
+void TestHistoryMaintenance::initTestCase()
+{
+    QVERIFY(Crypto::init());
+}
+
+void TestHistoryMaintenance::init()
+{
+    Q_ASSERT(m_clock == nullptr);
+    m_clock = new MockClock(2010, 5, 5, 10, 30, 10);
+    MockClock::setup(m_clock);
+}
+
+void TestHistoryMaintenance::cleanup()
+{
+    MockClock::teardown();
+    m_clock = nullptr;
+}
+
+void TestHistoryMaintenance::testMaxItems()
+{
+    Database db;
+    db.metadata()->setHistoryMaxItems(-1);
+    db.metadata()->setHistoryMaxSize(-1);
+    db.metadata()->setMaintenanceHistoryDays(-1);
+
+    Entry* entry1 = createEntry(&db, 5);
+    Entry* entry2 = createEntry(&db, 2);
+    const TimeInfo timeInfo = entry1->timeInfo();
+
+    HistoryMaintenance maintenance(&db);
+    maintenance.setMaxItems(3);
+    const HistoryMaintenance::Report report = maintenance.run();
+    QCOMPARE(report.entries, 1);
+    QCOMPARE(report.historyItems, 2);
+    QVERIFY(report.reclaimedBytes > 0);
+
+    // The newest items are kept
+    QCOMPARE(entry1->historyItems().size(), 3);
+    QCOMPARE(entry1->historyItems().first()->title(), QString("1"));
+    QCOMPARE(entry2->historyItems().size(), 2);
+
+    // Removing history does not modify the entry
+    QCOMPARE(entry1->timeInfo(), timeInfo);
+}
+
+void TestHistoryMaintenance::testMaxSize()
+{
+    Database db;
+    db.metadata()->setHistoryMaxItems(-1);
+    db.metadata()->setHistoryMaxSize(-1);
+    db.metadata()->setMaintenanceHistoryDays(-1);
+
+    Entry* entry = createEntry(&db, 5);
+    const QList<Entry*> history = entry->historyItems();
+    const int newestSize = history.at(4)->dataSize() + history.at(3)->dataSize();
+
+    HistoryMaintenance maintenance(&db);
+    maintenance.setMaxSize(newestSize);
+    const HistoryMaintenance::Report report = maintenance.run();
+    QCOMPARE(report.historyItems, 3);
+    QCOMPARE(entry->historyItems().size(), 2);
+    QCOMPARE(entry->historySize(), newestSize);
+}
+
+void TestHistoryMaintenance::testMaxAge()
+{
+    Database db;
+    db.metadata()->setHistoryMaxItems(-1);
+    db.metadata()->setHistoryMaxSize(-1);
+
+    Entry* entry = createEntry(&db, 5);
+    m_clock->advanceDay(2);
+
+    // The history items were last modified 3 to 7 days ago
+    db.metadata()->setMaintenanceHistoryDays(4);
+    const HistoryMaintenance::Report report = HistoryMaintenance(&db).run();
+    QCOMPARE(report.historyItems, 3);
+    QCOMPARE(entry->historyItems().size(), 2);
+    QCOMPARE(entry->historyItems().first()->title(), QString("2"));
+
+    db.metadata()->setMaintenanceHistoryDays(0);
+    QVERIFY(HistoryMaintenance(&db).run().isEmpty());
+}
+
+void TestHistoryMaintenance::testDryRun()
+{
+    Database db;
+    db.metadata()->setHistoryMaxItems(-1);
+    db.metadata()->setHistoryMaxSize(-1);
+    db.metadata()->setMaintenanceHistoryDays(-1);
+
+    Entry* entry = createEntry(&db, 5);
+    db.metadata()->setHistoryMaxItems(1);
+
+    HistoryMaintenance maintenance(&db);
+    const HistoryMaintenance::Report preview = maintenance.run(true);
+    QCOMPARE(preview.entries, 1);
+    QCOMPARE(preview.historyItems, 4);
+    QCOMPARE(entry->historyItems().size(), 5);
+
+    const HistoryMaintenance::Report report = maintenance.run();
+    QCOMPARE(report.historyItems, preview.historyItems);
+    QCOMPARE(report.reclaimedBytes, preview.reclaimedBytes);
+    QCOMPARE(entry->historyItems().size(), 1);
+
+    QVERIFY(maintenance.run().isEmpty());
+}
+
+void TestHistoryMaintenance::testSharedAttachments()
+{
+    Database db;
+    db.metadata()->setHistoryMaxItems(-1);
+    db.metadata()->setHistoryMaxSize(-1);
+    db.metadata()->setMaintenanceHistoryDays(-1);
+
+    const QByteArray shared(1000, 's');
+    const QByteArray removed(2000, 'r');
+
+    auto* other = createEntry(&db, 0);
+    other->attachments()->set("shared.bin", shared);
+
+    Entry* entry = createEntry(&db, 0);
+    entry->beginUpdate();
+    entry->attachments()->set("shared.bin", shared);
+    entry->attachments()->set("removed.bin", removed);
+    entry->endUpdate();
+    entry->beginUpdate();
+    entry->attachments()->clear();
+    entry->endUpdate();
+    entry->beginUpdate();
+    entry->setTitle("Title");
+    entry->endUpdate();
+
+    HistoryMaintenance maintenance(&db);
+    maintenance.setMaxItems(1);
+    const HistoryMaintenance::Report report = maintenance.run();
+    QCOMPARE(report.historyItems, 2);
+
+    // The shared attachment is still used by the other entry
+    QCOMPARE(report.attachments, 1);
+    QVERIFY(report.reclaimedBytes >= removed.size());
+    QVERIFY(report.reclaimedBytes < removed.size() + shared.size());
+}
@@ -0,0 +1,179 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestIconCache.h"
+
+#include "core/IconCache.h"
+#include "core/Metadata.h"
+#include "crypto/Crypto.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <QTest>
+#include <QThreadPool>
+
+QTEST_MAIN(TestIconCache)
+
+namespace
+{
+    QByteArray iconData(const QColor& color, int size = 32)
+    {
+        QImage image(size, size, QImage::Format_ARGB32);
+        image.fill(color);
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "PNG");
+        return data;
+    }
+} // namespace
+
+void TestIconCache::initTestCase()
+{
+    QVERIFY(Crypto::init());
+}
+
+void TestIconCache::init()
+{
+    iconCache()->clear();
+    iconCache()->setMaxCost(IconCache::DefaultMaxCost);
+}
+
+void TestIconCache::cleanupTestCase()
+{
+    init();
+}
+
+void TestIconCache::testHit()
+{
+    const QUuid uuid = QUuid::createUuid();
+    const IconCache::Source source{1, iconData(Qt::red)};
+
+    const QPixmap pixmap = iconCache()->scaledPixmap(uuid, source, 16);
+    QCOMPARE(pixmap.size(), QSize(16, 16));
+    QCOMPARE(iconCache()->scaledPixmap(uuid, source, 16).cacheKey(), pixmap.cacheKey());
+
+    // Every size is cached on its own
+    const QPixmap large = iconCache()->scaledPixmap(uuid, source, 24);
+    QCOMPARE(large.size(), QSize(24, 24));
+    QVERIFY(large.cacheKey() != pixmap.cacheKey());
+    QCOMPARE(iconCache()->scaledPixmap(uuid, source, 16).cacheKey(), pixmap.cacheKey());
+
+    // A different source for the same uuid is never served stale
+    const QPixmap other = iconCache()->scaledPixmap(uuid, {2, iconData(Qt::blue)}, 16);
+    QVERIFY(other.cacheKey() != pixmap.cacheKey());
+    QCOMPARE(other.toImage().pixelColor(8, 8), QColor(Qt::blue));
+
+    QVERIFY(iconCache()->scaledPixmap(uuid, {3, QByteArray("invalid")}, 16).isNull());
+    QVERIFY(iconCache()->scaledPixmap(uuid, {4, QByteArray()}, 16).isNull());
+}
+
+void TestIconCache::testInvalidate()
+{
+    const QUuid uuid = QUuid::createUuid();
+    const QUuid otherUuid = QUuid::createUuid();
+    const IconCache::Source source{1, iconData(Qt::red)};
+
+    const QPixmap small = iconCache()->scaledPixmap(uuid, source, 16);
+    const QPixmap large = iconCache()->scaledPixmap(uuid, source, 24);
+    const QPixmap other = iconCache()->scaledPixmap(otherUuid, source, 16);
+
+    // All sizes of the icon are dropped, other icons are kept
+    iconCache()->invalidate(uuid);
+    QVERIFY(iconCache()->scaledPixmap(uuid, source, 16).cacheKey() != small.cacheKey());
+    QVERIFY(iconCache()->scaledPixmap(uuid, source, 24).cacheKey() != large.cacheKey());
+    QCOMPARE(iconCache()->scaledPixmap(otherUuid, source, 16).cacheKey(), other.cacheKey());
+}
+
+void TestIconCache::testEviction()
+{
+    // Each 16x16 pixmap costs 1 KiB, only the two most recently used fit
+    iconCache()->setMaxCost(2);
+    QCOMPARE(iconCache()->maxCost(), 2);
+
+    const IconCache::Source source{1, iconData(Qt::red)};
+    const QUuid first = QUuid::createUuid();
+    const QUuid second = QUuid::createUuid();
+    const QUuid third = QUuid::createUuid();
+
+    const QPixmap firstPixmap = iconCache()->scaledPixmap(first, source, 16);
+    const QPixmap secondPixmap = iconCache()->scaledPixmap(second, source, 16);
+    QCOMPARE(iconCache()->scaledPixmap(first, source, 16).cacheKey(), firstPixmap.cacheKey());
+    const QPixmap thirdPixmap = iconCache()->scaledPixmap(third, source, 16);
+
+    QCOMPARE(iconCache()->scaledPixmap(third, source, 16).cacheKey(), thirdPixmap.cacheKey());
+    QCOMPARE(iconCache()->scaledPixmap(first, source, 16).cacheKey(), firstPixmap.cacheKey());
+    QVERIFY(iconCache()->scaledPixmap(second, source, 16).cacheKey() != secondPixmap.cacheKey());
+}
+
+void TestIconCache::testPrefetchSizes()
+{
+    const QUuid uuid = QUuid::createUuid();
+    QHash<QUuid, IconCache::Source> icons;
+    icons.insert(uuid, {1, iconData(Qt::red)});
+
+    // Requests for the same icon in different sizes must not collapse into one
+    iconCache()->prefetch(icons, 16);
+    iconCache()->prefetch(icons, 24);
+    QVERIFY(QThreadPool::globalInstance()->waitForDone());
+    QTRY_VERIFY(iconCache()->m_pending.isEmpty());
+    QVERIFY(iconCache()->m_cache.contains({uuid, 16}));
+    QVERIFY(iconCache()->m_cache.contains({uuid, 24}));
+}
+
+void TestIconCache::testReplacedCustomIcon()
+{
+    Metadata metadata;
+    const QUuid uuid = QUuid::createUuid();
+    metadata.addCustomIcon(uuid, iconData(Qt::red));
+
+    const QPixmap pixmap = metadata.customIconScaledPixmap(uuid);
+    QCOMPARE(pixmap.size(), QSize(16, 16));
+    QCOMPARE(metadata.customIconScaledPixmap(uuid).cacheKey(), pixmap.cacheKey());
+
+    metadata.removeCustomIcon(uuid);
+    QVERIFY(metadata.customIconScaledPixmap(uuid).isNull());
+
+    metadata.addCustomIcon(uuid, iconData(Qt::blue));
+    const QPixmap replaced = metadata.customIconScaledPixmap(uuid);
+    QVERIFY(replaced.cacheKey() != pixmap.cacheKey());
+    QCOMPARE(replaced.toImage().pixelColor(8, 8), QColor(Qt::blue));
+}
+
+void TestIconCache::testScaledPixmaps()
+{
+    Metadata metadata;
+    const QUuid first = QUuid::createUuid();
+    const QUuid second = QUuid::createUuid();
+    metadata.addCustomIcon(first, iconData(Qt::red));
+    metadata.addCustomIcon(second, iconData(Qt::green));
+
+    const QHash<QUuid, QPixmap> pixmaps = metadata.customIconsScaledPixmaps();
+    QCOMPARE(pixmaps.size(), 2);
+    QCOMPARE(pixmaps.value(first).cacheKey(), metadata.customIconScaledPixmap(first).cacheKey());
+    QCOMPARE(metadata.customIconsScaledPixmaps().value(second).cacheKey(), pixmaps.value(second).cacheKey());
+
+    metadata.removeCustomIcon(second);
+    metadata.addCustomIcon(second, iconData(Qt::blue));
+    const QHash<QUuid, QPixmap> replaced = metadata.customIconsScaledPixmaps();
+    QCOMPARE(replaced.size(), 2);
+    QCOMPARE(replaced.value(first).cacheKey(), pixmaps.value(first).cacheKey());
+    QCOMPARE(replaced.value(second).toImage().pixelColor(8, 8), QColor(Qt::blue));
+
+    metadata.removeCustomIcon(first);
+    QCOMPARE(metadata.customIconsScaledPixmaps().keys(), QList<QUuid>() << second);
+}
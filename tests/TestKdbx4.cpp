@@ -434,3 +434,44 @@ QSharedPointer<Kdf> TestKdbx4::fastKdf(QSharedPointer<Kdf> kdf)
 
     return kdf;
 }
+
+void TestKdbx4::testReuseTransformedKey()
+{
+    auto key = QSharedPointer<CompositeKey>::create();
+    key->addKey(QSharedPointer<PasswordKey>::create("test"));
+
+    QScopedPointer<Database> sourceDb(new Database());
+    sourceDb->changeKdf(fastKdf(KeePass2::uuidToKdf(KeePass2::KDF_ARGON2)));
+    sourceDb->setKey(key, true, true);
+    const QByteArray seed = sourceDb->kdf()->seed();
+    const QByteArray transformedKey = sourceDb->transformedMasterKey();
+    QVERIFY(!transformedKey.isEmpty());
+
+    // restore the derived key without running the KDF
+    QScopedPointer<Database> db(new Database());
+    db->metadata()->setName("Reused key");
+    db->setTransformedKey(key, sourceDb->kdf()->clone(), transformedKey);
+    QCOMPARE(db->transformedMasterKey(), transformedKey);
+
+    QBuffer buffer;
+    buffer.open(QBuffer::ReadWrite);
+    KeePass2Writer writer;
+    writer.setReuseTransformedKey(true);
+    QVERIFY(writer.writeDatabase(&buffer, db.data()));
+    QCOMPARE(db->kdf()->seed(), seed);
+    QCOMPARE(db->transformedMasterKey(), transformedKey);
+
+    buffer.seek(0);
+    KeePass2Reader reader;
+    auto targetDb = QSharedPointer<Database>::create();
+    reader.readDatabase(&buffer, key, targetDb.data());
+    QVERIFY2(!reader.hasError(), qPrintable(reader.errorString()));
+    QCOMPARE(targetDb->metadata()->name(), QString("Reused key"));
+    QCOMPARE(targetDb->kdf()->seed(), seed);
+
+    // without reuse the seed is randomized on every write
+    buffer.seek(0);
+    KeePass2Writer freshWriter;
+    QVERIFY(freshWriter.writeDatabase(&buffer, db.data()));
+    QVERIFY(db->kdf()->seed() != seed);
+}
@@ -31,6 +31,7 @@ private slots:
     void testUpgradeMasterKeyIntegrity();
     void testUpgradeMasterKeyIntegrity_data();
     void testCustomData();
+    void testReuseTransformedKey();
 
 protected:
     void initTestCaseImpl() override;
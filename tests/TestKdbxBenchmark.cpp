@@ -0,0 +1,237 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestKdbxBenchmark.h"
+#include "TestGlobal.h"
+
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "crypto/Crypto.h"
+#include "crypto/kdf/Kdf.h"
+#include "format/KeePass2.h"
+#include "format/KeePass2Reader.h"
+#include "format/KeePass2Writer.h"
+#include "keys/PasswordKey.h"
+#include "util/SyntheticDatabase.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+#include <limits>
+
+QTEST_GUILESS_MAIN(TestKdbxBenchmark)
+
+namespace
+{
+    int entryCount(const Database* db)
+    {
+        return db->rootGroup()->entriesRecursive().size();
+    }
+
+    QSharedPointer<Kdf> createKdf(const QString& version, bool fullStrength)
+    {
+        auto kdf = KeePass2::uuidToKdf(version == "KDBX3" ? KeePass2::KDF_AES_KDBX3 : KeePass2::KDF_ARGON2);
+        if (!fullStrength) {
+            // Reduce the key derivation to the minimum so only the file format is measured
+            kdf->setRounds(1);
+            if (kdf->uuid() == KeePass2::KDF_ARGON2) {
+                kdf->processParameters(
+                    {{KeePass2::KDFPARAM_ARGON2_MEMORY, 8}, {KeePass2::KDFPARAM_ARGON2_PARALLELISM, 1}});
+            }
+        }
+        return kdf;
+    }
+
+    double perSecond(double amount, qint64 nsecs)
+    {
+        return nsecs > 0 ? amount * 1e9 / nsecs : 0.0;
+    }
+} // namespace
+
+void TestKdbxBenchmark::initTestCase()
+{
+    QVERIFY(Crypto::init());
+
+    m_enabled = BenchmarkReport::isEnabled();
+    if (m_enabled) {
+        m_db = SyntheticDatabase(SyntheticDatabase::Parameters::fromEnvironment()).generate();
+    }
+}
+
+void TestKdbxBenchmark::cleanupTestCase()
+{
+    m_report.setValue("parameters", SyntheticDatabase::Parameters::fromEnvironment().toJson());
+    QString error;
+    QVERIFY2(m_report.write(&error), qPrintable(error));
+}
+
+void TestKdbxBenchmark::testSyntheticDatabase()
+{
+    SyntheticDatabase::Parameters parameters;
+    parameters.groups = 5;
+    parameters.entries = 50;
+    parameters.historyDepth = 2;
+    parameters.attachmentInterval = 5;
+    parameters.attachmentSize = 64;
+    parameters.referenceInterval = 10;
+
+    SyntheticDatabase generator(parameters);
+    auto db1 = generator.generate();
+    auto db2 = SyntheticDatabase(parameters).generate();
+
+    QCOMPARE(db1->rootGroup()->groupsRecursive(false).size(), 5);
+    QCOMPARE(entryCount(db1.data()), 50);
+
+    const QList<Entry*> entries1 = db1->rootGroup()->entriesRecursive();
+    const QList<Entry*> entries2 = db2->rootGroup()->entriesRecursive();
+    QCOMPARE(entries1.size(), entries2.size());
+    int references = 0;
+    int attachments = 0;
+    for (int i = 0; i < entries1.size(); ++i) {
+        QCOMPARE(entries1[i]->uuid(), entries2[i]->uuid());
+        QCOMPARE(entries1[i]->title(), entries2[i]->title());
+        QCOMPARE(entries1[i]->password(), entries2[i]->password());
+        QCOMPARE(entries1[i]->timeInfo(), entries2[i]->timeInfo());
+        QCOMPARE(entries1[i]->historyItems().size(), 2);
+        QCOMPARE(entries1[i]->attributes()->customKeys().size(), parameters.protectedAttributes);
+        if (entries1[i]->hasReferences()) {
+            QVERIFY(!entries1[i]->resolveMultiplePlaceholders(entries1[i]->username()).startsWith("{REF:"));
+            ++references;
+        }
+        if (!entries1[i]->attachments()->isEmpty()) {
+            ++attachments;
+        }
+    }
+    QCOMPARE(references, 5);
+    QCOMPARE(attachments, 10);
+
+    parameters.seed = 2;
+    auto db3 = SyntheticDatabase(parameters).generate();
+    QVERIFY(db3->rootGroup()->entriesRecursive().first()->uuid() != entries1.first()->uuid());
+}
+
+void TestKdbxBenchmark::benchmarkReadWrite_data()
+{
+    QTest::addColumn<QString>("version");
+    QTest::addColumn<QUuid>("cipher");
+    QTest::addColumn<QString>("cipherName");
+    QTest::addColumn<int>("compression");
+    QTest::addColumn<bool>("fullKdf");
+
+    const QList<QPair<QUuid, QString>> ciphers({{KeePass2::CIPHER_AES256, "AES256"},
+                                                {KeePass2::CIPHER_TWOFISH, "Twofish"},
+                                                {KeePass2::CIPHER_CHACHA20, "ChaCha20"}});
+    for (const QString& version : {QString("KDBX3"), QString("KDBX4")}) {
+        for (const auto& cipher : ciphers) {
+            for (int compression : {Database::CompressionNone, Database::CompressionGZip}) {
+                const QString name = QString("%1-%2-%3-nokdf")
+                                         .arg(version, cipher.second, compression ? "gzip" : "none");
+                QTest::newRow(qPrintable(name)) << version << cipher.first << cipher.second << compression << false;
+            }
+        }
+        // One run with the default key derivation shows its share of the unlock time
+        QTest::newRow(qPrintable(QString("%1-AES256-gzip-kdf").arg(version)))
+            << version << KeePass2::CIPHER_AES256 << QString("AES256") << int(Database::CompressionGZip) << true;
+    }
+}
+
+/**
+ * Measures wall clock time of saving to and loading from memory.
+ * QBENCHMARK only reports a single value per row, so save and load are timed
+ * separately and the best of BENCHMARK_ITERATIONS runs (default: 3) is reported.
+ */
+void TestKdbxBenchmark::benchmarkReadWrite()
+{
+    if (!m_enabled) {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    QFETCH(QString, version);
+    QFETCH(QUuid, cipher);
+    QFETCH(QString, cipherName);
+    QFETCH(int, compression);
+    QFETCH(bool, fullKdf);
+
+    int iterations = qEnvironmentVariableIntValue("BENCHMARK_ITERATIONS");
+    if (iterations <= 0) {
+        iterations = 3;
+    }
+
+    auto key = QSharedPointer<CompositeKey>::create();
+    key->addKey(QSharedPointer<PasswordKey>::create("benchmark"));
+
+    m_db->setCipher(cipher);
+    m_db->setCompressionAlgorithm(static_cast<Database::CompressionAlgorithm>(compression));
+    m_db->setKdf(createKdf(version, fullKdf));
+    QVERIFY(m_db->setKey(key, true, true));
+
+    const int entries = entryCount(m_db.data());
+    qint64 bestSave = std::numeric_limits<qint64>::max();
+    qint64 bestLoad = std::numeric_limits<qint64>::max();
+    QByteArray data;
+    QElapsedTimer timer;
+
+    for (int i = 0; i < iterations; ++i) {
+        QBuffer buffer;
+        buffer.open(QBuffer::WriteOnly);
+        KeePass2Writer writer;
+        timer.start();
+        const bool saved = writer.writeDatabase(&buffer, m_db.data());
+        bestSave = qMin(bestSave, timer.nsecsElapsed());
+        QVERIFY2(saved, qPrintable(writer.errorString()));
+        QCOMPARE(writer.version() >= KeePass2::FILE_VERSION_4, version == "KDBX4");
+        data = buffer.data();
+    }
+
+    for (int i = 0; i < iterations; ++i) {
+        QBuffer buffer(&data);
+        buffer.open(QBuffer::ReadOnly);
+        KeePass2Reader reader;
+        auto db = QSharedPointer<Database>::create();
+        timer.start();
+        const bool loaded = reader.readDatabase(&buffer, key, db.data());
+        bestLoad = qMin(bestLoad, timer.nsecsElapsed());
+        QVERIFY2(loaded, qPrintable(reader.errorString()));
+        QCOMPARE(entryCount(db.data()), entries);
+    }
+
+    const double megabytes = data.size() / 1e6;
+    QJsonObject result;
+    result["name"] = QString(QTest::currentDataTag());
+    result["version"] = version;
+    result["cipher"] = cipherName;
+    result["compression"] = compression ? QString("gzip") : QString("none");
+    result["kdf"] = fullKdf ? (version == "KDBX3" ? QString("AES-KDBX3") : QString("Argon2")) : QString("disabled");
+    result["iterations"] = iterations;
+    result["entries"] = entries;
+    result["fileSize"] = data.size();
+    result["saveMs"] = bestSave / 1e6;
+    result["loadMs"] = bestLoad / 1e6;
+    result["saveMBps"] = perSecond(megabytes, bestSave);
+    result["loadMBps"] = perSecond(megabytes, bestLoad);
+    result["saveEntriesPerSecond"] = perSecond(entries, bestSave);
+    result["loadEntriesPerSecond"] = perSecond(entries, bestLoad);
+    m_report.addResult(result);
+
+    qDebug("%s: save %.1f ms, load %.1f ms, %.2f MB",
+           QTest::currentDataTag(),
+           bestSave / 1e6,
+           bestLoad / 1e6,
+           megabytes);
+}
@@ -0,0 +1,52 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSX_TESTKDBXBENCHMARK_H
+#define KEEPASSX_TESTKDBXBENCHMARK_H
+
+#include "util/BenchmarkReport.h"
+
+#include <QObject>
+#include <QSharedPointer>
+
+class Database;
+
+/**
+ * Load and save benchmarks of KeePass2Reader and KeePass2Writer on synthetic databases.
+ *
+ * Skipped unless the BENCHMARK environment variable is set. The database size is
+ * configured with the BENCHMARK_* variables read by SyntheticDatabase::Parameters,
+ * results are written as JSON to BENCHMARK_OUTPUT (default: kdbx-benchmark.json).
+ */
+class TestKdbxBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void testSyntheticDatabase();
+    void benchmarkReadWrite_data();
+    void benchmarkReadWrite();
+
+private:
+    bool m_enabled = false;
+    QSharedPointer<Database> m_db;
+    BenchmarkReport m_report{QString("kdbx")};
+};
+
+#endif // KEEPASSX_TESTKDBXBENCHMARK_H
@@ -23,6 +23,7 @@
 #include "crypto/Crypto.h"
 #include "format/KdbxXmlReader.h"
 #include "keys/PasswordKey.h"
+#include "totp/totp.h"
 
 #include "FailDevice.h"
 #include "config-keepassx-tests.h"
@@ -637,3 +638,133 @@ void TestKeePass2Format::testDuplicateAttachments()
     QCOMPARE(db->rootGroup()->entries()[2]->attachments()->value("c2"), attachment2);
     QCOMPARE(db->rootGroup()->entries()[2]->attachments()->value("c3"), attachment3);
 }
+
+void TestKeePass2Format::testKdbxTotpSettings()
+{
+    auto db = QSharedPointer<Database>::create();
+    db->setKey(QSharedPointer<CompositeKey>::create());
+
+    auto entry = new Entry();
+    entry->setGroup(db->rootGroup());
+    entry->setUuid(QUuid::createUuid());
+    entry->attributes()->set("otp", "otpauth://totp/test?secret=GEZDGNBVGY3TQOJQ&digits=8", true);
+    entry->beginUpdate();
+    entry->attributes()->set("otp", "otpauth://totp/test?secret=GEZDGNBVGY3TQOJQ&digits=6", true);
+    entry->endUpdate();
+
+    QBuffer buffer;
+    buffer.open(QBuffer::ReadWrite);
+
+    bool hasError = false;
+    QString errorString;
+    writeKdbx(&buffer, db.data(), hasError, errorString);
+    if (hasError) {
+        QFAIL(qPrintable(QString("Error while writing database: %1").arg(errorString)));
+    }
+
+    buffer.seek(0);
+    readKdbx(&buffer, QSharedPointer<CompositeKey>::create(), db, hasError, errorString);
+    if (hasError) {
+        QFAIL(qPrintable(QString("Error while reading database: %1").arg(errorString)));
+    }
+
+    // the reader blocks the entry signals, TOTP settings must still be parsed
+    Entry* readEntry = db->rootGroup()->entries().at(0);
+    QVERIFY(readEntry->hasTotp());
+    QCOMPARE(readEntry->totpSettings()->digits, 6u);
+    QCOMPARE(readEntry->historyItems().size(), 1);
+    QVERIFY(readEntry->historyItems().at(0)->hasTotp());
+    QCOMPARE(readEntry->historyItems().at(0)->totpSettings()->digits, 8u);
+}
+
+/**
+ * Protected values of every base64 padding length and an attachment larger than the write buffer.
+ */
+void TestKeePass2Format::testKdbxProtectedValueLengths()
+{
+    auto db = QSharedPointer<Database>::create();
+    db->setKey(QSharedPointer<CompositeKey>::create());
+
+    auto entry = new Entry();
+    entry->setGroup(db->rootGroup());
+    entry->setUuid(QUuid::createUuid());
+    for (int length = 0; length < 6; ++length) {
+        entry->attributes()->set(QString("Protected%1").arg(length), QString(length, QLatin1Char('x')), true);
+    }
+    entry->attributes()->set("ProtectedUtf8", QString::fromUtf8("\xc3\xa4\xe9\x9b\xbb"), true);
+    const QByteArray attachment(3 * 1024 * 1024 + 1, 'A');
+    entry->attachments()->set("large.bin", attachment);
+
+    QBuffer buffer;
+    buffer.open(QBuffer::ReadWrite);
+
+    bool hasError = false;
+    QString errorString;
+    writeKdbx(&buffer, db.data(), hasError, errorString);
+    if (hasError) {
+        QFAIL(qPrintable(QString("Error while writing database: %1").arg(errorString)));
+    }
+
+    buffer.seek(0);
+    auto readDb = QSharedPointer<Database>::create();
+    readKdbx(&buffer, QSharedPointer<CompositeKey>::create(), readDb, hasError, errorString);
+    if (hasError) {
+        QFAIL(qPrintable(QString("Error while reading database: %1").arg(errorString)));
+    }
+
+    Entry* readEntry = readDb->rootGroup()->entries().at(0);
+    for (int length = 0; length < 6; ++length) {
+        QCOMPARE(readEntry->attributes()->value(QString("Protected%1").arg(length)), QString(length, QLatin1Char('x')));
+    }
+    QCOMPARE(readEntry->attributes()->value("ProtectedUtf8"), QString::fromUtf8("\xc3\xa4\xe9\x9b\xbb"));
+    QCOMPARE(readEntry->attachments()->value("large.bin"), attachment);
+}
+
+void TestKeePass2Format::testKdbxCustomIconData()
+{
+    auto db = QSharedPointer<Database>::create();
+    db->setKey(QSharedPointer<CompositeKey>::create());
+
+    // Store a BMP, custom icons must be written as they were read instead of being converted to PNG
+    QImage image(16, 16, QImage::Format_RGB32);
+    image.fill(qRgb(1, 2, 3));
+    QByteArray iconData;
+    QBuffer iconBuffer(&iconData);
+    iconBuffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&iconBuffer, "BMP"));
+
+    const QUuid uuid = QUuid::createUuid();
+    db->metadata()->addCustomIcon(uuid, iconData);
+    QCOMPARE(db->metadata()->findCustomIcon(iconData), uuid);
+
+    QBuffer buffer;
+    buffer.open(QBuffer::ReadWrite);
+
+    bool hasError = false;
+    QString errorString;
+    writeKdbx(&buffer, db.data(), hasError, errorString);
+    if (hasError) {
+        QFAIL(qPrintable(QString("Error while writing database: %1").arg(errorString)));
+    }
+
+    buffer.seek(0);
+    auto readDb = QSharedPointer<Database>::create();
+    readKdbx(&buffer, QSharedPointer<CompositeKey>::create(), readDb, hasError, errorString);
+    if (hasError) {
+        QFAIL(qPrintable(QString("Error while reading database: %1").arg(errorString)));
+    }
+
+    Metadata* metadata = readDb->metadata();
+    QVERIFY(metadata->containsCustomIcon(uuid));
+    QCOMPARE(metadata->customIconData(uuid), iconData);
+    QCOMPARE(metadata->findCustomIcon(iconData), uuid);
+    QCOMPARE(metadata->customIcon(uuid).pixel(0, 0), qRgb(1, 2, 3));
+
+    // Images that cannot be encoded are neither added nor found
+    const QUuid nullUuid = QUuid::createUuid();
+    QTest::ignoreMessage(QtWarningMsg, "Unable to encode a custom icon as PNG");
+    metadata->addCustomIcon(nullUuid, QImage());
+    QVERIFY(!metadata->containsCustomIcon(nullUuid));
+    QTest::ignoreMessage(QtWarningMsg, "Unable to encode a custom icon as PNG");
+    QVERIFY(metadata->findCustomIcon(QImage()).isNull());
+}
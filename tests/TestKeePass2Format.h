@@ -63,6 +63,9 @@ private slots:
     void testKdbxNonAsciiPasswords();
     void testKdbxDeviceFailure();
     void testDuplicateAttachments();
+    void testKdbxTotpSettings();
+    void testKdbxProtectedValueLengths();
+    void testKdbxCustomIconData();
 
 protected:
     virtual void initTestCaseImpl() = 0;
@@ -0,0 +1,132 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestParallelGzipStream.h"
+#include "TestGlobal.h"
+
+#include <QBuffer>
+#include <QThread>
+
+#include "FailDevice.h"
+#include "core/Endian.h"
+#include "core/Tools.h"
+#include "streams/ParallelGzipStream.h"
+#include "streams/QtIOCompressor"
+
+QTEST_GUILESS_MAIN(TestParallelGzipStream)
+
+namespace
+{
+    const int ChunkSize = 32 * 1024;
+
+    QByteArray textData(int size)
+    {
+        QByteArray data;
+        for (int i = 0; data.size() < size; ++i) {
+            data.append(QString("<Entry><Title>Entry %1</Title></Entry>\n").arg(i).toLatin1());
+        }
+        return data.left(size);
+    }
+
+    QByteArray noiseData(int size)
+    {
+        // xorshift keeps the data reproducible and incompressible
+        QByteArray data(size, '\0');
+        quint32 state = 2463534242u;
+        for (int i = 0; i < size; ++i) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            data[i] = static_cast<char>(state & 0xFF);
+        }
+        return data;
+    }
+} // namespace
+
+void TestParallelGzipStream::testWriteRead_data()
+{
+    QTest::addColumn<QByteArray>("data");
+
+    // more than one batch, so the compression of a batch overlaps with filling the next
+    const int batches = 2 * ChunkSize * qMax(1, QThread::idealThreadCount()) + 17;
+
+    QTest::newRow("one byte") << QByteArray("x");
+    QTest::newRow("below chunk") << textData(ChunkSize - 1);
+    QTest::newRow("one chunk") << textData(ChunkSize);
+    QTest::newRow("above chunk") << textData(ChunkSize + 1);
+    QTest::newRow("text batches") << textData(batches);
+    QTest::newRow("noise batches") << noiseData(batches);
+}
+
+void TestParallelGzipStream::testWriteRead()
+{
+    QFETCH(QByteArray, data);
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+
+    ParallelGzipStream writer(&buffer, 6, ChunkSize);
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+
+    // write in uneven pieces to cross the chunk boundaries
+    for (int offset = 0; offset < data.size(); offset += 1000) {
+        const QByteArray piece = data.mid(offset, 1000);
+        QCOMPARE(writer.write(piece), qint64(piece.size()));
+    }
+    QVERIFY(writer.reset());
+
+    const QByteArray compressed = buffer.data();
+    QVERIFY(compressed.startsWith(QByteArray::fromHex("1f8b08")));
+    QCOMPARE(Endian::bytesToSizedInt<quint32>(compressed.right(4), QSysInfo::LittleEndian),
+             static_cast<quint32>(data.size()));
+
+    buffer.reset();
+    QtIOCompressor reader(&buffer);
+    reader.setStreamFormat(QtIOCompressor::GzipFormat);
+    QVERIFY(reader.open(QIODevice::ReadOnly));
+
+    QByteArray result;
+    QVERIFY(Tools::readAllFromDevice(&reader, result));
+    QCOMPARE(result.size(), data.size());
+    QVERIFY(result == data);
+}
+
+void TestParallelGzipStream::testNothingWritten()
+{
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+
+    ParallelGzipStream writer(&buffer);
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+    QVERIFY(writer.reset());
+    writer.close();
+
+    QVERIFY(buffer.data().isEmpty());
+}
+
+void TestParallelGzipStream::testWriteFailure()
+{
+    FailDevice failDevice(1500);
+    QVERIFY(failDevice.open(QIODevice::WriteOnly));
+
+    ParallelGzipStream writer(&failDevice, 6, ChunkSize);
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+
+    writer.write(noiseData(4 * ChunkSize));
+    QVERIFY(!writer.reset());
+    QCOMPARE(writer.errorString(), QString("FAILDEVICE"));
+}
@@ -0,0 +1,402 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestSearchBenchmark.h"
+#include "TestGlobal.h"
+
+#include "autotype/AutoType.h"
+#include "config-keepassx.h"
+#include "core/Config.h"
+#include "core/CustomData.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/EntrySearcher.h"
+#include "core/Group.h"
+#include "core/Metadata.h"
+#include "crypto/Crypto.h"
+#include "gui/entry/EntryModel.h"
+#include "keys/PasswordKey.h"
+#include "util/SyntheticDatabase.h"
+#ifdef WITH_XC_BROWSER
+#include "browser/BrowserDatabaseView.h"
+#include "browser/BrowserService.h"
+#endif
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+
+#include <algorithm>
+
+QTEST_GUILESS_MAIN(TestSearchBenchmark)
+
+namespace
+{
+    // Size of the row that benchmarks the database given in BENCHMARK_DATABASE
+    const int LoadedDatabase = 0;
+
+    template <typename Func> void measure(QVector<qint64>& samples, Func func)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        func();
+        samples.append(timer.nsecsElapsed());
+    }
+
+    double percentile(const QVector<qint64>& sorted, double p)
+    {
+        if (sorted.isEmpty()) {
+            return 0.0;
+        }
+        const int index = qBound(0, static_cast<int>(p * sorted.size() + 0.5) - 1, sorted.size() - 1);
+        return sorted.at(index) / 1e6;
+    }
+
+    /**
+     * Pick count entries spread evenly over the whole database, so every
+     * benchmark queries the same entries regardless of the database size.
+     */
+    QList<Entry*> sampleEntries(const QSharedPointer<Database>& db, int count)
+    {
+        const QList<Entry*> entries = db->rootGroup()->entriesRecursive();
+        QList<Entry*> samples;
+        if (entries.isEmpty()) {
+            return samples;
+        }
+        for (int i = 0; i < count; ++i) {
+            samples.append(entries.at(static_cast<int>(static_cast<qint64>(i) * entries.size() / count)));
+        }
+        return samples;
+    }
+} // namespace
+
+void TestSearchBenchmark::initTestCase()
+{
+    QVERIFY(Crypto::init());
+    Config::createTempFileInstance();
+    config()->set("AutoTypeEntryTitleMatch", true);
+    config()->set("AutoTypeEntryURLMatch", true);
+    AutoType::createTestInstance();
+
+    m_enabled = BenchmarkReport::isEnabled();
+
+    const int repeat = qEnvironmentVariableIntValue("BENCHMARK_REPEAT");
+    if (repeat > 0) {
+        m_repeat = repeat;
+    }
+
+    const QString budgetFile = QString::fromLocal8Bit(qgetenv("BENCHMARK_BUDGETS"));
+    if (m_enabled && !budgetFile.isEmpty()) {
+        QFile file(budgetFile);
+        QVERIFY2(file.open(QIODevice::ReadOnly), qPrintable(file.errorString()));
+        QJsonParseError error;
+        m_budgets = QJsonDocument::fromJson(file.readAll(), &error).object();
+        QVERIFY2(error.error == QJsonParseError::NoError, qPrintable(error.errorString()));
+    }
+}
+
+void TestSearchBenchmark::cleanupTestCase()
+{
+    m_report.setValue("repeat", m_repeat);
+    QString error;
+    QVERIFY2(m_report.write(&error), qPrintable(error));
+}
+
+void TestSearchBenchmark::addSizeRows()
+{
+    QTest::addColumn<int>("size");
+
+    if (!qEnvironmentVariableIsEmpty("BENCHMARK_DATABASE")) {
+        QTest::newRow("file") << LoadedDatabase;
+        return;
+    }
+
+    QString sizes = QString::fromLocal8Bit(qgetenv("BENCHMARK_SIZES"));
+    if (sizes.isEmpty()) {
+        sizes = "1000,10000,100000";
+    }
+    for (const QString& size : sizes.split(',', QString::SkipEmptyParts)) {
+        QTest::newRow(qPrintable(size.trimmed())) << size.toInt();
+    }
+}
+
+QSharedPointer<Database> TestSearchBenchmark::database(int size)
+{
+    if (m_databases.contains(size)) {
+        return m_databases.value(size);
+    }
+
+    QSharedPointer<Database> db;
+    if (size == LoadedDatabase) {
+        auto key = QSharedPointer<CompositeKey>::create();
+        key->addKey(QSharedPointer<PasswordKey>::create(QString::fromLocal8Bit(qgetenv("BENCHMARK_PASSWORD"))));
+        db = QSharedPointer<Database>::create();
+        QString error;
+        if (!db->open(QString::fromLocal8Bit(qgetenv("BENCHMARK_DATABASE")), key, &error, true)) {
+            qWarning("Unable to open benchmark database: %s", qPrintable(error));
+            return {};
+        }
+    } else {
+        SyntheticDatabase::Parameters parameters = SyntheticDatabase::Parameters::fromEnvironment();
+        parameters.entries = size;
+        parameters.groups = qMax(1, size / 100);
+        // Only the current state of entries is searched, history would only slow down the generation
+        parameters.historyDepth = 0;
+        db = SyntheticDatabase(parameters).generate();
+
+        // Give some entries window associations, plain and regular expression ones
+        const QList<Entry*> entries = db->rootGroup()->entriesRecursive();
+        for (int i = 0; i < entries.size(); i += 10) {
+            AutoTypeAssociations::Association association;
+            association.window =
+                (i % 50 == 0) ? QString("//^Entry %1 .*$//").arg(i) : QString("*%1.example.com*").arg(i);
+            entries.at(i)->autoTypeAssociations()->add(association);
+        }
+    }
+
+    m_databases.insert(size, db);
+    return db;
+}
+
+/**
+ * Record the latency percentiles of a benchmark row and compare them against
+ * the budget configured for "<function>-<row>" in the BENCHMARK_BUDGETS file.
+ */
+void TestSearchBenchmark::report(const QString& name, const QSharedPointer<Database>& db, QVector<qint64> samples)
+{
+    std::sort(samples.begin(), samples.end());
+
+    const QString id = QString("%1-%2").arg(name, QTest::currentDataTag());
+    QJsonObject result;
+    result["name"] = id;
+    result["entries"] = db->rootGroup()->entriesRecursive().size();
+    result["samples"] = samples.size();
+    result["p50Ms"] = percentile(samples, 0.50);
+    result["p90Ms"] = percentile(samples, 0.90);
+    result["p99Ms"] = percentile(samples, 0.99);
+    result["maxMs"] = percentile(samples, 1.0);
+    m_report.addResult(result);
+
+    qDebug("%s: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms",
+           qPrintable(id),
+           result["p50Ms"].toDouble(),
+           result["p90Ms"].toDouble(),
+           result["p99Ms"].toDouble(),
+           result["maxMs"].toDouble());
+
+    const QJsonObject budget = m_budgets.value(id).toObject();
+    for (const QString& key : budget.keys()) {
+        const double limit = budget.value(key).toDouble();
+        QVERIFY2(!result.contains(key) || result.value(key).toDouble() <= limit,
+                 qPrintable(QString("%1 %2 of %3 ms exceeds the budget of %4 ms")
+                                .arg(id, key)
+                                .arg(result.value(key).toDouble())
+                                .arg(limit)));
+    }
+}
+
+void TestSearchBenchmark::benchmarkEntrySearcher_data()
+{
+    addSizeRows();
+}
+
+void TestSearchBenchmark::benchmarkEntrySearcher()
+{
+    if (!m_enabled) {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    QFETCH(int, size);
+    auto db = database(size);
+    QVERIFY(db);
+
+    QStringList queries({"entry", "example", "Entry 42", "user:ab", "url:example.com/login", "-notes:x title:entry"});
+    for (const Entry* entry : sampleEntries(db, 10)) {
+        queries << entry->title() << QString("url:%1").arg(entry->url());
+    }
+
+    EntrySearcher searcher;
+    QVector<qint64> samples;
+    for (int i = 0; i < m_repeat; ++i) {
+        for (const QString& query : asConst(queries)) {
+            measure(samples, [&] { searcher.search(query, db->rootGroup()); });
+        }
+    }
+
+    report("entrysearcher", db, samples);
+}
+
+void TestSearchBenchmark::benchmarkEntryModel_data()
+{
+    addSizeRows();
+}
+
+void TestSearchBenchmark::benchmarkEntryModel()
+{
+    if (!m_enabled) {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    QFETCH(int, size);
+    auto db = database(size);
+    QVERIFY(db);
+
+    EntrySearcher searcher;
+    const QList<Entry*> results = searcher.search("entry", db->rootGroup());
+    QList<Group*> groups = db->rootGroup()->groupsRecursive(true);
+    std::sort(groups.begin(), groups.end(), [](const Group* lhs, const Group* rhs) {
+        return lhs->entries().size() > rhs->entries().size();
+    });
+
+    // Filling the model and rendering the first screen of rows is what the user waits for
+    EntryModel model;
+    auto fillAndRead = [&model]() {
+        const int rows = qMin(model.rowCount(), 50);
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < model.columnCount(); ++column) {
+                model.data(model.index(row, column), Qt::DisplayRole);
+            }
+        }
+    };
+
+    QVector<qint64> samples;
+    for (int i = 0; i < m_repeat; ++i) {
+        measure(samples, [&] {
+            model.setEntries(results);
+            fillAndRead();
+        });
+        measure(samples, [&] {
+            model.setGroup(groups.first());
+            fillAndRead();
+        });
+    }
+
+    report("entrymodel", db, samples);
+}
+
+void TestSearchBenchmark::benchmarkBrowserSearch_data()
+{
+    addSizeRows();
+}
+
+void TestSearchBenchmark::benchmarkBrowserSearch()
+{
+#ifdef WITH_XC_BROWSER
+    if (!m_enabled) {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    QFETCH(int, size);
+    auto db = database(size);
+    QVERIFY(db);
+
+    QStringList urls({"https://unknown.example.org/", "https://example.com/"});
+    for (const Entry* entry : sampleEntries(db, 20)) {
+        urls << entry->url();
+    }
+
+    // Answer requests the way a connected browser is answered, through a snapshot of the database
+    db->metadata()->customData()->set(BrowserService::ASSOCIATE_KEY_PREFIX + "benchmark", "benchmark");
+    StringPairList keyList;
+    keyList << qMakePair(QString("benchmark"), QString("benchmark"));
+    BrowserService::Snapshot snapshot;
+    snapshot.searchDatabases << QSharedPointer<const BrowserDatabaseView>(new BrowserDatabaseView(db));
+
+    BrowserService service(nullptr);
+    QVector<qint64> samples;
+    for (int i = 0; i < m_repeat; ++i) {
+        for (const QString& url : asConst(urls)) {
+            measure(samples, [&] { service.searchEntries(snapshot, url, keyList); });
+        }
+    }
+
+    report("browser", db, samples);
+#else
+    QSKIP("Browser integration is not enabled in this build.");
+#endif
+}
+
+void TestSearchBenchmark::benchmarkAutoTypeMatch_data()
+{
+    addSizeRows();
+}
+
+void TestSearchBenchmark::benchmarkAutoTypeMatch()
+{
+    if (!m_enabled) {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    QFETCH(int, size);
+    auto db = database(size);
+    QVERIFY(db);
+
+    QStringList titles({"Untitled - Notepad", "Inbox - Mail"});
+    for (const Entry* entry : sampleEntries(db, 5)) {
+        titles << QString("%1 - Mozilla Firefox").arg(entry->title()) << QString("%1 - Chromium").arg(entry->url());
+    }
+
+    // The same loop over all entries that global Auto-Type performs for the active window
+    AutoType* autoType = AutoType::instance();
+    const QList<Entry*> entries = db->rootGroup()->entriesRecursive();
+    QVector<qint64> samples;
+    for (int i = 0; i < m_repeat; ++i) {
+        for (const QString& title : asConst(titles)) {
+            measure(samples, [&] {
+                for (const Entry* entry : entries) {
+                    autoType->autoTypeSequences(entry, title);
+                }
+            });
+        }
+    }
+
+    report("autotype", db, samples);
+}
+
+void TestSearchBenchmark::benchmarkPlaceholders_data()
+{
+    addSizeRows();
+}
+
+void TestSearchBenchmark::benchmarkPlaceholders()
+{
+    if (!m_enabled) {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    QFETCH(int, size);
+    auto db = database(size);
+    QVERIFY(db);
+
+    const QList<Entry*> entries = sampleEntries(db, 100);
+    QStringList templates;
+    for (int i = 0; i < entries.size(); ++i) {
+        const Entry* other = entries.at((i + 1) % entries.size());
+        templates << QString("{TITLE} {USERNAME} {URL:HOST} {URL:PATH} {PASSWORD} {NOTES} "
+                             "{REF:U@I:%1} {REF:P@I:%1} {REF:T@T:%2} {S:Secret 0}")
+                         .arg(other->uuidToHex().toUpper(), other->title());
+    }
+
+    QVector<qint64> samples;
+    for (int i = 0; i < m_repeat; ++i) {
+        for (int j = 0; j < entries.size(); ++j) {
+            measure(samples, [&] { entries.at(j)->resolveMultiplePlaceholders(templates.at(j)); });
+        }
+    }
+
+    report("placeholders", db, samples);
+}
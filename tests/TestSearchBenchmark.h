@@ -0,0 +1,72 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSX_TESTSEARCHBENCHMARK_H
+#define KEEPASSX_TESTSEARCHBENCHMARK_H
+
+#include "util/BenchmarkReport.h"
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QSharedPointer>
+#include <QVector>
+
+class Database;
+
+/**
+ * Per-query latency benchmarks of searching, entry models, browser URL matching,
+ * Auto-Type window matching and placeholder resolution.
+ *
+ * Skipped unless the BENCHMARK environment variable is set. Databases of
+ * BENCHMARK_SIZES entries (default: 1000,10000,100000) are generated, or the
+ * database in BENCHMARK_DATABASE is loaded with the password in BENCHMARK_PASSWORD.
+ * Latency percentiles are written as JSON to BENCHMARK_OUTPUT (default:
+ * search-benchmark.json). If BENCHMARK_BUDGETS names a JSON file of latency
+ * budgets, every row exceeding its budget fails.
+ */
+class TestSearchBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkEntrySearcher_data();
+    void benchmarkEntrySearcher();
+    void benchmarkEntryModel_data();
+    void benchmarkEntryModel();
+    void benchmarkBrowserSearch_data();
+    void benchmarkBrowserSearch();
+    void benchmarkAutoTypeMatch_data();
+    void benchmarkAutoTypeMatch();
+    void benchmarkPlaceholders_data();
+    void benchmarkPlaceholders();
+
+private:
+    void addSizeRows();
+    QSharedPointer<Database> database(int size);
+    void report(const QString& name, const QSharedPointer<Database>& db, QVector<qint64> samples);
+
+    bool m_enabled = false;
+    int m_repeat = 5;
+    QHash<int, QSharedPointer<Database>> m_databases;
+    QJsonObject m_budgets;
+    BenchmarkReport m_report{QString("search")};
+};
+
+#endif // KEEPASSX_TESTSEARCHBENCHMARK_H
@@ -21,17 +21,25 @@
 
 #include <QBuffer>
 #include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
+#include <QThread>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 
 #include "config-keepassx-tests.h"
+#include "config-keepassx.h"
+#include "core/Config.h"
 #include "core/Metadata.h"
 #include "crypto/Crypto.h"
 #include "crypto/Random.h"
 #include "crypto/ssh/OpenSSHKey.h"
 #include "format/KeePass2Writer.h"
+#include "keeshare/KeeShare.h"
 #include "keeshare/KeeShareSettings.h"
+#include "keeshare/ShareExport.h"
+#include "keeshare/ShareImport.h"
+#include "keeshare/ShareObserver.h"
 #include "keys/PasswordKey.h"
 
 #include <format/KeePass2Reader.h>
@@ -48,6 +56,8 @@ Q_DECLARE_METATYPE(QList<KeeShareSettings::ScopedCertificate>)
 void TestSharing::initTestCase()
 {
     QVERIFY(Crypto::init());
+    Config::createTempFileInstance();
+    KeeShare::init(this);
 }
 
 void TestSharing::cleanupTestCase()
@@ -317,3 +327,174 @@ const OpenSSHKey& TestSharing::stubkey(int index)
     }
     return *keys[index];
 }
+
+void TestSharing::testLoadUnsignedContainer()
+{
+#if !defined(WITH_XC_KEESHARE_INSECURE)
+    QSKIP("Unsigned share containers are not supported");
+#else
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("share.kdbx");
+
+    QScopedPointer<Database> db(new Database());
+    auto key = QSharedPointer<CompositeKey>::create();
+    key->addKey(QSharedPointer<PasswordKey>::create("password"));
+    db->setKey(key);
+    db->rootGroup()->setName("Shared");
+    KeePass2Writer writer;
+    QVERIFY(writer.writeDatabase(path, db.data()));
+
+    KeeShareSettings::Reference reference;
+    reference.type = KeeShareSettings::ImportFrom;
+    reference.path = "share.kdbx";
+    reference.password = "password";
+
+    const auto container = ShareImport::load(path, reference, KeeShareSettings::Foreign());
+    QVERIFY(!container.result.isValid());
+    QVERIFY(!container.digest.isEmpty());
+    QVERIFY(container.database);
+    QCOMPARE(container.database->rootGroup()->name(), QString("Shared"));
+    QCOMPARE(container.database->thread(), QThread::currentThread());
+
+    // an unchanged container is not decrypted again
+    const auto unchanged = ShareImport::load(path, reference, KeeShareSettings::Foreign(), container.digest);
+    QVERIFY(!unchanged.result.isValid());
+    QCOMPARE(unchanged.digest, container.digest);
+    QVERIFY(!unchanged.database);
+
+    reference.password = "wrong";
+    const auto failed = ShareImport::load(path, reference, KeeShareSettings::Foreign());
+    QVERIFY(failed.result.isError());
+    QVERIFY(!failed.database);
+
+    // an untrusted container is skipped without decrypting it, the wrong password is never tried
+    KeeShareSettings::Foreign foreign;
+    foreign.certificates << KeeShareSettings::ScopedCertificate{
+        reference.path, KeeShareSettings::Certificate(), KeeShareSettings::Trust::Untrusted};
+    const auto untrusted = ShareImport::load(path, reference, foreign);
+    QVERIFY(!untrusted.result.isValid());
+    QVERIFY(untrusted.digest.isEmpty());
+    QVERIFY(!untrusted.database);
+
+    // sources the user has not decided on yet are decrypted and asked for in apply()
+    foreign.certificates.first().trust = KeeShareSettings::Trust::Ask;
+    QVERIFY(ShareImport::load(path, reference, foreign).result.isError());
+#endif
+}
+
+void TestSharing::testExportAttachmentChange()
+{
+#if !defined(WITH_XC_KEESHARE_INSECURE)
+    QSKIP("Unsigned share containers are not supported");
+#else
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("export.kdbx");
+
+    QScopedPointer<Database> db(new Database());
+    auto* group = new Group();
+    group->setName("Shared");
+    group->setParent(db->rootGroup());
+    auto* entry = new Entry();
+    entry->setUuid(QUuid::createUuid());
+    entry->setGroup(group);
+    entry->attachments()->set("file.bin", QByteArray(64, 'a'));
+
+    KeeShareSettings::Reference reference;
+    reference.type = KeeShareSettings::ExportTo;
+    reference.path = "export.kdbx";
+    reference.password = "password";
+    const QList<ShareExport::Target> targets{{path, reference, group}};
+    QHash<QString, ShareObserver::ExportState> states;
+
+    auto readAttachment = [&]() {
+        auto key = QSharedPointer<CompositeKey>::create();
+        key->addKey(QSharedPointer<PasswordKey>::create("password"));
+        Database exported;
+        if (!exported.open(path, key, nullptr, true)) {
+            return QByteArray();
+        }
+        const auto entries = exported.rootGroup()->entriesRecursive(false);
+        return entries.isEmpty() ? QByteArray() : entries.first()->attachments()->value("file.bin");
+    };
+    auto readFile = [&]() {
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+
+    auto results = ShareExport::intoContainers(targets, states);
+    QCOMPARE(results.size(), 1);
+    QVERIFY(!results.first().isError() && !results.first().isWarning());
+    QCOMPARE(readAttachment(), QByteArray(64, 'a'));
+
+    // an unchanged share is not written again
+    const QByteArray written = readFile();
+    ShareExport::intoContainers(targets, states);
+    QCOMPARE(readFile(), written);
+
+    // changing only the bytes of an attachment keeps the XML but must export again
+    entry->attachments()->set("file.bin", QByteArray(64, 'b'));
+    results = ShareExport::intoContainers(targets, states);
+    QVERIFY(!results.first().isError() && !results.first().isWarning());
+    QVERIFY(readFile() != written);
+    QCOMPARE(readAttachment(), QByteArray(64, 'b'));
+#endif
+}
+
+void TestSharing::testObserverReferenceChanges()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    auto db = QSharedPointer<Database>::create();
+    db->setFilePath(dir.filePath("database.kdbx"));
+    Group* group = new Group();
+    group->setName("Shared");
+    group->setParent(db->rootGroup());
+
+    KeeShareSettings::Active active;
+    active.in = true;
+    KeeShare::setActive(active);
+
+    // The containers do not exist, every import reports a warning
+    ShareObserver observer(db);
+    int messages = 0;
+    connect(&observer, &ShareObserver::sharingMessage, [&messages]() { ++messages; });
+
+    KeeShareSettings::Reference reference;
+    reference.type = KeeShareSettings::ImportFrom;
+    reference.path = "missing.kdbx";
+    reference.password = "password";
+    KeeShare::setReferenceTo(group, reference);
+    QTRY_COMPARE(messages, 1);
+
+    // Changes that leave the cached reference as it is are ignored
+    group->setName("Renamed");
+    group->customData()->set("unrelated", "value");
+    KeeShare::setReferenceTo(group, reference);
+    Entry* entry = new Entry();
+    entry->setGroup(group);
+    QTest::qWait(200);
+    QCOMPARE(messages, 1);
+
+    // A changed reference is decoded and imported again
+    reference.password = "changed";
+    KeeShare::setReferenceTo(group, reference);
+    QTRY_COMPARE(messages, 2);
+
+    // Groups that join the database with a reference are imported
+    Group* added = new Group();
+    added->setName("Added");
+    reference.path = "other.kdbx";
+    KeeShare::setReferenceTo(added, reference);
+    added->setParent(db->rootGroup());
+    QTRY_COMPARE(messages, 3);
+
+    // Deactivating the sharing drops the cached references, all shares are imported once it is active again
+    KeeShare::setActive(KeeShareSettings::Active());
+    KeeShare::setActive(active);
+    QTRY_COMPARE(messages, 5);
+
+    KeeShare::setActive(KeeShareSettings::Active());
+}
@@ -39,6 +39,9 @@ private slots:
     void testReferenceSerialization_data();
     void testSettingsSerialization();
     void testSettingsSerialization_data();
+    void testLoadUnsignedContainer();
+    void testExportAttachmentChange();
+    void testObserverReferenceChanges();
 
 private:
     const OpenSSHKey& stubkey(int iIndex = 0);
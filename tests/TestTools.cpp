@@ -63,4 +63,9 @@ void TestTools::testIsBase64()
     QVERIFY(not Tools::isBase64(QByteArray("abcd123==")));
     QVERIFY(not Tools::isBase64(QByteArray("abc_")));
     QVERIFY(not Tools::isBase64(QByteArray("123")));
+    QVERIFY(Tools::isBase64(QByteArray("")));
+    QVERIFY(not Tools::isBase64(QByteArray("====")));
+    QVERIFY(not Tools::isBase64(QByteArray("a===")));
+    QVERIFY(not Tools::isBase64(QByteArray("ab=c")));
+    QVERIFY(not Tools::isBase64(QByteArray("ab\xe4c")));
 }
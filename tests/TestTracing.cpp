@@ -0,0 +1,153 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestTracing.h"
+#include "TestGlobal.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include "core/Database.h"
+#include "core/Group.h"
+#include "core/Tracing.h"
+#include "crypto/Crypto.h"
+
+QTEST_GUILESS_MAIN(TestTracing)
+
+namespace
+{
+    QJsonArray readTraceEvents(const QString& fileName)
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return {};
+        }
+        return QJsonDocument::fromJson(file.readAll()).object().value("traceEvents").toArray();
+    }
+} // namespace
+
+void TestTracing::initTestCase()
+{
+    QVERIFY(Crypto::init());
+}
+
+void TestTracing::testChromeTrace()
+{
+    int evaluated = 0;
+    auto name = [&evaluated](const QString& text) {
+        ++evaluated;
+        return text;
+    };
+
+    // Spans are neither recorded nor named until tracing is started
+    {
+        TRACE_SPAN(name("disabled"), "test");
+    }
+    QCOMPARE(evaluated, 0);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("trace.json");
+    Tracing::start(fileName);
+    QVERIFY(Tracing::isEnabled());
+
+    const QString innerName = QString("inner \"quoted\" \\ path\n") + QString::fromUtf8("\xc3\xa4");
+    {
+        TRACE_SPAN("outer", "test");
+        {
+            TRACE_SPAN(name(innerName), "test,escaping");
+            QThread::msleep(2);
+        }
+    }
+    QCOMPARE(evaluated, 1);
+
+    Tracing::finish();
+    QVERIFY(!Tracing::isEnabled());
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    const QJsonArray events = document.object().value("traceEvents").toArray();
+
+    QJsonObject outer;
+    QJsonObject inner;
+    int threadNames = 0;
+    for (const QJsonValue& value : events) {
+        const QJsonObject event = value.toObject();
+        if (event.value("ph").toString() == "M") {
+            ++threadNames;
+            QCOMPARE(event.value("args").toObject().value("name").toString(), QString("main"));
+            continue;
+        }
+        QCOMPARE(event.value("ph").toString(), QString("X"));
+        if (event.value("name").toString() == "outer") {
+            outer = event;
+        } else {
+            inner = event;
+        }
+    }
+    QCOMPARE(threadNames, 1);
+    QCOMPARE(events.size(), 3);
+
+    // Names are escaped, the viewer shows them as they were recorded
+    QCOMPARE(inner.value("name").toString(), innerName);
+    QCOMPARE(inner.value("cat").toString(), QString("test,escaping"));
+    QCOMPARE(outer.value("cat").toString(), QString("test"));
+
+    // Every span is a complete event, begin and end of the inner span lie within the outer one
+    const double outerStart = outer.value("ts").toDouble();
+    const double outerEnd = outerStart + outer.value("dur").toDouble();
+    const double innerStart = inner.value("ts").toDouble();
+    const double innerEnd = innerStart + inner.value("dur").toDouble();
+    QVERIFY(inner.value("dur").toDouble() >= 2000);
+    QVERIFY(outerStart <= innerStart);
+    QVERIFY(innerEnd <= outerEnd + 0.001);
+    QCOMPARE(inner.value("tid").toInt(), outer.value("tid").toInt());
+}
+
+void TestTracing::testGroupSpans()
+{
+    Database db;
+    Group* group = new Group();
+    for (int i = 0; i < 10; ++i) {
+        Group* child = new Group();
+        child->setParent(group);
+        (new Group())->setParent(child);
+    }
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("trace.json");
+    Tracing::start(fileName);
+    group->setParent(db.rootGroup());
+    Tracing::finish();
+
+    // Attaching a tree is a single span, not one per group
+    int spans = 0;
+    for (const QJsonValue& value : readTraceEvents(fileName)) {
+        if (value.toObject().value("name").toString() == "Group::connectDatabaseSignalsRecursive") {
+            ++spans;
+        }
+    }
+    QCOMPARE(spans, 1);
+}
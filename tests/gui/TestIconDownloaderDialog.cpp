@@ -0,0 +1,119 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestIconDownloaderDialog.h"
+
+#include "core/Config.h"
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "crypto/Crypto.h"
+#include "gui/IconDownloaderDialog.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+
+QTEST_MAIN(TestIconDownloaderDialog)
+
+namespace
+{
+    const int HostCount = 10;
+    const int MaxConcurrentDownloads = 8;
+
+    void respond(QTcpSocket* socket, const QByteArray& status, const QByteArray& body = QByteArray())
+    {
+        socket->write("HTTP/1.1 " + status + "\r\nContent-Length: " + QByteArray::number(body.size())
+                      + "\r\nConnection: close\r\n\r\n" + body);
+        socket->disconnectFromHost();
+    }
+} // namespace
+
+void TestIconDownloaderDialog::initTestCase()
+{
+    QVERIFY(Crypto::init());
+    Config::createTempFileInstance();
+    config()->set("security/IconDownloadFallback", false);
+    config()->set("security/IconDownloadCache", false);
+}
+
+void TestIconDownloaderDialog::testConcurrencyLimit()
+{
+    QImage image(16, 16, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    QByteArray png;
+    QBuffer buffer(&png);
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QVERIFY(image.save(&buffer, "PNG"));
+
+    // Every server is a host of its own, its download is held open until it is answered
+    QObject servers;
+    QList<QTcpSocket*> pending;
+    int connections = 0;
+    int maxPending = 0;
+    auto db = QSharedPointer<Database>::create();
+    QHash<quint16, Entry*> portToEntry;
+    for (int i = 0; i < HostCount; ++i) {
+        auto server = new QTcpServer(&servers);
+        QVERIFY(server->listen(QHostAddress::LocalHost));
+        QObject::connect(server, &QTcpServer::newConnection, [&, server]() {
+            while (server->hasPendingConnections()) {
+                pending << server->nextPendingConnection();
+                ++connections;
+                maxPending = qMax(maxPending, pending.size());
+            }
+        });
+
+        auto entry = new Entry();
+        entry->setGroup(db->rootGroup());
+        entry->setUrl(QString("http://127.0.0.1:%1").arg(server->serverPort()));
+        portToEntry.insert(server->serverPort(), entry);
+    }
+
+    QScopedPointer<IconDownloaderDialog> dialog(new IconDownloaderDialog());
+    dialog->downloadFavicons(db, db->rootGroup()->entries());
+
+    // The other hosts stay queued while the maximum number of downloads is running
+    QTRY_COMPARE(connections, MaxConcurrentDownloads);
+    QTest::qWait(500);
+    QCOMPARE(connections, MaxConcurrentDownloads);
+
+    // A failed download finishes and frees its slot for a queued host
+    QTcpSocket* socket = pending.takeFirst();
+    QTRY_VERIFY(socket->bytesAvailable() > 0);
+    const quint16 failedPort = socket->localPort();
+    respond(socket, "404 Not Found");
+    QTRY_COMPARE(connections, MaxConcurrentDownloads + 1);
+
+    for (int answered = 1; answered < HostCount; ++answered) {
+        QTRY_VERIFY(!pending.isEmpty());
+        socket = pending.takeFirst();
+        QTRY_VERIFY(socket->bytesAvailable() > 0);
+        respond(socket, "200 OK", png);
+    }
+
+    QCOMPARE(connections, HostCount);
+    QCOMPARE(maxPending, MaxConcurrentDownloads);
+    for (auto it = portToEntry.cbegin(); it != portToEntry.cend(); ++it) {
+        if (it.key() != failedPort) {
+            QTRY_VERIFY(!it.value()->iconUuid().isNull());
+        }
+    }
+    QVERIFY(portToEntry.value(failedPort)->iconUuid().isNull());
+}
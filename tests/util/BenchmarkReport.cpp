@@ -0,0 +1,78 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BenchmarkReport.h"
+
+#include <QFile>
+#include <QJsonDocument>
+
+BenchmarkReport::BenchmarkReport(const QString& name)
+    : m_name(name)
+{
+    m_report["benchmark"] = name;
+    m_report["qtVersion"] = QString(qVersion());
+}
+
+/**
+ * @return true unless the BENCHMARK environment variable is unset, "0" or "no"
+ */
+bool BenchmarkReport::isEnabled()
+{
+    const QByteArray env = qgetenv("BENCHMARK");
+    return !(env.isEmpty() || env == "0" || env == "no");
+}
+
+void BenchmarkReport::setValue(const QString& key, const QJsonValue& value)
+{
+    m_report[key] = value;
+}
+
+void BenchmarkReport::addResult(const QJsonObject& result)
+{
+    m_results.append(result);
+}
+
+/**
+ * Write the report, nothing is written if no results were added.
+ *
+ * @return false if the report file could not be written
+ */
+bool BenchmarkReport::write(QString* errorString) const
+{
+    if (m_results.isEmpty()) {
+        return true;
+    }
+
+    QString fileName = QString::fromLocal8Bit(qgetenv("BENCHMARK_OUTPUT"));
+    if (fileName.isEmpty()) {
+        fileName = QString("%1-benchmark.json").arg(m_name);
+    }
+
+    QJsonObject report = m_report;
+    report["results"] = m_results;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(QJsonDocument(report).toJson()) < 0) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+
+    qDebug("Benchmark results written to %s", qPrintable(fileName));
+    return true;
+}
@@ -0,0 +1,48 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_BENCHMARKREPORT_H
+#define KEEPASSXC_BENCHMARKREPORT_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+
+/**
+ * JSON report of a benchmark run, shared by the benchmark tests.
+ *
+ * Benchmarks only run if the BENCHMARK environment variable is set. The report
+ * is written to BENCHMARK_OUTPUT, or to <name>-benchmark.json by default.
+ */
+class BenchmarkReport
+{
+public:
+    explicit BenchmarkReport(const QString& name);
+
+    static bool isEnabled();
+
+    void setValue(const QString& key, const QJsonValue& value);
+    void addResult(const QJsonObject& result);
+    bool write(QString* errorString = nullptr) const;
+
+private:
+    QString m_name;
+    QJsonObject m_report;
+    QJsonArray m_results;
+};
+
+#endif // KEEPASSXC_BENCHMARKREPORT_H
@@ -0,0 +1,224 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SyntheticDatabase.h"
+
+#include "core/Database.h"
+#include "core/Entry.h"
+#include "core/Group.h"
+#include "core/Metadata.h"
+#include "core/Tools.h"
+
+namespace
+{
+    const QString Alphabet("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,-_!?");
+    // 2020-01-01T00:00:00Z, all generated timestamps lie within the following year
+    const qint64 BaseTime = 1577836800;
+    const int TimeRange = 365 * 24 * 3600;
+
+    int environmentValue(const char* name, int defaultValue)
+    {
+        bool ok = false;
+        const int value = qEnvironmentVariableIntValue(name, &ok);
+        return ok ? value : defaultValue;
+    }
+} // namespace
+
+QJsonObject SyntheticDatabase::Parameters::toJson() const
+{
+    QJsonObject json;
+    json["seed"] = static_cast<qint64>(seed);
+    json["groups"] = groups;
+    json["entries"] = entries;
+    json["historyDepth"] = historyDepth;
+    json["protectedAttributes"] = protectedAttributes;
+    json["attachmentInterval"] = attachmentInterval;
+    json["attachmentSize"] = attachmentSize;
+    json["referenceInterval"] = referenceInterval;
+    return json;
+}
+
+/**
+ * Read the parameters from BENCHMARK_* environment variables,
+ * falling back to the defaults for unset variables.
+ */
+SyntheticDatabase::Parameters SyntheticDatabase::Parameters::fromEnvironment()
+{
+    Parameters parameters;
+    parameters.seed = static_cast<quint32>(environmentValue("BENCHMARK_SEED", static_cast<int>(parameters.seed)));
+    parameters.groups = environmentValue("BENCHMARK_GROUPS", parameters.groups);
+    parameters.entries = environmentValue("BENCHMARK_ENTRIES", parameters.entries);
+    parameters.historyDepth = environmentValue("BENCHMARK_HISTORY", parameters.historyDepth);
+    parameters.protectedAttributes = environmentValue("BENCHMARK_PROTECTED", parameters.protectedAttributes);
+    parameters.attachmentInterval = environmentValue("BENCHMARK_ATTACHMENT_INTERVAL", parameters.attachmentInterval);
+    parameters.attachmentSize = environmentValue("BENCHMARK_ATTACHMENT_SIZE", parameters.attachmentSize);
+    parameters.referenceInterval = environmentValue("BENCHMARK_REFERENCE_INTERVAL", parameters.referenceInterval);
+    return parameters;
+}
+
+SyntheticDatabase::SyntheticDatabase(const Parameters& parameters)
+    : m_parameters(parameters)
+    , m_random(parameters.seed)
+{
+}
+
+/**
+ * Generate a new database. Every call restarts from the seed,
+ * so repeated calls return identical databases.
+ */
+QSharedPointer<Database> SyntheticDatabase::generate()
+{
+    m_random.seed(m_parameters.seed);
+
+    auto db = QSharedPointer<Database>::create();
+    db->metadata()->setName("Synthetic Database");
+    db->metadata()->setHistoryMaxItems(qMax(Metadata::DefaultHistoryMaxItems, m_parameters.historyDepth));
+    db->metadata()->setHistoryMaxSize(-1);
+    db->rootGroup()->setUuid(randomUuid());
+
+    QList<Group*> groups({db->rootGroup()});
+    for (int i = 0; i < m_parameters.groups; ++i) {
+        groups.append(createGroup(groups.at(randomInt(0, groups.size() - 1)), i));
+    }
+
+    QList<Entry*> entries;
+    for (int i = 0; i < m_parameters.entries; ++i) {
+        entries.append(createEntry(groups.at(randomInt(0, groups.size() - 1)), i));
+    }
+
+    if (m_parameters.referenceInterval > 0) {
+        for (int i = 0; i < entries.size(); i += m_parameters.referenceInterval) {
+            // Only reference entries that are no references themselves to avoid cycles
+            int target = randomInt(0, entries.size() - 1);
+            if (m_parameters.referenceInterval > 1 && target % m_parameters.referenceInterval == 0) {
+                target = target + 1 < entries.size() ? target + 1 : target - 1;
+            }
+            const Entry* targetEntry = entries.at(qMax(0, target));
+            entries.at(i)->setUsername(QString("{REF:U@I:%1}").arg(targetEntry->uuidToHex().toUpper()));
+        }
+    }
+
+    return db;
+}
+
+QUuid SyntheticDatabase::randomUuid()
+{
+    return QUuid::fromRfc4122(randomBytes(16));
+}
+
+QString SyntheticDatabase::randomString(int minLength, int maxLength)
+{
+    const int length = randomInt(minLength, maxLength);
+    QString string;
+    string.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        string.append(Alphabet.at(randomInt(0, Alphabet.size() - 1)));
+    }
+    return string;
+}
+
+QByteArray SyntheticDatabase::randomBytes(int size)
+{
+    QByteArray bytes(size, '\0');
+    for (int i = 0; i < size; ++i) {
+        bytes[i] = static_cast<char>(m_random() & 0xFF);
+    }
+    return bytes;
+}
+
+/**
+ * Uniform integer in [min, max]. The modulo bias is irrelevant for benchmark data,
+ * but unlike std::uniform_int_distribution the result is identical on every platform.
+ */
+int SyntheticDatabase::randomInt(int min, int max)
+{
+    if (max <= min) {
+        return min;
+    }
+    return min + static_cast<int>(m_random() % static_cast<quint32>(max - min + 1));
+}
+
+QDateTime SyntheticDatabase::randomTime()
+{
+    return QDateTime::fromMSecsSinceEpoch((BaseTime + randomInt(0, TimeRange)) * 1000, Qt::UTC);
+}
+
+Group* SyntheticDatabase::createGroup(Group* parent, int index)
+{
+    auto group = new Group();
+    group->setUpdateTimeinfo(false);
+    group->setUuid(randomUuid());
+    group->setName(QString("Group %1 %2").arg(index).arg(randomString(4, 16)));
+    group->setNotes(randomString(0, 64));
+    group->setIcon(randomInt(0, 68));
+
+    TimeInfo timeInfo;
+    timeInfo.setCreationTime(randomTime());
+    timeInfo.setLastModificationTime(timeInfo.creationTime());
+    timeInfo.setLastAccessTime(timeInfo.creationTime());
+    timeInfo.setLocationChanged(timeInfo.creationTime());
+    group->setTimeInfo(timeInfo);
+
+    group->setParent(parent);
+    return group;
+}
+
+Entry* SyntheticDatabase::createEntry(Group* group, int index)
+{
+    auto entry = new Entry();
+    entry->setUpdateTimeinfo(false);
+    entry->setUuid(randomUuid());
+    entry->setTitle(QString("Entry %1 %2").arg(index).arg(randomString(4, 24)));
+    entry->setUsername(randomString(4, 24));
+    entry->setPassword(randomString(12, 32));
+    entry->setUrl(QString("https://%1.example.com/login").arg(index));
+    entry->setNotes(randomString(0, 256));
+    entry->setIcon(randomInt(0, 68));
+
+    for (int i = 0; i < m_parameters.protectedAttributes; ++i) {
+        entry->attributes()->set(QString("Secret %1").arg(i), randomString(16, 64), true);
+    }
+
+    if (m_parameters.attachmentInterval > 0 && index % m_parameters.attachmentInterval == 0) {
+        entry->attachments()->set("attachment.bin", randomBytes(m_parameters.attachmentSize));
+    }
+
+    TimeInfo timeInfo;
+    timeInfo.setCreationTime(randomTime());
+    timeInfo.setLastModificationTime(timeInfo.creationTime());
+    timeInfo.setLastAccessTime(timeInfo.creationTime());
+    timeInfo.setLocationChanged(timeInfo.creationTime());
+    entry->setTimeInfo(timeInfo);
+
+    for (int revision = 1; revision <= m_parameters.historyDepth; ++revision) {
+        entry->addHistoryItem(entry->clone(Entry::CloneNoFlags));
+        reviseEntry(entry, revision);
+    }
+
+    entry->setGroup(group);
+    return entry;
+}
+
+void SyntheticDatabase::reviseEntry(Entry* entry, int revision)
+{
+    entry->setPassword(randomString(12, 32));
+    entry->setNotes(QString("Revision %1\n%2").arg(revision).arg(randomString(0, 256)));
+
+    TimeInfo timeInfo = entry->timeInfo();
+    timeInfo.setLastModificationTime(timeInfo.lastModificationTime().addSecs(randomInt(60, 30 * 24 * 3600)));
+    entry->setTimeInfo(timeInfo);
+}
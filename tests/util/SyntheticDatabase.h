@@ -0,0 +1,80 @@
+/*
+ *  Copyright (C) 2020 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_SYNTHETICDATABASE_H
+#define KEEPASSXC_SYNTHETICDATABASE_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QSharedPointer>
+#include <QUuid>
+
+#include <random>
+
+class Database;
+class Entry;
+class Group;
+
+/**
+ * Generates reproducible databases of arbitrary size for benchmarks.
+ *
+ * The same parameters (including the seed) always produce the same groups,
+ * entries, uuids, timestamps and contents, so results of different builds
+ * can be compared with each other.
+ */
+class SyntheticDatabase
+{
+public:
+    struct Parameters
+    {
+        quint32 seed = 1;
+        int groups = 100;
+        int entries = 10000;
+        // number of history items per entry
+        int historyDepth = 5;
+        // number of additional protected attributes per entry
+        int protectedAttributes = 2;
+        // every n-th entry gets an attachment, 0 disables attachments
+        int attachmentInterval = 10;
+        int attachmentSize = 4096;
+        // every n-th entry references the username of another entry, 0 disables references
+        int referenceInterval = 20;
+
+        QJsonObject toJson() const;
+        static Parameters fromEnvironment();
+    };
+
+    explicit SyntheticDatabase(const Parameters& parameters);
+
+    QSharedPointer<Database> generate();
+
+private:
+    QUuid randomUuid();
+    QString randomString(int minLength, int maxLength);
+    QByteArray randomBytes(int size);
+    int randomInt(int min, int max);
+    QDateTime randomTime();
+
+    Group* createGroup(Group* parent, int index);
+    Entry* createEntry(Group* group, int index);
+    void reviseEntry(Entry* entry, int revision);
+
+    const Parameters m_parameters;
+    std::mt19937 m_random;
+};
+
+#endif // KEEPASSXC_SYNTHETICDATABASE_H